@@ -0,0 +1,56 @@
+#ifndef BENCH_REPORT_H
+#define BENCH_REPORT_H
+
+#include <cstdint>
+#include <cstdio>
+
+// Machine-readable benchmark results next to the human-readable tables,
+// one line per measurement:
+//
+//   BENCH,<suite>,<name>,<unit>,<value>
+//
+// Every unit is lower-is-better: cyc (CPU cycles per operation, ESP32),
+// ns (host nanoseconds per operation), us and us_max (mean and worst
+// latency), B (bytes). tools/bench_compare.py picks these lines out of a
+// serial capture or a host run and checks them against a stored baseline.
+//
+// benchTicks() is the CPU cycle counter on target and a nanosecond clock on
+// the host, so the same kernel loops run in both places (BENCH_TICK_UNIT).
+//
+// benchHook, when set, also gets every result; the Unity tests under test/
+// collect them with it and compare against the committed baselines.
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include <Arduino.h>
+#define BENCH_TICK_UNIT "cyc"
+static inline uint32_t benchTicks() { return ESP.getCycleCount(); }
+#define BENCH_PRINTF(...) Serial.printf(__VA_ARGS__)
+#else
+#include <chrono>
+#define BENCH_TICK_UNIT "ns"
+static inline uint32_t benchTicks() {
+  return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+#define BENCH_PRINTF(...) printf(__VA_ARGS__)
+#endif
+
+typedef void (*BenchHook)(const char *suite, const char *name,
+                          const char *unit, double value);
+static BenchHook benchHook = nullptr;
+
+static inline void benchReport(const char *suite, const char *name,
+                               const char *unit, double value) {
+  BENCH_PRINTF("BENCH,%s,%s,%s,%.2f\n", suite, name, unit, value);
+  if (benchHook)
+    benchHook(suite, name, unit, value);
+}
+
+// ticks per operation in the native unit
+static inline void benchReportTicks(const char *suite, const char *name,
+                                    uint32_t ticks, uint32_t ops) {
+  benchReport(suite, name, BENCH_TICK_UNIT, (double)ticks / ops);
+}
+
+#endif // !BENCH_REPORT_H
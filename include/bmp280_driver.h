@@ -1,32 +1,63 @@
 #ifndef BMP280_DRIVER_H
 #define BMP280_DRIVER_H
 
+#include "debug_log.h"
+#include "fast_math.h"
 #include <Adafruit_BMP280.h>
 #include <Adafruit_Sensor.h>
 #include <Wire.h>
+#include <cmath>
 
 class BMP280_Driver {
 public:
-  bool begin(uint8_t i2c_addr = 0x76) { return bmp.begin(i2c_addr); }
+  BMP280_Driver() : _started(false) { setSeaLevel(fastmath::SEA_LEVEL_HPA); }
 
-  float returnPressure_hPa() { return bmp.readPressure() / 100.0F; }
+  bool begin(uint8_t i2c_addr = 0x76) {
+    _started = bmp.begin(i2c_addr);
+    return _started;
+  }
+
+  // NAN until begin() has succeeded (it is left for later on an in-flight
+  // resume, sensor_pipeline.h)
+  float returnPressure_hPa() {
+    return _started ? bmp.readPressure() / 100.0F : NAN;
+  }
 
-  float readTemperature_C() { return bmp.readTemperature(); }
+  float readTemperature_C() { return _started ? bmp.readTemperature() : NAN; }
 
-  float calculateAltitude(float seaLevel_hPa = 1013.25) {
-    return bmp.readAltitude(seaLevel_hPa);
+  float calculateAltitude(float seaLevel_hPa) {
+    return fastmath::baroAltitude(returnPressure_hPa(), seaLevel_hPa);
   }
 
+  // against the calibrated reference (setSeaLevel)
+  float calculateAltitude() { return altitudeAt(returnPressure_hPa()); }
+
+  // for a pressure already read; multiplies by the stored reciprocal
+  float altitudeAt(float pressure_hPa) const {
+    return fastmath::baroAltitudeRatio(pressure_hPa * _invSeaLevel);
+  }
+
+  // reference pressure from ground calibration (sensor_calibration.h)
+  void setSeaLevel(float seaLevel_hPa) {
+    _seaLevel = seaLevel_hPa;
+    _invSeaLevel = 1.0f / seaLevel_hPa;
+  }
+
+  float seaLevel() const { return _seaLevel; }
+
   void powerDown() {
     // BMP280 doesn't have explicit power down, but you can:
     // 1. Stop reading from it
     // 2. Set it to sleep mode if library supports it
     // For now, just document that we stop using it
-    Serial.println("Stop reading from BMP280");
+    DLOG_INFO("Stop reading from BMP280");
   }
 
 private:
   Adafruit_BMP280 bmp;
+  bool _started;
+  float _seaLevel;
+  float _invSeaLevel;
 };
 
 #endif // !BMP280_DRIVER.
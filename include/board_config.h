@@ -0,0 +1,94 @@
+#ifndef BOARD_CONFIG_H
+#define BOARD_CONFIG_H
+
+#include "buzzer_driver.h"
+#include "lora_driver.h"
+#include "sdcard_driver.h"
+#include "sensor_pipeline.h"
+#include <cstdint>
+
+// Board variants. Each config type names its drivers (NoSensor for a part
+// that isn't fitted), its radio and SD card, their read periods (0 = every
+// pass) and its pins;
+// a variant derives from the board it changes. Pick one with
+// -DBOARD_CONFIG=<type>.
+
+// payload v0: every sensor fitted
+struct PayloadV0 {
+  typedef BMP280_Driver Baro;
+  typedef DHT11_Driver Env;
+  typedef MPU6050_Driver Imu;
+  typedef Compass_Driver Mag;
+  typedef GPS_Driver Gps;
+  typedef LoRaDriver Radio;
+  typedef SDCard_Driver Storage;
+
+  static const uint32_t BARO_PERIOD_MS = 0;
+  static const uint32_t ENV_PERIOD_MS = 2000; // DHT11 updates every 2 s
+  static const uint32_t IMU_PERIOD_MS = 0;
+  static const uint32_t MAG_PERIOD_MS = 0;
+  static const uint32_t GPS_PERIOD_MS = 0;
+
+  static const uint8_t SD_CS = 5;
+  static const uint8_t LORA_CS = 17;
+  static const uint8_t LORA_RST = 16;
+  static const uint8_t LORA_DIO0 = 14;
+  static const long LORA_FREQUENCY = 433000000;
+  static const uint8_t BUZZER_PIN = 27;
+  static const uint8_t GPS_RX = 13;
+  static const uint8_t GPS_TX = 15;
+  static const uint32_t GPS_BAUD = 115200;
+  static const uint8_t GPS_PPS = 34;
+  static const uint8_t I2C_SDA = 21;
+  static const uint8_t I2C_SCL = 22;
+};
+
+// payload v0 without the DHT11
+struct PayloadV0NoDht : PayloadV0 {
+  typedef NoSensor Env;
+};
+
+// payload v0 on a WROVER module: GPIO16/17 drive the PSRAM, so the LoRa
+// reset and chip select move
+struct PayloadV0Wrover : PayloadV0 {
+  static const uint8_t LORA_CS = 25;
+  static const uint8_t LORA_RST = 26;
+};
+
+#ifdef PIPELINE_BENCHMARK
+#include "mock_sensors.h"
+
+// payload v0 with mocked sensors, radio and SD card, for timing the state
+// machine pass (esp32dev_pipeline_bench)
+struct MockBoard : PayloadV0 {
+  typedef MockBaro Baro;
+  typedef MockEnv Env;
+  typedef MockImu Imu;
+  typedef MockMag Mag;
+  typedef MockGps Gps;
+  typedef MockRadio Radio;
+  typedef MockStorage Storage;
+};
+#endif
+
+#ifndef BOARD_CONFIG
+#define BOARD_CONFIG PayloadV0
+#endif
+typedef BOARD_CONFIG Board;
+
+// every driver on the board; the one instance lives in main.cpp
+struct Payload {
+  Payload()
+      : buzzer(Board::BUZZER_PIN), sdcard(Board::SD_CS),
+        lora(Board::LORA_CS, Board::LORA_RST, Board::LORA_DIO0,
+             Board::LORA_FREQUENCY) {}
+
+  SensorPipeline<Board> sensors;
+  Buzzer_Driver buzzer;
+  Board::Storage sdcard;
+  Board::Radio lora;
+};
+
+extern Payload payload;
+
+#endif // !BOARD_CONFIG_H
@@ -1,26 +1,157 @@
 #ifndef BUZZER_DRIVER_H
 #define BUZZER_DRIVER_H
 
+#include "tone_pattern.h"
 #include <Arduino.h>
 #include <cstdint>
+#include <cstring>
+#include <esp_timer.h>
 
+// Plays tone patterns without blocking: the LEDC peripheral generates the
+// square wave and a one-shot esp_timer moves to the next step. Only the
+// timer callback touches the LEDC channel; play() and stop() hand it the
+// new pattern under a lock and fire the timer at once.
 class Buzzer_Driver {
 public:
-  Buzzer_Driver(uint8_t pin) : buzzerPin(pin) { pinMode(buzzerPin, OUTPUT); }
+  // channel 0 is the one the Arduino tone() helper grabs
+  Buzzer_Driver(uint8_t pin, uint8_t ledcChannel = 2)
+      : buzzerPin(pin), channel(ledcChannel), timer(nullptr), active(0),
+        step(0), playing(false), pendingPlay(false), pendingStop(false),
+        currentFreq(0) {
+    pinMode(buzzerPin, OUTPUT);
+  }
+
+  void play(const tones::TonePattern &pattern) {
+    playSteps(pattern.steps, pattern.count, pattern.repeat);
+  }
+
+  // silence now, also ends a repeating pattern
+  void stop() {
+    if (!attach())
+      return;
+    portENTER_CRITICAL(&mux);
+    pendingPlay = false;
+    pendingStop = true;
+    portEXIT_CRITICAL(&mux);
+    kick();
+  }
 
-  void startTone(unsigned int frequency = 2000) { tone(buzzerPin, frequency); }
+  bool isPlaying() const { return playing || pendingPlay; }
 
-  void stopTone() { noTone(buzzerPin); }
+  // continuous tone until stopTone()
+  void startTone(unsigned int frequency = 2000) {
+    tones::ToneStep s = {(uint16_t)frequency, 1000};
+    playSteps(&s, 1, true);
+  }
+
+  void stopTone() { stop(); }
 
+  // one beep and an equal pause; returns right away
   void beep(unsigned int frequency = 2000, unsigned long duration_ms = 1000) {
-    tone(buzzerPin, frequency);
-    delay(duration_ms);
-    noTone(buzzerPin);
-    delay(duration_ms);
+    uint16_t ms = duration_ms > 0xFFFF ? 0xFFFF : (uint16_t)duration_ms;
+    tones::ToneStep s[2] = {{(uint16_t)frequency, ms}, {0, ms}};
+    playSteps(s, 2, false);
   }
 
 private:
+  struct Pattern {
+    tones::ToneStep steps[tones::MAX_STEPS];
+    int count;
+    bool repeat;
+  };
+
+  // the LEDC channel and timer are set up on first use, not in the
+  // constructor, which runs before the core is up for global instances
+  bool attach() {
+    if (timer)
+      return true;
+    ledcSetup(channel, 2000, 10);
+    ledcAttachPin(buzzerPin, channel);
+    ledcWrite(channel, 0);
+    esp_timer_create_args_t args = {};
+    args.callback = onTimer;
+    args.arg = this;
+    args.name = "buzzer";
+    if (esp_timer_create(&args, &timer) != ESP_OK) {
+      timer = nullptr;
+      return false;
+    }
+    return true;
+  }
+
+  void playSteps(const tones::ToneStep *steps, int count, bool repeat) {
+    if (!attach())
+      return;
+    if (count > tones::MAX_STEPS)
+      count = tones::MAX_STEPS;
+    // the spare buffer is never read by the callback
+    portENTER_CRITICAL(&mux);
+    Pattern &next = patterns[active ^ 1];
+    memcpy(next.steps, steps, count * sizeof(tones::ToneStep));
+    next.count = count;
+    next.repeat = repeat;
+    pendingPlay = true;
+    pendingStop = false;
+    portEXIT_CRITICAL(&mux);
+    kick();
+  }
+
+  // run the callback now; if it is running already and rearms itself, the
+  // request is picked up at the end of the current step instead
+  void kick() {
+    esp_timer_stop(timer);
+    esp_timer_start_once(timer, 0);
+  }
+
+  static void onTimer(void *arg) { static_cast<Buzzer_Driver *>(arg)->next(); }
+
+  void next() {
+    uint16_t freq = 0, ms = 0;
+    portENTER_CRITICAL(&mux);
+    if (pendingStop) {
+      pendingStop = false;
+      playing = false;
+    } else if (pendingPlay) {
+      pendingPlay = false;
+      active ^= 1;
+      step = 0;
+      playing = patterns[active].count > 0;
+    } else if (playing && ++step >= patterns[active].count) {
+      step = 0;
+      playing = patterns[active].repeat;
+    }
+    if (playing) {
+      freq = patterns[active].steps[step].freq;
+      ms = patterns[active].steps[step].ms;
+    }
+    portEXIT_CRITICAL(&mux);
+
+    setFrequency(freq);
+    if (playing)
+      esp_timer_start_once(timer, (uint64_t)ms * 1000ULL);
+  }
+
+  void setFrequency(uint16_t freq) {
+    if (freq == currentFreq)
+      return; // rewriting restarts the waveform and clicks
+    if (freq)
+      ledcWriteTone(channel, freq);
+    else
+      ledcWrite(channel, 0);
+    currentFreq = freq;
+  }
+
   uint8_t buzzerPin;
+  uint8_t channel;
+  esp_timer_handle_t timer;
+  portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+  Pattern patterns[2];
+  int active;
+  int step;
+  volatile bool playing;
+  volatile bool pendingPlay;
+  bool pendingStop;
+  uint16_t currentFreq;
 };
 
 #endif // !BUZZER_DRIVER_H
@@ -0,0 +1,82 @@
+#ifndef CALIBRATION_STORE_H
+#define CALIBRATION_STORE_H
+
+#include "debug_log.h"
+#include "log_codec.h"
+#include "sensor_calibration.h"
+#include <Arduino.h>
+#include <Preferences.h>
+#include <cstddef>
+#include <cstring>
+
+// Keeps the last ground calibration in NVS so a warm reboot on the pad can
+// reuse it instead of sitting through another averaging window. The record
+// carries a version, its size and a CRC-32; anything else is ignored.
+class CalibrationStore {
+public:
+  // older than this (by GPS time) and the pad conditions have moved on
+  static const uint32_t MAX_AGE_S = 4 * 3600;
+
+  bool load(CalibrationData &out) {
+    Record r;
+    Preferences prefs;
+    if (!prefs.begin("calib", true))
+      return false;
+    size_t n = prefs.getBytesLength("ground") == sizeof(r)
+                   ? prefs.getBytes("ground", &r, sizeof(r))
+                   : 0;
+    prefs.end();
+    if (n != sizeof(r) || r.version != VERSION || r.crc != crcOf(r)) {
+      DLOG_INFO("No stored calibration");
+      return false;
+    }
+    out = r.data;
+    return true;
+  }
+
+  bool save(const CalibrationData &d) {
+    Record r;
+    memset(&r, 0, sizeof(r));
+    r.version = VERSION;
+    r.data = d;
+    r.crc = crcOf(r);
+    Preferences prefs;
+    if (!prefs.begin("calib", false))
+      return false;
+    bool ok = prefs.putBytes("ground", &r, sizeof(r)) == sizeof(r);
+    prefs.end();
+    if (!ok)
+      DLOG_WARN("Calibration not saved");
+    return ok;
+  }
+
+  void clear() {
+    Preferences prefs;
+    if (prefs.begin("calib", false)) {
+      prefs.remove("ground");
+      prefs.end();
+    }
+  }
+
+  // false only when both times are known and too far apart
+  static bool isFresh(const CalibrationData &d, uint32_t nowUtcSeconds) {
+    if (d.utcSeconds == 0 || nowUtcSeconds == 0)
+      return true;
+    return nowUtcSeconds - d.utcSeconds <= MAX_AGE_S;
+  }
+
+private:
+  static const uint32_t VERSION = 1;
+
+  struct Record {
+    uint32_t version;
+    CalibrationData data;
+    uint32_t crc;
+  };
+
+  static uint32_t crcOf(const Record &r) {
+    return logcodec::crc32((const uint8_t *)&r, offsetof(Record, crc));
+  }
+};
+
+#endif // !CALIBRATION_STORE_H
@@ -0,0 +1,159 @@
+#ifndef CAPTURE_ARENA_H
+#define CAPTURE_ARENA_H
+
+#include "log_codec.h"
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Full-rate IMU and baro records for the PSRAM capture (psram_capture.h),
+// and the ring they wait in until the logger task has SD bandwidth for
+// them.
+//
+// Record (little endian, RECORD_BYTES):
+//   u8 RECORD_MAGIC, u8 kind (bit 7: timestamp is GPS UTC),
+//   u8 step (IMU frames kept 1 in step), u64 time base us,
+//   KIND_IMU:  i16 ax, ay, az (1/2048 g), i16 gx, gy, gz (1/900 rad/s)
+//   KIND_BARO: u32 pressure (0.1 Pa), i16 temperature (0.01 °C), 6 zero
+//              bytes
+//   u8 low byte of the CRC-32 of the bytes before
+//
+// When the ring fills faster than it drains, IMU frames are decimated
+// rather than dropped: every time the free space halves below half of the
+// ring the step doubles, up to MAX_STEP, and it comes back down as the
+// ring drains. Only a ring full even at MAX_STEP drops records.
+
+namespace capture {
+
+enum Kind { KIND_IMU, KIND_BARO };
+
+static const uint8_t RECORD_MAGIC = 0x43; // "C"
+static const size_t RECORD_BYTES = 24;
+static const uint8_t MAX_STEP = 16;
+// the FIFO's full scale (MPU6050_Driver::FIFO_ACCEL_RANGE_G), so a boost
+// sample is never clipped by the record
+static const float ACCEL_SCALE = 2048.0f; // counts per g, ±16 g
+static const float GYRO_SCALE = 900.0f;   // counts per rad/s, ±36 rad/s
+
+struct Record {
+  uint8_t kind;
+  bool utc;
+  uint8_t step;
+  uint64_t t_us;
+  float v[6]; // accel g, gyro rad/s; or pressure hPa, temperature °C
+};
+
+inline int16_t sat16(float v) {
+  v = roundf(v);
+  return v > 32767.0f ? 32767 : v < -32768.0f ? -32768 : (int16_t)v;
+}
+
+inline void encodeRecord(const Record &r, uint8_t *out) {
+  using logcodec::put16;
+  out[0] = RECORD_MAGIC;
+  out[1] = (uint8_t)(r.kind | (r.utc ? 0x80 : 0));
+  out[2] = r.step;
+  for (int i = 0; i < 8; i++)
+    out[3 + i] = (uint8_t)(r.t_us >> (8 * i));
+  uint8_t *p = out + 11;
+  if (r.kind == KIND_IMU) {
+    for (int k = 0; k < 3; k++)
+      put16(p + 2 * k, (uint16_t)sat16(r.v[k] * ACCEL_SCALE));
+    for (int k = 3; k < 6; k++)
+      put16(p + 2 * k, (uint16_t)sat16(r.v[k] * GYRO_SCALE));
+  } else {
+    float pa10 = r.v[0] * 1000.0f;
+    logcodec::put32(p, pa10 > 0.0f ? (uint32_t)(pa10 + 0.5f) : 0);
+    put16(p + 4, (uint16_t)sat16(r.v[1] * 100.0f));
+    memset(p + 6, 0, 6);
+  }
+  out[RECORD_BYTES - 1] =
+      (uint8_t)logcodec::crc32(out, RECORD_BYTES - 1);
+}
+
+// false for a damaged record
+inline bool decodeRecord(const uint8_t *in, Record &r) {
+  using logcodec::get16;
+  if (in[0] != RECORD_MAGIC ||
+      in[RECORD_BYTES - 1] != (uint8_t)logcodec::crc32(in, RECORD_BYTES - 1))
+    return false;
+  r.kind = in[1] & 0x7F;
+  r.utc = in[1] & 0x80;
+  r.step = in[2];
+  r.t_us = 0;
+  for (int i = 0; i < 8; i++)
+    r.t_us |= (uint64_t)in[3 + i] << (8 * i);
+  const uint8_t *p = in + 11;
+  if (r.kind == KIND_IMU) {
+    for (int k = 0; k < 3; k++)
+      r.v[k] = (int16_t)get16(p + 2 * k) / ACCEL_SCALE;
+    for (int k = 3; k < 6; k++)
+      r.v[k] = (int16_t)get16(p + 2 * k) / GYRO_SCALE;
+  } else {
+    r.v[0] = logcodec::get32(p) / 1000.0f;
+    r.v[1] = (int16_t)get16(p + 4) / 100.0f;
+    r.v[2] = r.v[3] = r.v[4] = r.v[5] = 0.0f;
+  }
+  return true;
+}
+
+// Ring of encoded records over caller-owned memory. Not locked: one
+// consumer calls copy() and release(); the caller serialises push(),
+// release() and the pending() snapshot the consumer copies from.
+class Arena {
+public:
+  Arena() : mem(nullptr), capacity(0), head(0), tail(0), count(0) {}
+
+  void attach(uint8_t *memory, size_t bytes) {
+    mem = memory;
+    capacity = bytes / RECORD_BYTES;
+    head = tail = count = 0;
+  }
+
+  bool attached() const { return capacity != 0; }
+  size_t capacityRecords() const { return capacity; }
+  size_t pending() const { return count; }
+
+  // IMU decimation for the current fill level
+  uint8_t step() const {
+    size_t free = capacity - count;
+    uint8_t step = 1;
+    for (size_t half = capacity / 2; free < half && step < MAX_STEP;
+         half /= 2)
+      step *= 2;
+    return step;
+  }
+
+  // false (and nothing written) when full
+  bool push(const uint8_t *record) {
+    if (count == capacity)
+      return false;
+    memcpy(mem + head * RECORD_BYTES, record, RECORD_BYTES);
+    head = head + 1 == capacity ? 0 : head + 1;
+    count++;
+    return true;
+  }
+
+  // the oldest n records, n no more than a pending() taken since the last
+  // release(); they stay in the ring until released
+  void copy(uint8_t *out, size_t n) const {
+    size_t first = capacity - tail < n ? capacity - tail : n;
+    memcpy(out, mem + tail * RECORD_BYTES, first * RECORD_BYTES);
+    memcpy(out + first * RECORD_BYTES, mem, (n - first) * RECORD_BYTES);
+  }
+
+  void release(size_t n) {
+    tail = (tail + n) % capacity;
+    count -= n;
+  }
+
+private:
+  uint8_t *mem;
+  size_t capacity;
+  size_t head, tail, count; // in records
+};
+
+} // namespace capture
+
+#endif // !CAPTURE_ARENA_H
@@ -0,0 +1,70 @@
+#ifndef COMMAND_DISPATCHER_H
+#define COMMAND_DISPATCHER_H
+
+#include "downlink_scheduler.h"
+#include "uplink_protocol.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Authenticates uplink commands, rejects replays and routes each one to the
+// handler registered for its opcode. The handler's status is queued as an
+// ack for the next downlink frame.
+class CommandDispatcher {
+public:
+  // returns an uplink::AckStatus
+  typedef uint8_t (*Handler)(const uplink::Command &cmd);
+
+  explicit CommandDispatcher(const uint8_t *key)
+      : lastCounter(0), accepted(0), rejectedAuth(0), rejectedReplay(0) {
+    memcpy(this->key, key, uplink::KEY_BYTES);
+    memset(handlers, 0, sizeof(handlers));
+  }
+
+  void on(uint8_t opcode, Handler handler) {
+    if (opcode < uplink::CMD_OPCODE_COUNT)
+      handlers[opcode] = handler;
+  }
+
+  // one received packet; returns true if it was a valid, fresh command
+  bool receive(const uint8_t *buf, size_t len, DownlinkScheduler &downlink) {
+    uplink::Command cmd;
+    if (uplink::parseCommand(key, buf, len, cmd) != uplink::PARSE_OK) {
+      rejectedAuth++;
+      return false;
+    }
+    // the counter only moves forward, so a recorded command cannot be
+    // played back; the ground station resends with a new counter
+    if (cmd.counter <= lastCounter) {
+      rejectedReplay++;
+      return false;
+    }
+    lastCounter = cmd.counter;
+    accepted++;
+
+    uint8_t status = uplink::ACK_UNKNOWN_OPCODE;
+    if (cmd.opcode < uplink::CMD_OPCODE_COUNT && handlers[cmd.opcode])
+      status = handlers[cmd.opcode](cmd);
+    downlink.queueAck(cmd.counter, cmd.opcode, status);
+    return true;
+  }
+
+  // carried across resets (RTC checkpoint) and power cycles (NVS,
+  // uplink_counter_store.h), or a reboot would reopen the replay window
+  uint32_t lastCounterAccepted() const { return lastCounter; }
+  void resumeCounter(uint32_t counter) { lastCounter = counter; }
+
+  uint32_t acceptedCount() const { return accepted; }
+  uint32_t rejectedAuthCount() const { return rejectedAuth; }
+  uint32_t rejectedReplayCount() const { return rejectedReplay; }
+
+private:
+  uint8_t key[uplink::KEY_BYTES];
+  Handler handlers[uplink::CMD_OPCODE_COUNT];
+  uint32_t lastCounter;
+  uint32_t accepted;
+  uint32_t rejectedAuth;
+  uint32_t rejectedReplay;
+};
+
+#endif // !COMMAND_DISPATCHER_H
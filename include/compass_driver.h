@@ -1,6 +1,8 @@
 #ifndef COMPASS_DRIVER_H
 #define COMPASS_DRIVER_H
 
+#include "debug_log.h"
+#include "fast_math.h"
 #include <Adafruit_HMC5883_U.h>
 #include <Adafruit_Sensor.h>
 #include <Wire.h>
@@ -11,7 +13,7 @@ public:
 
   void begin() {
     if (!compass.begin()) {
-      Serial.println("Failed to detect HMC5883 sensor");
+      DLOG_ERROR("Failed to detect HMC5883 sensor");
     }
   }
 
@@ -19,14 +21,10 @@ public:
     sensors_event_t event;
     compass.getEvent(&event);
 
-    float heading = atan2(event.magnetic.y, event.magnetic.x) * 180.0 / PI;
-    if (heading < 0) {
-      heading += 360.0;
-    }
-    return heading;
+    return fastmath::headingDeg(event.magnetic.y, event.magnetic.x);
   }
 
-  void powerDown() { Serial.println("Stop using compass"); }
+  void powerDown() { DLOG_INFO("Stop using compass"); }
 
 private:
   Adafruit_HMC5883_Unified compass;
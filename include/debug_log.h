@@ -0,0 +1,148 @@
+#ifndef DEBUG_LOG_H
+#define DEBUG_LOG_H
+
+#include <Arduino.h>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// Deferred debug logging. A DLOG_* call only captures the format string
+// pointer, a timestamp and up to DLOG_MAX_ARGS raw arguments into a
+// lock-free ring; a low-priority task does the formatting and the UART
+// writes, so the caller never blocks and nothing allocates. When the ring
+// is full, new entries are dropped and counted.
+//
+// The format must be a string literal: it is read later by the drain task,
+// and in binary mode its address is the token the host decoder
+// (tools/log_decode.py) resolves against firmware.elf. A const char *
+// argument is copied (first one only, up to DLOG_STRING_BYTES - 1 chars).
+//
+// Levels below DLOG_LEVEL compile to nothing; debugLogSetLevel() filters
+// further at run time.
+
+#define DLOG_LEVEL_NONE 0
+#define DLOG_LEVEL_ERROR 1
+#define DLOG_LEVEL_WARN 2
+#define DLOG_LEVEL_INFO 3
+#define DLOG_LEVEL_DEBUG 4
+
+#ifndef DLOG_LEVEL
+#define DLOG_LEVEL DLOG_LEVEL_INFO
+#endif
+
+static const int DLOG_MAX_ARGS = 4;
+static const int DLOG_STRING_BYTES = 24;
+
+// argument type tags, two bits per argument
+enum DebugLogArgType : uint8_t {
+  DLOG_ARG_INT,
+  DLOG_ARG_UINT,
+  DLOG_ARG_FLOAT,
+  DLOG_ARG_STRING
+};
+
+struct DebugLogEntry {
+  const char *fmt;
+  uint32_t timestamp_us;
+  uint8_t level;
+  uint8_t nargs;
+  uint8_t types;
+  uint8_t reserved;
+  uint32_t args[DLOG_MAX_ARGS];
+  char str[DLOG_STRING_BYTES];
+};
+
+void debugLogInit(bool binary = false);
+void debugLogSetLevel(uint8_t level);
+uint8_t debugLogLevel();
+void debugLogSetBinary(bool binary);
+uint32_t debugLogDropped();
+
+// enqueue a captured entry; safe from any task, never blocks
+void debugLogPush(const DebugLogEntry &entry);
+
+extern volatile uint8_t debugLogRuntimeLevel;
+
+namespace debuglog {
+
+template <typename T>
+inline typename std::enable_if<std::is_integral<T>::value ||
+                                   std::is_enum<T>::value,
+                               void>::type
+packArg(DebugLogEntry &e, int i, T v) {
+  bool isSigned = std::is_signed<T>::value;
+  e.args[i] = (uint32_t)v;
+  e.types |= (isSigned ? DLOG_ARG_INT : DLOG_ARG_UINT) << (2 * i);
+}
+
+template <typename T>
+inline typename std::enable_if<std::is_floating_point<T>::value, void>::type
+packArg(DebugLogEntry &e, int i, T v) {
+  float f = (float)v;
+  memcpy(&e.args[i], &f, sizeof(f));
+  e.types |= DLOG_ARG_FLOAT << (2 * i);
+}
+
+inline void packArg(DebugLogEntry &e, int i, const char *s) {
+  e.types |= DLOG_ARG_STRING << (2 * i);
+  e.args[i] = 0;
+  if (e.str[0] != '\0' || !s) // only the first string is kept
+    return;
+  strncpy(e.str, s, DLOG_STRING_BYTES - 1);
+  e.str[DLOG_STRING_BYTES - 1] = '\0';
+}
+
+inline void packArgs(DebugLogEntry &, int) {}
+
+template <typename T, typename... Rest>
+inline void packArgs(DebugLogEntry &e, int i, T first, Rest... rest) {
+  packArg(e, i, first);
+  packArgs(e, i + 1, rest...);
+}
+
+template <typename... Args>
+inline void write(uint8_t level, const char *fmt, Args... args) {
+  static_assert(sizeof...(Args) <= DLOG_MAX_ARGS, "too many log arguments");
+  if (level > debugLogRuntimeLevel)
+    return;
+  DebugLogEntry e;
+  e.fmt = fmt;
+  e.timestamp_us = micros();
+  e.level = level;
+  e.nargs = sizeof...(Args);
+  e.types = 0;
+  e.reserved = 0;
+  e.str[0] = '\0';
+  packArgs(e, 0, args...);
+  debugLogPush(e);
+}
+
+} // namespace debuglog
+
+#if DLOG_LEVEL >= DLOG_LEVEL_ERROR
+#define DLOG_ERROR(fmt, ...)                                                   \
+  debuglog::write(DLOG_LEVEL_ERROR, fmt, ##__VA_ARGS__)
+#else
+#define DLOG_ERROR(fmt, ...) ((void)0)
+#endif
+
+#if DLOG_LEVEL >= DLOG_LEVEL_WARN
+#define DLOG_WARN(fmt, ...) debuglog::write(DLOG_LEVEL_WARN, fmt, ##__VA_ARGS__)
+#else
+#define DLOG_WARN(fmt, ...) ((void)0)
+#endif
+
+#if DLOG_LEVEL >= DLOG_LEVEL_INFO
+#define DLOG_INFO(fmt, ...) debuglog::write(DLOG_LEVEL_INFO, fmt, ##__VA_ARGS__)
+#else
+#define DLOG_INFO(fmt, ...) ((void)0)
+#endif
+
+#if DLOG_LEVEL >= DLOG_LEVEL_DEBUG
+#define DLOG_DEBUG(fmt, ...)                                                   \
+  debuglog::write(DLOG_LEVEL_DEBUG, fmt, ##__VA_ARGS__)
+#else
+#define DLOG_DEBUG(fmt, ...) ((void)0)
+#endif
+
+#endif // !DEBUG_LOG_H
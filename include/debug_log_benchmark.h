@@ -0,0 +1,58 @@
+#ifndef DEBUG_LOG_BENCHMARK_H
+#define DEBUG_LOG_BENCHMARK_H
+
+#include "bench_report.h"
+#include "debug_log.h"
+#include <Arduino.h>
+
+// On-target cost of a DLOG call as seen by the caller, for the enqueue path
+// and for the drop path with the ring full. Run from setup() in the
+// esp32dev_bench env.
+
+static const int DLOG_BENCH_CALLS = 32; // fewer than the ring holds
+
+void runDebugLogBenchmark() {
+  Serial.println("=== DEBUG LOG BENCHMARK ===");
+  const float cyclesPerUs = ESP.getCpuFreqMHz();
+  uint8_t savedLevel = debugLogLevel();
+  debugLogSetLevel(DLOG_LEVEL_INFO);
+
+  delay(200); // let the drain task empty the ring
+  uint32_t t0 = ESP.getCycleCount();
+  for (int i = 0; i < DLOG_BENCH_CALLS; i++)
+    DLOG_INFO("bench %d alt %.2f", i, 123.45f);
+  uint32_t enqueue = ESP.getCycleCount() - t0;
+
+  // keep calling until entries are dropped, then time the drop path
+  uint32_t drops = debugLogDropped();
+  while (debugLogDropped() == drops)
+    DLOG_INFO("bench fill %d", 0);
+  t0 = ESP.getCycleCount();
+  for (int i = 0; i < DLOG_BENCH_CALLS; i++)
+    DLOG_INFO("bench %d alt %.2f", i, 123.45f);
+  uint32_t drop = ESP.getCycleCount() - t0;
+
+  // below the runtime level: the level check only
+  debugLogSetLevel(DLOG_LEVEL_WARN);
+  t0 = ESP.getCycleCount();
+  for (int i = 0; i < DLOG_BENCH_CALLS; i++)
+    DLOG_INFO("bench %d alt %.2f", i, 123.45f);
+  uint32_t filtered = ESP.getCycleCount() - t0;
+  debugLogSetLevel(savedLevel);
+  delay(200);
+
+  Serial.printf("  enqueue   %6.1f cycles  %5.3f us/call\n",
+                (float)enqueue / DLOG_BENCH_CALLS,
+                enqueue / cyclesPerUs / DLOG_BENCH_CALLS);
+  Serial.printf("  ring full %6.1f cycles  %5.3f us/call\n",
+                (float)drop / DLOG_BENCH_CALLS,
+                drop / cyclesPerUs / DLOG_BENCH_CALLS);
+  Serial.printf("  filtered  %6.1f cycles  %5.3f us/call\n",
+                (float)filtered / DLOG_BENCH_CALLS,
+                filtered / cyclesPerUs / DLOG_BENCH_CALLS);
+  benchReportTicks("dlog", "enqueue", enqueue, DLOG_BENCH_CALLS);
+  benchReportTicks("dlog", "ring_full", drop, DLOG_BENCH_CALLS);
+  benchReportTicks("dlog", "filtered", filtered, DLOG_BENCH_CALLS);
+}
+
+#endif // !DEBUG_LOG_BENCHMARK_H
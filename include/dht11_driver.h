@@ -1,6 +1,7 @@
 #ifndef DHT11_DRIVER_H
 #define DHT11_DRIVER_H
 
+#include "debug_log.h"
 #include <DHT.h>
 #include <cmath>
 
@@ -25,7 +26,7 @@ public:
     return h;
   }
 
-  void powerDown() { Serial.println("Stop reading from DHT11"); }
+  void powerDown() { DLOG_INFO("Stop reading from DHT11"); }
 
 private:
   DHT dht = DHT(DHTPIN, DHTTYPE);
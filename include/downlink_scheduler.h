@@ -0,0 +1,426 @@
+#ifndef DOWNLINK_SCHEDULER_H
+#define DOWNLINK_SCHEDULER_H
+
+#include "flight_state.h"
+#include "telemetry_sample.h"
+#include "vibration_spectrum.h"
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+// Multiplexes the telemetry downlink into small typed messages, each with
+// its own rate and priority per flight state, and packs whatever is due
+// into one LoRa frame. Frames are paced so the radio stays under a duty
+// cycle budget computed from the real time on air.
+//
+// Frame (little endian):
+//   u8 FRAME_MAGIC, u8 frame sequence, u32 time base ms (low 32 bits),
+//   then messages: u8 type, u16 age in ms before the frame time, payload
+//
+// Payloads:
+//   NAV       i32 lat 1e-7 deg, i32 lon 1e-7 deg, u8 flags (bit0 UTC)
+//   BARO      i32 altitude cm (smoothed), u32 pressure Pa
+//   ATTITUDE  i16 ax, ay, az mg, i16 gx, gy, gz mrad/s, u16 heading cdeg
+//   ENV       i16 temp_bmp cC, i16 temp_dht cC, u16 humidity c%
+//   HEALTH    u8 state, u8 flags, u32 uptime s, u32 log blocks,
+//             u16 log drops, u16 debug log drops
+//   VIBRATION u16 dominant frequency 0.1 Hz, u16 accel RMS mg,
+//             u16 band RMS mg x 6 (vibration_spectrum.h bands)
+//   ACK       u32 command counter, u8 opcode, u8 status (uplink_protocol.h)
+//   LOG_CHUNK u32 block index, u16 offset, u8 length, that many bytes of
+//             the 512-byte log block
+//
+// Measurements saturate at their field's range; a missing one (NaN) is
+// sent as the minimum of a signed field or all ones of an unsigned one.
+//
+// ACK and LOG_CHUNK are event driven rather than periodic: pending acks
+// lead the next frame, and a log block being resent fills whatever room
+// the periodic messages leave.
+
+enum DownlinkMsgType : uint8_t {
+  MSG_NAV,
+  MSG_BARO,
+  MSG_ATTITUDE,
+  MSG_ENV,
+  MSG_HEALTH,
+  MSG_VIBRATION,
+  MSG_TYPE_COUNT, // periodic types above, event types below
+  MSG_ACK = 0x10,
+  MSG_LOG_CHUNK = 0x11
+};
+
+// health flag bits
+static const uint8_t HEALTH_TIME_UTC = 0x01;
+static const uint8_t HEALTH_LOG_RAW = 0x02;
+static const uint8_t HEALTH_GPS_FIX = 0x04;
+static const uint8_t HEALTH_TDMA_SYNC = 0x08;
+
+struct DownlinkHealth {
+  uint8_t state;
+  uint8_t flags;
+  uint32_t uptime_s;
+  uint32_t logBlocks;
+  uint32_t logDrops;
+  uint32_t debugLogDrops;
+};
+
+struct DownlinkRate {
+  uint16_t period_ms; // 0 = not sent in this state
+  uint8_t priority;   // lower goes first when the frame is full
+};
+
+class DownlinkScheduler {
+public:
+  static const uint8_t FRAME_MAGIC = 0xD1;
+  static const size_t MAX_FRAME_BYTES = 255; // LoRaDriver::MAX_PAYLOAD
+  static const size_t FRAME_HEADER_BYTES = 6;
+  static const size_t MSG_HEADER_BYTES = 3;
+  static const size_t ACK_PAYLOAD_BYTES = 6;
+  static const size_t CHUNK_HEADER_BYTES = 7;
+  static const size_t MIN_CHUNK_BYTES = 16; // not worth a message below this
+  static const size_t RESEND_BLOCK_BYTES = 512;
+  static const int MAX_PENDING_ACKS = 4;
+
+  // per-state message table
+  static const DownlinkRate &rate(FlightState state, int type) {
+    static const DownlinkRate RATES[4][MSG_TYPE_COUNT] = {
+        // NAV, BARO, ATTITUDE, ENV, HEALTH, VIBRATION
+        /* PRELAUNCH */
+        {{5000, 2}, {5000, 3}, {0, 0}, {10000, 4}, {2000, 1}, {10000, 5}},
+        /* ASCENT    */
+        {{1000, 3}, {200, 1}, {250, 2}, {0, 0}, {5000, 4}, {1000, 5}},
+        /* DESCENT   */
+        {{1000, 1}, {500, 2}, {1000, 4}, {10000, 5}, {2000, 3}, {5000, 6}},
+        /* POSTLAND  */
+        {{2000, 1}, {0, 0}, {0, 0}, {30000, 3}, {5000, 2}, {0, 0}},
+    };
+    return RATES[state][type];
+  }
+
+  // maxFrame is capped at the PHY limit; dutyCycle is the fraction of
+  // wall time the transmitter may be on
+  DownlinkScheduler(size_t maxFrame, float dutyCycle)
+      : maxFrameBytes(maxFrame < MAX_FRAME_BYTES ? maxFrame : MAX_FRAME_BYTES),
+        duty(dutyCycle), frameSeq(0),
+        nextFrameMs(0), ackCount(0), resendActive(false), resendIndex(0),
+        resendOffset(0) {
+    memset(nextDueMs, 0, sizeof(nextDueMs));
+    memset(fresh, 0, sizeof(fresh));
+    memset(&health, 0, sizeof(health));
+    memset(&latest, 0, sizeof(latest));
+    memset(&vib, 0, sizeof(vib));
+    altitude = NAN;
+  }
+
+  // raw acquisition (NAV) and smoothed altitude (BARO), every sample
+  void observe(const TelemetrySample &raw, float smoothedAltitude) {
+    latest.lat_e7 = raw.lat_e7;
+    latest.lon_e7 = raw.lon_e7;
+    latest.gps_us = raw.gps_us;
+    latest.utc = raw.utc;
+    fresh[MSG_NAV] = true;
+    if (!std::isnan(smoothedAltitude)) {
+      altitude = smoothedAltitude;
+      altitude_us = raw.baro_us;
+      fresh[MSG_BARO] = true;
+    }
+  }
+
+  // anti-aliased decimated stream (ATTITUDE, ENV, BARO pressure)
+  void observeDownlink(const TelemetrySample &d) {
+    uint64_t gps_us = latest.gps_us;
+    int32_t lat = latest.lat_e7, lon = latest.lon_e7;
+    bool utc = latest.utc;
+    latest = d;
+    latest.gps_us = gps_us; // keep the raw nav fields
+    latest.lat_e7 = lat;
+    latest.lon_e7 = lon;
+    latest.utc = utc;
+    fresh[MSG_ATTITUDE] = true;
+    fresh[MSG_ENV] = true;
+  }
+
+  // accelerometer window summaries; never fresh unless fed, so the
+  // downlink only carries them when the caller opts in
+  void observeVibration(const vibration::Summary &v) {
+    vib = v;
+    fresh[MSG_VIBRATION] = true;
+  }
+
+  void observeHealth(const DownlinkHealth &h) {
+    health = h;
+    fresh[MSG_HEALTH] = true;
+  }
+
+  // queued for the next frame; false when the ack queue is full
+  bool queueAck(uint32_t counter, uint8_t opcode, uint8_t status) {
+    if (ackCount >= MAX_PENDING_ACKS)
+      return false;
+    PendingAck &a = acks[ackCount++];
+    a.counter = counter;
+    a.opcode = opcode;
+    a.status = status;
+    return true;
+  }
+
+  bool acksPending() const { return ackCount > 0; }
+
+  // streams a copy of one log block out in LOG_CHUNK messages
+  bool resendBlock(uint32_t index, const uint8_t *block) {
+    if (resendActive)
+      return false;
+    memcpy(resendData, block, RESEND_BLOCK_BYTES);
+    resendIndex = index;
+    resendOffset = 0;
+    resendActive = true;
+    return true;
+  }
+
+  bool resendBusy() const { return resendActive; }
+
+  // true when the airtime budget allows another frame
+  bool canSend(uint32_t nowMs) const {
+    return (int32_t)(nowMs - nextFrameMs) >= 0;
+  }
+
+  // Packs pending acks, then every due message that fits, highest priority
+  // first, then a resend chunk into the space left. Returns the frame
+  // length, 0 when nothing is due. frameTimeUs is the time base timestamp
+  // the message ages are relative to.
+  size_t buildFrame(FlightState state, uint32_t nowMs, uint64_t frameTimeUs,
+                    uint8_t *frame) {
+    uint8_t order[MSG_TYPE_COUNT];
+    int due = 0;
+    for (int t = 0; t < MSG_TYPE_COUNT; t++) {
+      const DownlinkRate &r = rate(state, t);
+      if (r.period_ms == 0 || !fresh[t] ||
+          (int32_t)(nowMs - nextDueMs[t]) < 0)
+        continue;
+      int i = due++;
+      for (; i > 0 && rate(state, order[i - 1]).priority > r.priority; i--)
+        order[i] = order[i - 1];
+      order[i] = (uint8_t)t;
+    }
+    if (!due && !ackCount && !resendActive)
+      return 0;
+
+    size_t len = FRAME_HEADER_BYTES;
+    int acked = 0;
+    for (; acked < ackCount &&
+           len + MSG_HEADER_BYTES + ACK_PAYLOAD_BYTES <= maxFrameBytes;
+         acked++)
+      len += encodeAck(acks[acked], frame + len);
+    memmove(acks, acks + acked, (ackCount - acked) * sizeof(PendingAck));
+    ackCount -= acked;
+
+    for (int i = 0; i < due; i++) {
+      uint8_t t = order[i];
+      if (len + MSG_HEADER_BYTES + payloadBytes(t) > maxFrameBytes)
+        continue; // stays due for the next frame
+      len += encodeMessage(t, frameTimeUs, frame + len);
+      fresh[t] = t == MSG_HEALTH; // health is always resent
+      // advance on the period grid, resync if we fell behind
+      nextDueMs[t] += rate(state, t).period_ms;
+      if ((int32_t)(nowMs - nextDueMs[t]) >= 0)
+        nextDueMs[t] = nowMs + rate(state, t).period_ms;
+    }
+    if (resendActive &&
+        len + MSG_HEADER_BYTES + CHUNK_HEADER_BYTES + MIN_CHUNK_BYTES <=
+            maxFrameBytes)
+      len += encodeChunk(frame + len,
+                         maxFrameBytes - len - MSG_HEADER_BYTES -
+                             CHUNK_HEADER_BYTES);
+    if (len == FRAME_HEADER_BYTES)
+      return 0;
+
+    frame[0] = FRAME_MAGIC;
+    frame[1] = frameSeq++;
+    put32(frame + 2, (uint32_t)(frameTimeUs / 1000));
+    return len;
+  }
+
+  // call after transmitting a frame of the given time on air
+  void frameSent(uint32_t nowMs, uint32_t airtimeUs) {
+    nextFrameMs = nowMs + (uint32_t)(airtimeUs / 1000.0f / duty);
+  }
+
+  // carried across resets so the ground sees one frame sequence
+  uint8_t frameSequence() const { return frameSeq; }
+  void setFrameSequence(uint8_t seq) { frameSeq = seq; }
+
+  // restart all periods, e.g. on a state change
+  void resetSchedule(uint32_t nowMs) {
+    for (int t = 0; t < MSG_TYPE_COUNT; t++)
+      nextDueMs[t] = nowMs;
+  }
+
+private:
+  struct PendingAck {
+    uint32_t counter;
+    uint8_t opcode;
+    uint8_t status;
+  };
+
+  static size_t payloadBytes(uint8_t type) {
+    static const uint8_t sizes[MSG_TYPE_COUNT] = {9, 8, 14, 6, 14, 16};
+    return sizes[type];
+  }
+
+  static void put16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+  }
+
+  static void put32(uint8_t *p, uint32_t v) {
+    put16(p, (uint16_t)v);
+    put16(p + 2, (uint16_t)(v >> 16));
+  }
+
+  static int16_t sat16(float v) {
+    if (std::isnan(v))
+      return INT16_MIN;
+    if (v > 32767.0f)
+      return 32767;
+    if (v < -32767.0f)
+      return -32767;
+    return (int16_t)lrintf(v);
+  }
+
+  static int32_t sat32(float v) {
+    if (std::isnan(v))
+      return INT32_MIN;
+    if (v >= 2147483520.0f) // the largest float below 2^31
+      return INT32_MAX;
+    if (v <= -2147483520.0f)
+      return -INT32_MAX;
+    return (int32_t)lrintf(v);
+  }
+
+  static uint16_t sat16u(float v) {
+    if (std::isnan(v))
+      return 0xFFFF;
+    if (v < 0.0f)
+      return 0;
+    return v > 65534.0f ? 0xFFFE : (uint16_t)lrintf(v);
+  }
+
+  static uint32_t sat32u(float v) {
+    if (std::isnan(v))
+      return 0xFFFFFFFF;
+    if (v < 0.0f)
+      return 0;
+    // past lrintf's range where long is 32 bits
+    return v >= 4294967040.0f ? 0xFFFFFFFE : (uint32_t)(v + 0.5f);
+  }
+
+  static uint16_t ageMs(uint64_t frameUs, uint64_t sampleUs) {
+    if (sampleUs >= frameUs)
+      return 0;
+    uint64_t age = (frameUs - sampleUs) / 1000;
+    return age > 0xFFFF ? 0xFFFF : (uint16_t)age;
+  }
+
+  size_t encodeAck(const PendingAck &a, uint8_t *out) const {
+    out[0] = MSG_ACK;
+    put16(out + 1, 0);
+    put32(out + 3, a.counter);
+    out[7] = a.opcode;
+    out[8] = a.status;
+    return MSG_HEADER_BYTES + ACK_PAYLOAD_BYTES;
+  }
+
+  size_t encodeChunk(uint8_t *out, size_t room) {
+    size_t n = RESEND_BLOCK_BYTES - resendOffset;
+    if (n > room)
+      n = room;
+    if (n > 0xFF)
+      n = 0xFF;
+    uint8_t *p = out + MSG_HEADER_BYTES;
+    out[0] = MSG_LOG_CHUNK;
+    put16(out + 1, 0);
+    put32(p, resendIndex);
+    put16(p + 4, (uint16_t)resendOffset);
+    p[6] = (uint8_t)n;
+    memcpy(p + CHUNK_HEADER_BYTES, resendData + resendOffset, n);
+    resendOffset += n;
+    if (resendOffset >= RESEND_BLOCK_BYTES)
+      resendActive = false;
+    return MSG_HEADER_BYTES + CHUNK_HEADER_BYTES + n;
+  }
+
+  size_t encodeMessage(uint8_t type, uint64_t frameUs, uint8_t *out) const {
+    uint8_t *p = out + MSG_HEADER_BYTES;
+    uint64_t sampleUs = frameUs;
+    switch (type) {
+    case MSG_NAV:
+      sampleUs = latest.gps_us;
+      put32(p, (uint32_t)latest.lat_e7);
+      put32(p + 4, (uint32_t)latest.lon_e7);
+      p[8] = latest.utc ? 1 : 0;
+      break;
+    case MSG_BARO:
+      sampleUs = altitude_us;
+      put32(p, (uint32_t)sat32(altitude * 100.0f));
+      put32(p + 4, sat32u(latest.pressure * 100.0f));
+      break;
+    case MSG_ATTITUDE:
+      sampleUs = latest.imu_us;
+      put16(p, (uint16_t)sat16(latest.ax * 1000.0f));
+      put16(p + 2, (uint16_t)sat16(latest.ay * 1000.0f));
+      put16(p + 4, (uint16_t)sat16(latest.az * 1000.0f));
+      put16(p + 6, (uint16_t)sat16(latest.gx * 1000.0f));
+      put16(p + 8, (uint16_t)sat16(latest.gy * 1000.0f));
+      put16(p + 10, (uint16_t)sat16(latest.gz * 1000.0f));
+      put16(p + 12, sat16u(latest.heading * 100.0f));
+      break;
+    case MSG_ENV:
+      sampleUs = latest.env_us;
+      put16(p, (uint16_t)sat16(latest.temp_bmp * 100.0f));
+      put16(p + 2, (uint16_t)sat16(latest.temp_dht * 100.0f));
+      put16(p + 4, sat16u(latest.humidity * 100.0f));
+      break;
+    case MSG_HEALTH:
+      p[0] = health.state;
+      p[1] = health.flags;
+      put32(p + 2, health.uptime_s);
+      put32(p + 6, health.logBlocks);
+      put16(p + 10, health.logDrops > 0xFFFF ? 0xFFFF : health.logDrops);
+      put16(p + 12,
+            health.debugLogDrops > 0xFFFF ? 0xFFFF : health.debugLogDrops);
+      break;
+    case MSG_VIBRATION:
+      sampleUs = vib.t_us;
+      put16(p, vibration::sat16u(vib.peakHz * 10.0f));
+      put16(p + 2, vibration::sat16u(vib.rms * 1000.0f));
+      for (int b = 0; b < vibration::BANDS; b++)
+        put16(p + 4 + 2 * b, vibration::sat16u(vib.bandRms[b] * 1000.0f));
+      break;
+    }
+    out[0] = type;
+    put16(out + 1, ageMs(frameUs, sampleUs));
+    return MSG_HEADER_BYTES + payloadBytes(type);
+  }
+
+  size_t maxFrameBytes;
+  float duty;
+  uint8_t frameSeq;
+  uint32_t nextFrameMs;
+  uint32_t nextDueMs[MSG_TYPE_COUNT];
+  bool fresh[MSG_TYPE_COUNT];
+
+  TelemetrySample latest;
+  float altitude;
+  uint64_t altitude_us = 0;
+  DownlinkHealth health;
+  vibration::Summary vib;
+
+  PendingAck acks[MAX_PENDING_ACKS];
+  int ackCount;
+
+  bool resendActive;
+  uint32_t resendIndex;
+  size_t resendOffset;
+  uint8_t resendData[RESEND_BLOCK_BYTES];
+};
+
+#endif // !DOWNLINK_SCHEDULER_H
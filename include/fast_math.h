@@ -0,0 +1,124 @@
+#ifndef FAST_MATH_H
+#define FAST_MATH_H
+
+#include <cstdint>
+#include <cstring>
+
+// Single-precision kernels for the sensor hot path. The ESP32 FPU only
+// handles float; every double op (and libm pow/atan2) is software emulated.
+// Error bounds are over the documented input ranges.
+
+namespace fastmath {
+
+static constexpr float PI_F = 3.14159265f;
+static constexpr float HALF_PI_F = 1.57079633f;
+static constexpr float RAD_TO_DEG_F = 57.2957795f;
+static constexpr float STANDARD_GRAVITY = 9.80665f;
+static constexpr float INV_STANDARD_GRAVITY = 1.0f / STANDARD_GRAVITY;
+static constexpr float SEA_LEVEL_HPA = 1013.25f;
+
+// 1/sqrt(x), x > 0. Bit-level seed plus two Newton steps, rel. error < 5e-6
+inline float invSqrt(float x) {
+  uint32_t i;
+  memcpy(&i, &x, sizeof(i));
+  i = 0x5f375a86u - (i >> 1);
+  float y;
+  memcpy(&y, &i, sizeof(y));
+  const float half = 0.5f * x;
+  y = y * (1.5f - half * y * y);
+  y = y * (1.5f - half * y * y);
+  return y;
+}
+
+// |v| for a 3-vector, rel. error < 5e-6, returns 0 for the zero vector
+inline float norm3(float x, float y, float z) {
+  float n2 = x * x + y * y + z * z;
+  if (n2 <= 0.0f)
+    return 0.0f;
+  return n2 * invSqrt(n2);
+}
+
+// atan(z) for |z| <= 1, minimax polynomial, abs. error < 1e-5 rad
+inline float atanUnit(float z) {
+  float z2 = z * z;
+  return z * (0.99997726f +
+              z2 * (-0.33262347f +
+                    z2 * (0.19354346f +
+                          z2 * (-0.11643287f +
+                                z2 * (0.05265332f + z2 * -0.01172120f)))));
+}
+
+// atan2(y, x) in radians, abs. error < 1e-5 rad (~6e-4 deg)
+inline float atan2Approx(float y, float x) {
+  float ax = x < 0.0f ? -x : x;
+  float ay = y < 0.0f ? -y : y;
+  if (ax == 0.0f && ay == 0.0f)
+    return 0.0f;
+  float a = ay > ax ? HALF_PI_F - atanUnit(ax / ay) : atanUnit(ay / ax);
+  if (x < 0.0f)
+    a = PI_F - a;
+  return y < 0.0f ? -a : a;
+}
+
+// compass heading in [0, 360) degrees from horizontal field components
+inline float headingDeg(float my, float mx) {
+  float h = atan2Approx(my, mx) * RAD_TO_DEG_F;
+  return h < 0.0f ? h + 360.0f : h;
+}
+
+// natural log for normal floats x > 0; abs. error < 5e-7 for x in
+// [1/2048, 2048), and < 2e-7 * |ln x| beyond that
+inline float ln(float x) {
+  uint32_t i;
+  memcpy(&i, &x, sizeof(i));
+  int e = (int)((i >> 23) & 0xff) - 127;
+  i = (i & 0x007fffffu) | 0x3f800000u; // mantissa in [1, 2)
+  float m;
+  memcpy(&m, &i, sizeof(m));
+  if (m > 1.41421356f) { // recentre to [sqrt(1/2), sqrt(2))
+    m *= 0.5f;
+    e += 1;
+  }
+  // ln(m) = 2 atanh(s), |s| < 0.172
+  float s = (m - 1.0f) / (m + 1.0f);
+  float s2 = s * s;
+  float lnm =
+      2.0f * s *
+      (1.0f + s2 * (1.0f / 3.0f + s2 * (1.0f / 5.0f + s2 * (1.0f / 7.0f))));
+  return lnm + (float)e * 0.693147181f;
+}
+
+// exp(u) - 1 for |u| <= 0.25, Taylor to u^7. The series is good to 1e-9;
+// float rounding makes the abs. error < 5e-8
+inline float expm1Small(float u) {
+  return u * (1.0f +
+              u * (1.0f / 2.0f +
+                   u * (1.0f / 6.0f +
+                        u * (1.0f / 24.0f +
+                             u * (1.0f / 120.0f +
+                                  u * (1.0f / 720.0f + u / 5040.0f))))));
+}
+
+// International barometric formula, 44330 * (1 - (p / p0)^0.190295).
+// Evaluated as -44330 * expm1(0.190295 * ln(p / p0)) so the result keeps
+// its precision near the reference level. For p / p0 in [0.27, 1.1]
+// (about -800 m to 10 km) the error is below 0.01 m.
+inline float baroAltitudeRatio(float pressureRatio) {
+  return -44330.0f * expm1Small(0.190295f * ln(pressureRatio));
+}
+
+inline float baroAltitude(float pressure_hPa,
+                          float seaLevel_hPa = SEA_LEVEL_HPA) {
+  return baroAltitudeRatio(pressure_hPa / seaLevel_hPa);
+}
+
+// Fixed-point degrees (1e-7 deg per LSB) from the whole degrees and
+// billionths TinyGPS++ keeps internally, with no double on the path
+inline int32_t degreesE7(uint16_t deg, uint32_t billionths, bool negative) {
+  int32_t v = (int32_t)deg * 10000000 + (int32_t)((billionths + 50) / 100);
+  return negative ? -v : v;
+}
+
+} // namespace fastmath
+
+#endif // !FAST_MATH_H
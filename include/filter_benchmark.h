@@ -0,0 +1,104 @@
+#ifndef FILTER_BENCHMARK_H
+#define FILTER_BENCHMARK_H
+
+#include "bench_report.h"
+#include "filter_stage.h"
+#include "sample_filters.h"
+#include <Arduino.h>
+
+// On-target throughput of each filter kernel in samples per second, plus
+// the esp-dsp dot product against the scalar reference loop it replaces.
+// Run from setup() in the esp32dev_bench env.
+
+static const int FILTER_BENCH_N = 1000;
+
+static volatile float filterBenchSink;
+
+static void printFilterRow(const char *name, const char *key, uint32_t cycles,
+                           int samples) {
+  const float cpuHz = ESP.getCpuFreqMHz() * 1e6f;
+  Serial.printf("  %-22s %8.1f cyc/sample  %10.0f samples/s\n", name,
+                (float)cycles / samples, cpuHz * samples / (float)cycles);
+  benchReportTicks("filter", key, cycles, samples);
+}
+
+void runFilterBenchmark() {
+  static float in[FILTER_BENCH_N];
+  static float out[FILTER_BENCH_N];
+  for (int i = 0; i < FILTER_BENCH_N; i++)
+    in[i] = 100.0f + 3.0f * sinf(0.37f * i) + (i % 97 == 0 ? 40.0f : 0.0f);
+
+  Serial.println("=== FILTER KERNEL BENCHMARK ===");
+  Serial.printf("  esp-dsp kernels: %s\n", FILTERS_USE_ESP_DSP ? "yes" : "no");
+  uint32_t t0;
+
+  const int taps = TelemetryFilterStage::FIR_TAPS;
+  const int decim = TelemetryFilterStage::DOWNLINK_DECIMATION;
+  t0 = ESP.getCycleCount();
+  for (int i = 0; i + taps <= FILTER_BENCH_N; i++)
+    filterBenchSink = filters::dotProductScalar(&in[i], &in[0], taps);
+  printFilterRow("dot product (scalar)", "dot_scalar",
+                 ESP.getCycleCount() - t0, FILTER_BENCH_N - taps + 1);
+  t0 = ESP.getCycleCount();
+  for (int i = 0; i + taps <= FILTER_BENCH_N; i++)
+    filterBenchSink = filters::dotProduct(&in[i], &in[0], taps);
+  printFilterRow("dot product (kernel)", "dot_kernel",
+                 ESP.getCycleCount() - t0, FILTER_BENCH_N - taps + 1);
+
+  {
+    static filters::FirDecimator<taps, decim> fir;
+    t0 = ESP.getCycleCount();
+    fir.process(in, FILTER_BENCH_N, out);
+    printFilterRow("FIR decimator", "fir", ESP.getCycleCount() - t0,
+                   FILTER_BENCH_N);
+  }
+  {
+    filters::CicDecimator<TelemetryFilterStage::CIC_ORDER, decim> cic;
+    int32_t v;
+    t0 = ESP.getCycleCount();
+    for (int i = 0; i < FILTER_BENCH_N; i++)
+      if (cic.push((int32_t)(in[i] * 100.0f), v))
+        filterBenchSink = v;
+    printFilterRow("CIC decimator", "cic", ESP.getCycleCount() - t0,
+                   FILTER_BENCH_N);
+  }
+  {
+    filters::MedianFilter<5> median;
+    t0 = ESP.getCycleCount();
+    for (int i = 0; i < FILTER_BENCH_N; i++)
+      filterBenchSink = median.push(in[i]);
+    printFilterRow("median-5", "median5", ESP.getCycleCount() - t0,
+                   FILTER_BENCH_N);
+  }
+  {
+    filters::OutlierRejector<5> rejector(5.0f);
+    t0 = ESP.getCycleCount();
+    for (int i = 0; i < FILTER_BENCH_N; i++)
+      filterBenchSink = rejector.push(in[i]);
+    printFilterRow("outlier rejector-5", "outlier5", ESP.getCycleCount() - t0,
+                   FILTER_BENCH_N);
+  }
+  {
+    filters::MovingAverage<4> average;
+    t0 = ESP.getCycleCount();
+    for (int i = 0; i < FILTER_BENCH_N; i++)
+      filterBenchSink = average.push(in[i]);
+    printFilterRow("moving average-4", "average4", ESP.getCycleCount() - t0,
+                   FILTER_BENCH_N);
+  }
+  {
+    static TelemetryFilterStage stage;
+    TelemetrySample s = {};
+    TelemetrySample d;
+    t0 = ESP.getCycleCount();
+    for (int i = 0; i < FILTER_BENCH_N; i++) {
+      s.altitude = s.pressure = s.temp_bmp = s.ax = s.az = in[i];
+      stage.push(s);
+      stage.popDownlink(d);
+    }
+    printFilterRow("full filter stage", "stage", ESP.getCycleCount() - t0,
+                   FILTER_BENCH_N);
+  }
+}
+
+#endif // !FILTER_BENCHMARK_H
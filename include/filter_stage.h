@@ -0,0 +1,158 @@
+#ifndef FILTER_STAGE_H
+#define FILTER_STAGE_H
+
+#include "fast_math.h"
+#include "sample_filters.h"
+#include "telemetry_sample.h"
+#include <cmath>
+#include <cstdint>
+
+// Fans the full-rate acquisition stream out to its consumers:
+//  - SD logging takes every raw sample (not handled here)
+//  - detection reads spike-rejected, smoothed altitude and accel magnitude,
+//    updated on every sample
+//  - the downlink gets one anti-aliased sample per DOWNLINK_DECIMATION
+//    inputs; FIR on the kinematic channels, CIC on the slow environmental
+//    ones, latest value for heading and GPS
+class TelemetryFilterStage {
+public:
+  static const int DOWNLINK_DECIMATION = 10;
+  static const int FIR_TAPS = 2 * DOWNLINK_DECIMATION + 1;
+  static const int CIC_ORDER = 2;
+
+  TelemetryFilterStage()
+      : altitudeRejector(ALTITUDE_SPIKE_M), filled(0), hasOutput(false),
+        stampPos(0) {
+    memset(stamps, 0, sizeof(stamps));
+    lastTempDht = lastHumidity = NAN;
+    envOut[0] = envOut[1] = envOut[2] = NAN;
+  }
+
+  void push(const TelemetrySample &s) {
+    // detection stream
+    detAltitude = altitudeAverage.push(altitudeRejector.push(s.altitude));
+    detAccelMag = accelAverage.push(fastmath::norm3(s.ax, s.ay, s.az));
+
+    // timestamp history to undo the decimators' group delay
+    stamps[stampPos][0] = s.baro_us;
+    stamps[stampPos][1] = s.env_us;
+    stamps[stampPos][2] = s.imu_us;
+    stampPos = stampPos + 1 == FIR_TAPS ? 0 : stampPos + 1;
+
+    // environmental channels: CIC in centi-units, holding over DHT dropouts
+    if (!std::isnan(s.temp_dht))
+      lastTempDht = s.temp_dht;
+    if (!std::isnan(s.humidity))
+      lastHumidity = s.humidity;
+    pushEnv(0, s.temp_bmp);
+    pushEnv(1, lastTempDht);
+    pushEnv(2, lastHumidity);
+
+    // kinematic channels are buffered and run through the FIR per block
+    block[CH_PRESSURE][filled] = s.pressure;
+    block[CH_ALTITUDE][filled] = s.altitude;
+    block[CH_AX][filled] = s.ax;
+    block[CH_AY][filled] = s.ay;
+    block[CH_AZ][filled] = s.az;
+    block[CH_GX][filled] = s.gx;
+    block[CH_GY][filled] = s.gy;
+    block[CH_GZ][filled] = s.gz;
+    latest = s;
+
+    if (++filled == DOWNLINK_DECIMATION) {
+      filled = 0;
+      processBlock();
+    }
+  }
+
+  // drop the detection history, e.g. after the altitude reference moved
+  void resetDetection() {
+    altitudeRejector = filters::OutlierRejector<5>(ALTITUDE_SPIKE_M);
+    altitudeAverage = filters::MovingAverage<4>();
+    accelAverage = filters::MovingAverage<4>();
+    detAltitude = detAccelMag = NAN;
+  }
+
+  float altitude() const { return detAltitude; }
+
+  float accelMag() const { return detAccelMag; }
+
+  // returns true once per DOWNLINK_DECIMATION samples
+  bool popDownlink(TelemetrySample &out) {
+    if (!hasOutput)
+      return false;
+    out = downlink;
+    hasOutput = false;
+    return true;
+  }
+
+private:
+  enum { CH_PRESSURE, CH_ALTITUDE, CH_AX, CH_AY, CH_AZ,
+         CH_GX, CH_GY, CH_GZ, FIR_CHANNELS };
+
+  static constexpr float ALTITUDE_SPIKE_M = 5.0f;
+
+  void pushEnv(int ch, float value) {
+    if (std::isnan(value))
+      return;
+    int32_t out;
+    if (envCic[ch].push((int32_t)lrintf(value * 100.0f), out))
+      envOut[ch] = out * 0.01f;
+  }
+
+  uint64_t delayedStamp(int group, int samples) const {
+    int idx = stampPos - 1 - samples;
+    while (idx < 0)
+      idx += FIR_TAPS;
+    return stamps[idx][group];
+  }
+
+  void processBlock() {
+    float out[FIR_CHANNELS];
+    for (int ch = 0; ch < FIR_CHANNELS; ch++)
+      fir[ch].process(block[ch], DOWNLINK_DECIMATION, &out[ch]);
+
+    const int firDelay = FIR_TAPS / 2;
+    const int cicDelay = CIC_ORDER * (DOWNLINK_DECIMATION - 1) / 2;
+
+    downlink = latest; // heading and GPS pass through
+    downlink.baro_us = delayedStamp(0, firDelay);
+    downlink.pressure = out[CH_PRESSURE];
+    downlink.altitude = out[CH_ALTITUDE];
+    downlink.imu_us = delayedStamp(2, firDelay);
+    downlink.ax = out[CH_AX];
+    downlink.ay = out[CH_AY];
+    downlink.az = out[CH_AZ];
+    downlink.gx = out[CH_GX];
+    downlink.gy = out[CH_GY];
+    downlink.gz = out[CH_GZ];
+    downlink.env_us = delayedStamp(1, cicDelay);
+    downlink.temp_bmp = envOut[0];
+    downlink.temp_dht = envOut[1];
+    downlink.humidity = envOut[2];
+    hasOutput = true;
+  }
+
+  // detection
+  filters::OutlierRejector<5> altitudeRejector;
+  filters::MovingAverage<4> altitudeAverage;
+  filters::MovingAverage<4> accelAverage;
+  float detAltitude = NAN;
+  float detAccelMag = NAN;
+
+  // downlink
+  filters::FirDecimator<FIR_TAPS, DOWNLINK_DECIMATION> fir[FIR_CHANNELS];
+  filters::CicDecimator<CIC_ORDER, DOWNLINK_DECIMATION> envCic[3];
+  float block[FIR_CHANNELS][DOWNLINK_DECIMATION];
+  int filled;
+  float envOut[3];
+  float lastTempDht, lastHumidity;
+  TelemetrySample latest;
+  TelemetrySample downlink;
+  bool hasOutput;
+
+  uint64_t stamps[FIR_TAPS][3];
+  int stampPos;
+};
+
+#endif // !FILTER_STAGE_H
@@ -0,0 +1,45 @@
+#ifndef FLIGHT_CHECKPOINT_H
+#define FLIGHT_CHECKPOINT_H
+
+#include <cstdint>
+
+// Flight state checkpointed into RTC slow memory, which survives watchdog,
+// panic and brownout resets (but not a power cycle). Two CRC-protected
+// slots are written alternately, so a reset in the middle of a save still
+// leaves the previous checkpoint intact.
+//
+// After a reset out of ASCENT, DESCENT or POSTLAND the firmware skips the
+// self-tests and calibration and picks the flight back up from here.
+
+// flags
+static const uint8_t CHECKPOINT_CALIBRATED = 0x01;
+static const uint8_t CHECKPOINT_POWERED_DOWN = 0x02;
+
+struct FlightCheckpoint {
+  uint8_t state; // FlightState
+  uint8_t flags;
+  uint8_t resets; // in-flight resets so far
+  uint8_t downlinkSeq;
+  uint8_t phase; // FlightPhase (flight_events.h)
+  uint8_t reserved;
+  uint16_t samplePeriodMs;
+  float initialAltitude;
+  float peakAltitude;
+  uint32_t msInPhase;
+  uint32_t logSequence;    // next log block sequence
+  uint32_t uplinkCounter;  // last accepted command counter
+};
+
+// true when this boot is a reset out of a flight in progress; cheap, so
+// setup() can decide early whether to skip the self-tests
+bool checkpointInFlight();
+
+// the checkpoint saved before this reset, if checkpointInFlight()
+bool checkpointLoad(FlightCheckpoint &cp);
+
+// a few hundred cycles; called once per state machine pass
+void checkpointSave(const FlightCheckpoint &cp);
+
+void checkpointClear();
+
+#endif // !FLIGHT_CHECKPOINT_H
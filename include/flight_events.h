@@ -0,0 +1,339 @@
+#ifndef FLIGHT_EVENTS_H
+#define FLIGHT_EVENTS_H
+
+#include "flight_state.h"
+#include <cmath>
+#include <cstdint>
+
+// Table-driven flight event detection. Every transition out of a phase
+// lists weighted criteria over a small kinematic estimate (altitude above
+// ground, vertical velocity, peak altitude, accel magnitude, time in phase).
+// A rule fires once the passing criteria carry enough weight for `debounce`
+// consecutive samples and at least `holdMs`. Each criterion also has
+// hysteresis: once true it stays true until its value falls back past the
+// threshold by that margin, so a noisy signal near the limit cannot flip
+// it on every sample.
+//
+// Only the rules leaving the current phase are evaluated, so one update is
+// bounded by MAX_RULES_PER_PHASE * MAX_CRITERIA checks. Fired events are
+// timestamped into a small journal.
+//
+// Plain C++ with no Arduino dependencies so the host trajectory simulation
+// (tools/flight_event_sim.cpp) runs the same code.
+
+enum FlightPhase : uint8_t {
+  PHASE_PAD,
+  PHASE_POWERED, // motor burning
+  PHASE_COAST,   // burnout to apogee
+  PHASE_DESCENT,
+  PHASE_LANDED,
+  PHASE_COUNT
+};
+
+enum FlightEvent : uint8_t {
+  EVENT_NONE,
+  EVENT_LAUNCH,
+  EVENT_BURNOUT,
+  EVENT_APOGEE,
+  EVENT_LANDING
+};
+
+enum CriterionType : uint8_t {
+  CRIT_ACCEL_ABOVE,      // g, smoothed accel magnitude
+  CRIT_ACCEL_BELOW,      //
+  CRIT_VELOCITY_ABOVE,   // m/s, vertical, up positive
+  CRIT_VELOCITY_BELOW,   //
+  CRIT_SPEED_BELOW,      // m/s, |vertical velocity|
+  CRIT_HEIGHT_ABOVE,     // m above the ground reference
+  CRIT_HEIGHT_BELOW,     //
+  CRIT_BELOW_PEAK,       // m below the highest altitude so far
+  CRIT_PHASE_TIME_ABOVE  // ms in the current phase
+};
+
+struct Criterion {
+  CriterionType type;
+  float threshold;
+  float hysteresis;
+  uint8_t weight;
+};
+
+struct TransitionRule {
+  FlightPhase from;
+  FlightPhase to;
+  FlightEvent event;
+  uint8_t votes;    // criterion weight needed
+  uint8_t debounce; // consecutive samples with enough votes
+  uint16_t holdMs;  // ... held for at least this long
+  uint8_t count;
+  Criterion criteria[4];
+};
+
+struct EventRecord {
+  FlightEvent event;
+  FlightPhase phase; // entered
+  uint32_t ms;       // engine clock
+  uint64_t stampUs;  // time base
+  float altitude;    // m above ground (NAN if uncalibrated)
+  float velocity;    // m/s
+};
+
+inline FlightState flightStateOf(FlightPhase phase) {
+  switch (phase) {
+  case PHASE_PAD:
+    return PRELAUNCH;
+  case PHASE_POWERED:
+  case PHASE_COAST:
+    return ASCENT;
+  case PHASE_DESCENT:
+    return DESCENT;
+  default:
+    return POSTLAND;
+  }
+}
+
+inline const char *flightEventName(FlightEvent event) {
+  static const char *names[] = {"none", "launch", "burnout", "apogee",
+                                "landing"};
+  return event <= EVENT_LANDING ? names[event] : "?";
+}
+
+class FlightEventEngine {
+public:
+  static const int MAX_CRITERIA = 4;
+  static const int MAX_RULES_PER_PHASE = 2;
+  static const int JOURNAL_SIZE = 8;
+
+  // alpha-beta tracker on the smoothed altitude, tuned for ~10 Hz
+  static constexpr float TRACK_ALPHA = 0.4f;
+  static constexpr float TRACK_BETA = 0.1f;
+  static const uint32_t MAX_TRACK_GAP_MS = 1000;
+
+  static const TransitionRule *rules(int &count) {
+    static const TransitionRule RULES[] = {
+        // launch: accel held for 250 ms, or height gain with climb rate;
+        // 2.2 g clears a 0.2 s 3 g knock on the pad, which averages to 2 g
+        {PHASE_PAD, PHASE_POWERED, EVENT_LAUNCH, 2, 3, 250, 3,
+         {{CRIT_ACCEL_ABOVE, 2.2f, 0.2f, 2},
+          {CRIT_HEIGHT_ABOVE, 10.0f, 2.0f, 1},
+          {CRIT_VELOCITY_ABOVE, 5.0f, 1.0f, 1}}},
+        // burnout: thrust gone while still climbing
+        {PHASE_POWERED, PHASE_COAST, EVENT_BURNOUT, 3, 3, 0, 3,
+         {{CRIT_ACCEL_BELOW, 0.8f, 0.1f, 2},
+          {CRIT_VELOCITY_ABOVE, 0.0f, 0.0f, 1},
+          {CRIT_PHASE_TIME_ABOVE, 300.0f, 0.0f, 1}}},
+        // apogee straight from powered if burnout was missed
+        {PHASE_POWERED, PHASE_DESCENT, EVENT_APOGEE, 4, 3, 0, 2,
+         {{CRIT_VELOCITY_BELOW, 0.0f, 0.5f, 2},
+          {CRIT_BELOW_PEAK, 3.0f, 0.5f, 2}}},
+        // apogee: falling and below the peak, both required
+        {PHASE_COAST, PHASE_DESCENT, EVENT_APOGEE, 4, 3, 0, 3,
+         {{CRIT_VELOCITY_BELOW, 0.0f, 0.5f, 2},
+          {CRIT_BELOW_PEAK, 2.0f, 0.5f, 2},
+          {CRIT_PHASE_TIME_ABOVE, 500.0f, 0.0f, 1}}},
+        // landing: slow and at ground height for 3 s; a slow descent
+        // under a big chute must not pass for it, so all three count
+        {PHASE_DESCENT, PHASE_LANDED, EVENT_LANDING, 4, 5, 3000, 3,
+         {{CRIT_SPEED_BELOW, 2.0f, 1.0f, 2},
+          {CRIT_HEIGHT_BELOW, 2.0f, 10.0f, 1},
+          {CRIT_PHASE_TIME_ABOVE, 2000.0f, 0.0f, 1}}},
+        // ... or no height to go by (ground unknown, or landed above it):
+        // vertical speed settled to zero for 3 s
+        {PHASE_DESCENT, PHASE_LANDED, EVENT_LANDING, 4, 5, 3000, 2,
+         {{CRIT_SPEED_BELOW, 0.5f, 0.5f, 3},
+          {CRIT_PHASE_TIME_ABOVE, 2000.0f, 0.0f, 1}}},
+    };
+    count = sizeof(RULES) / sizeof(RULES[0]);
+    return RULES;
+  }
+
+  FlightEventEngine() { reset(); }
+
+  void reset() {
+    currentPhase = PHASE_PAD;
+    phaseStartMs = 0;
+    ground = NAN;
+    trackAltitude = NAN;
+    velocity = 0.0f;
+    peak = -INFINITY;
+    accel = NAN;
+    lastMs = 0;
+    journalCount = 0;
+    enterPhase(PHASE_PAD, 0);
+  }
+
+  // ground reference (same frame as the altitudes pushed), NAN until known
+  void setGround(float groundAltitude) { ground = groundAltitude; }
+
+  // continue after a reset in flight
+  void resume(FlightPhase phase, uint32_t nowMs, uint32_t msInPhase,
+              float groundAltitude, float peakAltitude) {
+    ground = groundAltitude;
+    peak = std::isnan(peakAltitude) ? -INFINITY : peakAltitude;
+    trackAltitude = NAN;
+    enterPhase(phase, nowMs - msInPhase);
+  }
+
+  // One sample: monotonic ms, time base stamp, smoothed altitude and accel
+  // magnitude. Returns the event that fired, EVENT_NONE otherwise.
+  FlightEvent update(uint32_t nowMs, uint64_t stampUs, float altitude,
+                     float accelMag) {
+    track(nowMs, altitude);
+    accel = accelMag;
+
+    int n;
+    const TransitionRule *table = rules(n);
+    for (int r = 0; r < active; r++) {
+      const TransitionRule &rule = table[activeRules[r]];
+      RuleState &st = ruleState[r];
+      int votes = 0;
+      for (int c = 0; c < rule.count; c++) {
+        st.latched[c] = evaluate(rule.criteria[c], st.latched[c], nowMs);
+        if (st.latched[c])
+          votes += rule.criteria[c].weight;
+      }
+      if (votes < rule.votes) {
+        st.streak = 0;
+        continue;
+      }
+      if (st.streak == 0)
+        st.streakStartMs = nowMs;
+      if (st.streak < 255)
+        st.streak++;
+      if (st.streak >= rule.debounce &&
+          nowMs - st.streakStartMs >= rule.holdMs) {
+        record(rule.event, rule.to, nowMs, stampUs);
+        enterPhase(rule.to, nowMs);
+        return rule.event;
+      }
+    }
+    return EVENT_NONE;
+  }
+
+  FlightPhase phase() const { return currentPhase; }
+
+  uint32_t msInPhase(uint32_t nowMs) const { return nowMs - phaseStartMs; }
+
+  float verticalVelocity() const { return velocity; }
+
+  // highest tracked altitude, NAN before the first sample
+  float peakAltitude() const { return std::isinf(peak) ? NAN : peak; }
+
+  float heightAboveGround() const { return trackAltitude - ground; }
+
+  int journalSize() const {
+    return journalCount < JOURNAL_SIZE ? journalCount : JOURNAL_SIZE;
+  }
+
+  // oldest first
+  const EventRecord &journalAt(int i) const {
+    int first = journalCount < JOURNAL_SIZE ? 0 : journalCount % JOURNAL_SIZE;
+    return journal[(first + i) % JOURNAL_SIZE];
+  }
+
+private:
+  struct RuleState {
+    bool latched[MAX_CRITERIA];
+    uint8_t streak;
+    uint32_t streakStartMs;
+  };
+
+  void track(uint32_t nowMs, float altitude) {
+    if (std::isnan(altitude))
+      return;
+    uint32_t gap = nowMs - lastMs;
+    lastMs = nowMs;
+    if (std::isnan(trackAltitude) || gap == 0 || gap > MAX_TRACK_GAP_MS) {
+      trackAltitude = altitude; // (re)start, keep the velocity estimate
+    } else {
+      float dt = gap * 0.001f;
+      float predicted = trackAltitude + velocity * dt;
+      float residual = altitude - predicted;
+      trackAltitude = predicted + TRACK_ALPHA * residual;
+      velocity += TRACK_BETA * residual / dt;
+    }
+    if (trackAltitude > peak)
+      peak = trackAltitude;
+  }
+
+  // value of a criterion's signal; NAN when it is not known yet
+  float signal(CriterionType type, uint32_t nowMs) const {
+    switch (type) {
+    case CRIT_ACCEL_ABOVE:
+    case CRIT_ACCEL_BELOW:
+      return accel;
+    case CRIT_VELOCITY_ABOVE:
+    case CRIT_VELOCITY_BELOW:
+      return std::isnan(trackAltitude) ? NAN : velocity;
+    case CRIT_SPEED_BELOW:
+      return std::isnan(trackAltitude) ? NAN : fabsf(velocity);
+    case CRIT_HEIGHT_ABOVE:
+    case CRIT_HEIGHT_BELOW:
+      return trackAltitude - ground;
+    case CRIT_BELOW_PEAK:
+      return peak - trackAltitude;
+    case CRIT_PHASE_TIME_ABOVE:
+      return (float)(nowMs - phaseStartMs);
+    }
+    return NAN;
+  }
+
+  bool evaluate(const Criterion &c, bool wasTrue, uint32_t nowMs) const {
+    float v = signal(c.type, nowMs);
+    if (std::isnan(v))
+      return false;
+    bool below = c.type == CRIT_ACCEL_BELOW || c.type == CRIT_VELOCITY_BELOW ||
+                 c.type == CRIT_SPEED_BELOW || c.type == CRIT_HEIGHT_BELOW;
+    // a true criterion only clears past the threshold plus hysteresis
+    float limit = wasTrue ? (below ? c.threshold + c.hysteresis
+                                   : c.threshold - c.hysteresis)
+                          : c.threshold;
+    return below ? v < limit : v > limit;
+  }
+
+  void enterPhase(FlightPhase phase, uint32_t nowMs) {
+    currentPhase = phase;
+    phaseStartMs = nowMs;
+    int n;
+    const TransitionRule *table = rules(n);
+    active = 0;
+    for (int r = 0; r < n && active < MAX_RULES_PER_PHASE; r++) {
+      if (table[r].from != phase)
+        continue;
+      activeRules[active] = (uint8_t)r;
+      RuleState &st = ruleState[active++];
+      for (int c = 0; c < MAX_CRITERIA; c++)
+        st.latched[c] = false;
+      st.streak = 0;
+      st.streakStartMs = nowMs;
+    }
+  }
+
+  void record(FlightEvent event, FlightPhase to, uint32_t nowMs,
+              uint64_t stampUs) {
+    EventRecord &e = journal[journalCount++ % JOURNAL_SIZE];
+    e.event = event;
+    e.phase = to;
+    e.ms = nowMs;
+    e.stampUs = stampUs;
+    e.altitude = heightAboveGround();
+    e.velocity = velocity;
+  }
+
+  FlightPhase currentPhase;
+  uint32_t phaseStartMs;
+  uint8_t activeRules[MAX_RULES_PER_PHASE];
+  RuleState ruleState[MAX_RULES_PER_PHASE];
+  int active;
+
+  float ground;
+  float trackAltitude;
+  float velocity;
+  float peak;
+  float accel;
+  uint32_t lastMs;
+
+  EventRecord journal[JOURNAL_SIZE];
+  int journalCount;
+};
+
+#endif // !FLIGHT_EVENTS_H
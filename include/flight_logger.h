@@ -0,0 +1,65 @@
+#ifndef FLIGHT_LOGGER_H
+#define FLIGHT_LOGGER_H
+
+#include "memory_monitor.h"
+#include "sdcard_driver.h"
+#include "telemetry_sample.h"
+#include "vibration_spectrum.h"
+#include <cstdint>
+
+// Compressed SD flight log written from its own low-priority task. The
+// state machine only queues samples; encoding (log_codec.h) and SD writes
+// happen off the sensor loop, one 512-byte block at a time.
+//
+// With rawRegion set, blocks go straight to the raw log partition
+// (raw_log_region.h) instead of fileName, bypassing FAT; if the card has
+// no such partition the logger falls back to the file.
+//
+// resumeSequence continues the file log's block sequence after a reset in
+// flight; the raw region tracks its own. With mountCard the logger task
+// mounts the card itself before it drains the queue, so an in-flight
+// resume queues samples instead of waiting for the SD init.
+
+void flightLoggerInit(SDCard_Driver &sdcard, const char *fileName,
+                      bool rawRegion = false, uint32_t resumeSequence = 0,
+                      bool mountCard = false);
+
+// sequence the next block will carry
+uint32_t flightLoggerNextSequence();
+
+// true when logging to the raw partition
+bool flightLoggerIsRaw();
+
+// non-blocking; returns false (and counts a drop) when the queue is full
+bool flightLoggerPush(const TelemetrySample &s);
+
+// Vibration summaries go to their own file of fixed-size records
+// (vibration_spectrum.h), written a 512-byte batch at a time. Non-blocking;
+// false (and a drop) when the queue is full.
+bool flightLoggerPushVibration(const vibration::Summary &s);
+
+// Memory snapshots (memory_monitor.h) are appended to /memory.csv as text.
+// Non-blocking; false (and a drop) when the queue is full.
+bool flightLoggerPushMemory(const MemorySnapshot &s);
+
+// seal and write the partially filled block, e.g. after landing
+void flightLoggerFlush();
+
+// Ask the logger task to read back one stored block (by its index in the
+// file or raw region) for a downlink resend; false if one is in flight.
+bool flightLoggerRequestBlock(uint32_t index);
+
+// true once the requested block has been read; ok is false if it failed
+bool flightLoggerTakeBlock(uint32_t &index, uint8_t *block, bool &ok);
+
+// drops per queue, so a full vibration or memory queue doesn't read as
+// lost flight samples (the downlink's logDrops)
+uint32_t flightLoggerDropped();
+uint32_t flightLoggerVibrationDropped();
+uint32_t flightLoggerMemoryDropped();
+// flight samples in blocks the card failed to take (the file fallback
+// included); the downlink's logDrops counts these too
+uint32_t flightLoggerWriteLost();
+uint32_t flightLoggerBlocksWritten();
+
+#endif // !FLIGHT_LOGGER_H
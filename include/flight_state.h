@@ -0,0 +1,6 @@
+#ifndef FLIGHT_STATE_H
+#define FLIGHT_STATE_H
+
+enum FlightState { PRELAUNCH, ASCENT, DESCENT, POSTLAND };
+
+#endif // !FLIGHT_STATE_H
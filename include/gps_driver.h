@@ -1,6 +1,7 @@
 #ifndef GPS_DRIVER_H
 #define GPS_DRIVER_H
 
+#include "fast_math.h"
 #include <HardwareSerial.h>
 #include <TinyGPSPlus.h>
 #include <cstdint>
@@ -27,12 +28,48 @@ public:
 
   double longitude() { return gps.location.lng(); }
 
+  // fixed-point 1e-7 degrees, for the hot path (no double math)
+  int32_t latitudeE7() {
+    const RawDegrees &r = gps.location.rawLat();
+    return fastmath::degreesE7(r.deg, r.billionths, r.negative);
+  }
+
+  int32_t longitudeE7() {
+    const RawDegrees &r = gps.location.rawLng();
+    return fastmath::degreesE7(r.deg, r.billionths, r.negative);
+  }
+
   bool hasFix() { return gps.location.isValid(); }
 
+  bool hasAltitude() { return gps.altitude.isValid(); }
+
+  // meters above mean sea level
+  float altitudeMeters() { return (float)gps.altitude.meters(); }
+
   int satellites() { return gps.satellites.value(); }
 
   double hdop() { return gps.hdop.hdop(); }
 
+  bool timeUpdated() { return gps.time.isUpdated(); }
+
+  bool hasTime() { return gps.date.isValid() && gps.time.isValid(); }
+
+  // UTC seconds since 1970-01-01 of the last decoded NMEA time
+  uint32_t utcEpochSeconds() {
+    // days-from-civil, valid for any Gregorian date after 1970
+    int y = gps.date.year();
+    unsigned m = gps.date.month();
+    unsigned d = gps.date.day();
+    y -= m <= 2;
+    const int era = y / 400;
+    const unsigned yoe = (unsigned)(y - era * 400);
+    const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    const uint32_t days = (uint32_t)(era * 146097 + (int)doe - 719468);
+    return days * 86400UL + gps.time.hour() * 3600UL +
+           gps.time.minute() * 60UL + gps.time.second();
+  }
+
   void powerDown() {
     serial_gps.end(); // Close serial connection
   }
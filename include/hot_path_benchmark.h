@@ -0,0 +1,216 @@
+#ifndef HOT_PATH_BENCHMARK_H
+#define HOT_PATH_BENCHMARK_H
+
+#include "bench_report.h"
+#include "downlink_scheduler.h"
+#include "fast_math.h"
+#include "filter_stage.h"
+#include "flight_events.h"
+#include "log_codec.h"
+#include "uplink_protocol.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#if __has_include(<TinyGPSPlus.h>)
+#include <TinyGPSPlus.h>
+#define HOT_PATH_BENCH_NMEA 1
+#else
+#define HOT_PATH_BENCH_NMEA 0
+#endif
+
+// Per-call cost of everything the sensor loop runs on each sample, on a
+// synthetic ascent: log encoding, downlink frame building, uplink command
+// authentication, NMEA parsing, the altitude/heading math, the filter
+// stage and the flight event engine. Plain C++ on top of bench_report.h,
+// so it runs from setup() in the esp32dev_bench env and on the host
+// (tools/hot_path_bench.cpp); NMEA parsing needs TinyGPSPlus and is
+// target only.
+
+static const int HOT_PATH_BENCH_N = 2000;
+
+static volatile float hotPathSink;
+
+static void hotPathSample(int i, TelemetrySample &s) {
+  uint64_t t = 1700000000000000ULL + (uint64_t)i * 10000ULL; // 100 Hz
+  float alt = i < 200 ? 0.0f : 0.02f * (i - 200) * (i - 200);
+  s.utc = true;
+  s.baro_us = t;
+  s.env_us = t + 850;
+  s.imu_us = t + 1400;
+  s.mag_us = t + 1900;
+  s.gps_us = t + 2050;
+  s.temp_bmp = 21.3f - alt * 0.0065f;
+  s.pressure = 1013.25f * powf(1.0f - alt / 44330.0f, 5.255f);
+  s.altitude = alt + 0.3f * sinf(i * 0.7f);
+  s.temp_dht = 22.0f;
+  s.humidity = 48.0f;
+  s.ax = 0.03f * sinf(i * 1.3f);
+  s.ay = 0.02f * cosf(i * 1.1f);
+  s.az = i < 200 ? 1.0f : 4.0f + 0.2f * sinf(i * 0.9f);
+  s.gx = 0.01f * sinf(i * 0.2f);
+  s.gy = 0.01f * cosf(i * 0.2f);
+  s.gz = 0.5f;
+  s.heading = 123.0f + 0.01f * i;
+  s.lat_e7 = -338568000 + i;
+  s.lon_e7 = 1512153000 - i;
+}
+
+#if HOT_PATH_BENCH_NMEA
+// "$<body>*<checksum>\r\n"
+static size_t hotPathNmea(const char *body, char *out, size_t len) {
+  uint8_t sum = 0;
+  for (const char *p = body; *p; p++)
+    sum ^= (uint8_t)*p;
+  int n = snprintf(out, len, "$%s*%02X\r\n", body, sum);
+  return n > 0 ? (size_t)n : 0;
+}
+#endif
+
+void runHotPathBenchmark() {
+  static TelemetrySample samples[HOT_PATH_BENCH_N];
+  for (int i = 0; i < HOT_PATH_BENCH_N; i++)
+    hotPathSample(i, samples[i]);
+
+  BENCH_PRINTF("=== HOT PATH BENCHMARK (%s per call) ===\n", BENCH_TICK_UNIT);
+  uint32_t t0, ticks;
+
+  // log block encoder, the SD log's formatter
+  {
+    static logcodec::BlockEncoder encoder;
+    encoder.reset(0);
+    int blocks = 0;
+    t0 = benchTicks();
+    for (int i = 0; i < HOT_PATH_BENCH_N; i++)
+      blocks += encoder.push(samples[i]) ? 1 : 0;
+    ticks = benchTicks() - t0;
+    BENCH_PRINTF("  log encode       %8.1f /sample  %d blocks\n",
+                 (float)ticks / HOT_PATH_BENCH_N, blocks);
+    benchReportTicks("hotpath", "log_encode", ticks, HOT_PATH_BENCH_N);
+  }
+
+  // downlink frames, one per simulated second so messages are due
+  {
+    static DownlinkScheduler downlink(64, 0.25f);
+    downlink.resetSchedule(0); // the clock restarts with every run
+    uint8_t frame[255];
+    size_t bytes = 0;
+    int frames = 0;
+    ticks = 0;
+    for (int i = 0; i < HOT_PATH_BENCH_N; i++) {
+      uint32_t nowMs = (uint32_t)i * 1000;
+      t0 = benchTicks();
+      downlink.observe(samples[i], samples[i].altitude);
+      downlink.observeDownlink(samples[i]);
+      size_t len =
+          downlink.buildFrame(ASCENT, nowMs, samples[i].baro_us, frame);
+      ticks += benchTicks() - t0;
+      bytes += len;
+      frames += len ? 1 : 0;
+    }
+    if (frames) {
+      BENCH_PRINTF("  downlink frame   %8.1f /frame   %.1f bytes/frame\n",
+                   (float)ticks / frames, (float)bytes / frames);
+      benchReportTicks("hotpath", "downlink_frame", ticks, frames);
+      benchReport("hotpath", "downlink_frame_bytes", "B",
+                  (double)bytes / frames);
+    }
+  }
+
+  // uplink command authentication (SipHash-2-4 over a full command)
+  {
+    static const uint8_t key[uplink::KEY_BYTES] = {
+        1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16};
+    uint8_t args[uplink::MAX_ARG_BYTES];
+    memset(args, 0x5a, sizeof(args));
+    uint8_t buf[uplink::MAX_COMMAND_BYTES];
+    size_t len = uplink::encodeCommand(key, 1, uplink::CMD_PING, args,
+                                       sizeof(args), buf);
+    uplink::Command cmd;
+    int ok = 0;
+    t0 = benchTicks();
+    for (int i = 0; i < HOT_PATH_BENCH_N; i++)
+      ok += uplink::parseCommand(key, buf, len, cmd) == uplink::PARSE_OK;
+    ticks = benchTicks() - t0;
+    BENCH_PRINTF("  uplink verify    %8.1f /command (%d ok)\n",
+                 (float)ticks / HOT_PATH_BENCH_N, ok);
+    benchReportTicks("hotpath", "uplink_verify", ticks, HOT_PATH_BENCH_N);
+  }
+
+#if HOT_PATH_BENCH_NMEA
+  // NMEA at the 10 Hz, GGA + RMC mix the receiver sends
+  {
+    static char nmea[2][100];
+    size_t nmeaLen[2];
+    nmeaLen[0] = hotPathNmea("GPGGA,123519.00,3351.40800,S,15112.91800,E,1,"
+                             "09,0.9,545.4,M,46.9,M,,",
+                             nmea[0], sizeof(nmea[0]));
+    nmeaLen[1] = hotPathNmea("GPRMC,123519.00,A,3351.40800,S,15112.91800,E,"
+                             "0.004,77.52,230394,,,A",
+                             nmea[1], sizeof(nmea[1]));
+    static TinyGPSPlus gps;
+    size_t chars = 0;
+    t0 = benchTicks();
+    for (int i = 0; i < HOT_PATH_BENCH_N; i++) {
+      const char *s = nmea[i & 1];
+      for (size_t c = 0; c < nmeaLen[i & 1]; c++)
+        gps.encode(s[c]);
+      chars += nmeaLen[i & 1];
+    }
+    ticks = benchTicks() - t0;
+    hotPathSink = (float)gps.location.lat();
+    BENCH_PRINTF("  nmea parse       %8.1f /sentence  %.2f /char\n",
+                 (float)ticks / HOT_PATH_BENCH_N, (float)ticks / chars);
+    benchReportTicks("hotpath", "nmea_sentence", ticks, HOT_PATH_BENCH_N);
+  }
+#endif
+
+  // altitude and heading as acquireSample() computes them
+  {
+    t0 = benchTicks();
+    for (int i = 0; i < HOT_PATH_BENCH_N; i++)
+      hotPathSink = fastmath::baroAltitudeRatio(samples[i].pressure *
+                                                (1.0f / 1013.25f));
+    ticks = benchTicks() - t0;
+    BENCH_PRINTF("  altitude         %8.1f /call\n",
+                 (float)ticks / HOT_PATH_BENCH_N);
+    benchReportTicks("hotpath", "altitude", ticks, HOT_PATH_BENCH_N);
+
+    t0 = benchTicks();
+    for (int i = 0; i < HOT_PATH_BENCH_N; i++)
+      hotPathSink = fastmath::headingDeg(samples[i].ay, samples[i].ax);
+    ticks = benchTicks() - t0;
+    BENCH_PRINTF("  heading          %8.1f /call\n",
+                 (float)ticks / HOT_PATH_BENCH_N);
+    benchReportTicks("hotpath", "heading", ticks, HOT_PATH_BENCH_N);
+  }
+
+  // filter stage and event engine, in stateMachineUpdate() order
+  {
+    static TelemetryFilterStage stage;
+    static FlightEventEngine events;
+    events.reset();
+    events.setGround(0.0f);
+    TelemetrySample d;
+    uint32_t filterTicks = 0, eventTicks = 0;
+    for (int i = 0; i < HOT_PATH_BENCH_N; i++) {
+      t0 = benchTicks();
+      stage.push(samples[i]);
+      stage.popDownlink(d);
+      filterTicks += benchTicks() - t0;
+      t0 = benchTicks();
+      events.update((uint32_t)i * 10, samples[i].baro_us, stage.altitude(),
+                    stage.accelMag());
+      eventTicks += benchTicks() - t0;
+    }
+    BENCH_PRINTF("  filter stage     %8.1f /sample\n",
+                 (float)filterTicks / HOT_PATH_BENCH_N);
+    BENCH_PRINTF("  flight events    %8.1f /sample  (%d events fired)\n",
+                 (float)eventTicks / HOT_PATH_BENCH_N, events.journalSize());
+    benchReportTicks("hotpath", "filter_stage", filterTicks,
+                     HOT_PATH_BENCH_N);
+    benchReportTicks("hotpath", "flight_events", eventTicks,
+                     HOT_PATH_BENCH_N);
+  }
+}
+
+#endif // !HOT_PATH_BENCHMARK_H
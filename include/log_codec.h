@@ -0,0 +1,320 @@
+#ifndef LOG_CODEC_H
+#define LOG_CODEC_H
+
+#include "telemetry_sample.h"
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include <rom/crc.h>
+#endif
+
+// Binary flight log codec. Samples are quantized to integers per channel,
+// delta-coded against the previous sample, zigzag mapped and written as
+// LEB128 varints. Output is a sequence of fixed 512-byte (one SD sector)
+// blocks; the first sample of every block is coded against zero, so each
+// block decodes on its own and a torn write only loses that block.
+//
+// Block layout (little endian):
+//   u16 magic, u8 version, u8 sample count, u32 block sequence,
+//   u16 payload length, u16 reserved, u32 CRC-32 of the payload,
+//   payload, zero padding
+//
+// Plain C++ with no Arduino dependencies so the host decoder
+// (tools/flight_log_decode.cpp) shares it.
+
+namespace logcodec {
+
+static const uint16_t BLOCK_MAGIC = 0x4C46; // "FL"
+static const uint8_t FORMAT_VERSION = 1;
+static const size_t BLOCK_BYTES = 512;
+static const size_t HEADER_BYTES = 16;
+static const size_t PAYLOAD_BYTES = BLOCK_BYTES - HEADER_BYTES;
+static const int MAX_SAMPLES_PER_BLOCK = 255;
+
+// quantized channels, in stream order
+enum Channel {
+  CH_ENV_OFFSET, // us relative to baro_us
+  CH_IMU_OFFSET,
+  CH_MAG_OFFSET,
+  CH_GPS_OFFSET,
+  CH_TEMP_BMP,   // 0.01 C
+  CH_PRESSURE,   // 0.01 hPa
+  CH_ALTITUDE,   // 0.01 m
+  CH_TEMP_DHT,   // 0.01 C
+  CH_HUMIDITY,   // 0.01 %
+  CH_AX,         // 0.001 g
+  CH_AY,
+  CH_AZ,
+  CH_GX,         // 0.001 rad/s
+  CH_GY,
+  CH_GZ,
+  CH_HEADING,    // 0.01 deg
+  CH_LAT,        // 1e-7 deg
+  CH_LON,
+  CH_FLAGS,      // bit 0: timestamps are GPS UTC
+  CHANNELS
+};
+
+// stands in for NaN readings (DHT11 dropouts)
+static const int32_t NAN_CODE = INT32_MIN;
+
+// 10 bytes for the timestamp delta, 5 per channel
+static const size_t MAX_SAMPLE_BYTES = 10 + 5 * CHANNELS;
+
+inline uint32_t crc32(const uint8_t *data, size_t len) {
+#if defined(ARDUINO_ARCH_ESP32)
+  return crc32_le(0, data, len); // ROM table implementation
+#else
+  static const uint32_t nibble[16] = {
+      0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4,
+      0x4DB26158, 0x5005713C, 0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+      0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C};
+  uint32_t crc = 0xFFFFFFFFu;
+  for (size_t i = 0; i < len; i++) {
+    crc ^= data[i];
+    crc = (crc >> 4) ^ nibble[crc & 0x0F];
+    crc = (crc >> 4) ^ nibble[crc & 0x0F];
+  }
+  return ~crc;
+#endif
+}
+
+inline uint32_t zigzag(int32_t v) {
+  return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+inline int32_t unzigzag(uint32_t v) {
+  return (int32_t)(v >> 1) ^ -(int32_t)(v & 1);
+}
+
+inline uint64_t zigzag64(int64_t v) {
+  return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+}
+
+inline int64_t unzigzag64(uint64_t v) {
+  return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+}
+
+inline size_t putVarint(uint8_t *out, uint64_t v) {
+  size_t n = 0;
+  while (v >= 0x80) {
+    out[n++] = (uint8_t)(v | 0x80);
+    v >>= 7;
+  }
+  out[n++] = (uint8_t)v;
+  return n;
+}
+
+// returns bytes consumed, 0 on a truncated or overlong varint
+inline size_t getVarint(const uint8_t *in, size_t avail, uint64_t &v) {
+  v = 0;
+  for (size_t n = 0; n < avail && n < 10; n++) {
+    v |= (uint64_t)(in[n] & 0x7F) << (7 * n);
+    if (!(in[n] & 0x80))
+      return n + 1;
+  }
+  return 0;
+}
+
+inline int32_t quantize(float v, float scale) {
+  if (std::isnan(v))
+    return NAN_CODE;
+  return (int32_t)lrintf(v * scale);
+}
+
+inline float dequantize(int32_t v, float scale) {
+  return v == NAN_CODE ? NAN : v / scale;
+}
+
+inline void quantizeSample(const TelemetrySample &s, int32_t *q) {
+  q[CH_ENV_OFFSET] = (int32_t)(s.env_us - s.baro_us);
+  q[CH_IMU_OFFSET] = (int32_t)(s.imu_us - s.baro_us);
+  q[CH_MAG_OFFSET] = (int32_t)(s.mag_us - s.baro_us);
+  q[CH_GPS_OFFSET] = (int32_t)(s.gps_us - s.baro_us);
+  q[CH_TEMP_BMP] = quantize(s.temp_bmp, 100.0f);
+  q[CH_PRESSURE] = quantize(s.pressure, 100.0f);
+  q[CH_ALTITUDE] = quantize(s.altitude, 100.0f);
+  q[CH_TEMP_DHT] = quantize(s.temp_dht, 100.0f);
+  q[CH_HUMIDITY] = quantize(s.humidity, 100.0f);
+  q[CH_AX] = quantize(s.ax, 1000.0f);
+  q[CH_AY] = quantize(s.ay, 1000.0f);
+  q[CH_AZ] = quantize(s.az, 1000.0f);
+  q[CH_GX] = quantize(s.gx, 1000.0f);
+  q[CH_GY] = quantize(s.gy, 1000.0f);
+  q[CH_GZ] = quantize(s.gz, 1000.0f);
+  q[CH_HEADING] = quantize(s.heading, 100.0f);
+  q[CH_LAT] = s.lat_e7;
+  q[CH_LON] = s.lon_e7;
+  q[CH_FLAGS] = s.utc ? 1 : 0;
+}
+
+inline void dequantizeSample(uint64_t t, const int32_t *q,
+                             TelemetrySample &s) {
+  s.baro_us = t;
+  s.env_us = t + (int64_t)q[CH_ENV_OFFSET];
+  s.imu_us = t + (int64_t)q[CH_IMU_OFFSET];
+  s.mag_us = t + (int64_t)q[CH_MAG_OFFSET];
+  s.gps_us = t + (int64_t)q[CH_GPS_OFFSET];
+  s.temp_bmp = dequantize(q[CH_TEMP_BMP], 100.0f);
+  s.pressure = dequantize(q[CH_PRESSURE], 100.0f);
+  s.altitude = dequantize(q[CH_ALTITUDE], 100.0f);
+  s.temp_dht = dequantize(q[CH_TEMP_DHT], 100.0f);
+  s.humidity = dequantize(q[CH_HUMIDITY], 100.0f);
+  s.ax = dequantize(q[CH_AX], 1000.0f);
+  s.ay = dequantize(q[CH_AY], 1000.0f);
+  s.az = dequantize(q[CH_AZ], 1000.0f);
+  s.gx = dequantize(q[CH_GX], 1000.0f);
+  s.gy = dequantize(q[CH_GY], 1000.0f);
+  s.gz = dequantize(q[CH_GZ], 1000.0f);
+  s.heading = dequantize(q[CH_HEADING], 100.0f);
+  s.lat_e7 = q[CH_LAT];
+  s.lon_e7 = q[CH_LON];
+  s.utc = q[CH_FLAGS] & 1;
+}
+
+inline void put16(uint8_t *p, uint16_t v) {
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+}
+
+inline void put32(uint8_t *p, uint32_t v) {
+  put16(p, (uint16_t)v);
+  put16(p + 2, (uint16_t)(v >> 16));
+}
+
+inline uint16_t get16(const uint8_t *p) {
+  return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+inline uint32_t get32(const uint8_t *p) {
+  return get16(p) | ((uint32_t)get16(p + 2) << 16);
+}
+
+class BlockEncoder {
+public:
+  BlockEncoder() { reset(0); }
+
+  void reset(uint32_t nextSequence) {
+    seq = nextSequence;
+    startBlock();
+  }
+
+  // Appends a sample. When it does not fit, the current block is sealed
+  // and returned (BLOCK_BYTES long) and the sample opens the next block.
+  const uint8_t *push(const TelemetrySample &s) {
+    int32_t q[CHANNELS];
+    quantizeSample(s, q);
+
+    uint8_t tmp[MAX_SAMPLE_BYTES];
+    size_t n = encode(s.baro_us, q, tmp);
+    const uint8_t *sealed = nullptr;
+    if (used + n > PAYLOAD_BYTES || count == MAX_SAMPLES_PER_BLOCK) {
+      sealed = seal();
+      n = encode(s.baro_us, q, tmp); // now against zero
+    }
+    memcpy(&block[HEADER_BYTES + used], tmp, n);
+    used += n;
+    count++;
+    prevTime = s.baro_us;
+    memcpy(prev, q, sizeof(prev));
+    return sealed;
+  }
+
+  // seals a partially filled block, nullptr when it is empty
+  const uint8_t *flush() { return count ? seal() : nullptr; }
+
+  size_t pendingSamples() const { return count; }
+
+  uint32_t nextSequence() const { return seq; }
+
+private:
+  size_t encode(uint64_t t, const int32_t *q, uint8_t *out) const {
+    size_t n = putVarint(out, zigzag64((int64_t)(t - prevTime)));
+    for (int c = 0; c < CHANNELS; c++)
+      n += putVarint(out + n, zigzag((int32_t)((uint32_t)q[c] -
+                                               (uint32_t)prev[c])));
+    return n;
+  }
+
+  const uint8_t *seal() {
+    uint8_t *h = block;
+    put16(h, BLOCK_MAGIC);
+    h[2] = FORMAT_VERSION;
+    h[3] = (uint8_t)count;
+    put32(h + 4, seq++);
+    put16(h + 8, (uint16_t)used);
+    put16(h + 10, 0);
+    put32(h + 12, crc32(&block[HEADER_BYTES], used));
+    memset(&block[HEADER_BYTES + used], 0, PAYLOAD_BYTES - used);
+    memcpy(sealedBlock, block, BLOCK_BYTES);
+    startBlock();
+    return sealedBlock;
+  }
+
+  void startBlock() {
+    used = 0;
+    count = 0;
+    prevTime = 0;
+    memset(prev, 0, sizeof(prev));
+  }
+
+  uint8_t block[BLOCK_BYTES];
+  uint8_t sealedBlock[BLOCK_BYTES];
+  size_t used;
+  int count;
+  uint32_t seq;
+  uint64_t prevTime;
+  int32_t prev[CHANNELS];
+};
+
+// magic, version and payload CRC check without decoding
+inline bool isValidBlock(const uint8_t *block, uint32_t *sequence = nullptr) {
+  if (get16(block) != BLOCK_MAGIC || block[2] != FORMAT_VERSION)
+    return false;
+  size_t len = get16(block + 8);
+  if (len > PAYLOAD_BYTES ||
+      crc32(block + HEADER_BYTES, len) != get32(block + 12))
+    return false;
+  if (sequence)
+    *sequence = get32(block + 4);
+  return true;
+}
+
+// Decodes one block into out[] (room for MAX_SAMPLES_PER_BLOCK). Returns the
+// sample count, or -1 when the block is not a valid, intact log block.
+inline int decodeBlock(const uint8_t *block, TelemetrySample *out,
+                       uint32_t *sequence = nullptr) {
+  if (!isValidBlock(block, sequence))
+    return -1;
+  int count = block[3];
+  size_t len = get16(block + 8);
+
+  const uint8_t *p = block + HEADER_BYTES;
+  const uint8_t *end = p + len;
+  uint64_t t = 0;
+  int32_t q[CHANNELS] = {0};
+  for (int i = 0; i < count; i++) {
+    uint64_t v;
+    size_t n = getVarint(p, end - p, v);
+    if (!n)
+      return -1;
+    p += n;
+    t += (uint64_t)unzigzag64(v);
+    for (int c = 0; c < CHANNELS; c++) {
+      n = getVarint(p, end - p, v);
+      if (!n)
+        return -1;
+      p += n;
+      q[c] = (int32_t)((uint32_t)q[c] + (uint32_t)unzigzag((uint32_t)v));
+    }
+    dequantizeSample(t, q, out[i]);
+  }
+  return count;
+}
+
+} // namespace logcodec
+
+#endif // !LOG_CODEC_H
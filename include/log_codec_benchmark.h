@@ -0,0 +1,96 @@
+#ifndef LOG_CODEC_BENCHMARK_H
+#define LOG_CODEC_BENCHMARK_H
+
+#include "bench_report.h"
+#include "log_codec.h"
+#include <Arduino.h>
+
+// On-target size and CPU cost of the flight log codec on a synthetic
+// ascent, compared with the CSV line it replaces. Run from setup() in the
+// esp32dev_bench env.
+
+static const int LOG_BENCH_SAMPLES = 2000;
+
+static void synthSample(int i, TelemetrySample &s) {
+  uint64_t t = 1700000000000000ULL + (uint64_t)i * 1000ULL; // 1 kHz
+  s.utc = true;
+  s.baro_us = t;
+  s.env_us = t + 850;
+  s.imu_us = t + 1400;
+  s.mag_us = t + 1900;
+  s.gps_us = t + 2050;
+  s.temp_bmp = 21.3f - i * 0.0005f;
+  s.pressure = 1013.25f - i * 0.012f;
+  s.altitude = i * 0.1f + 0.05f * sinf(i * 0.7f);
+  s.temp_dht = 22.0f;
+  s.humidity = 48.0f;
+  s.ax = 0.03f * sinf(i * 1.3f);
+  s.ay = 0.02f * cosf(i * 1.1f);
+  s.az = 3.0f + 0.2f * sinf(i * 0.9f);
+  s.gx = 0.01f * sinf(i * 0.2f);
+  s.gy = 0.01f * cosf(i * 0.2f);
+  s.gz = 0.5f;
+  s.heading = 123.0f + 0.01f * i;
+  s.lat_e7 = 123456789 + i / 10;
+  s.lon_e7 = -987654321 - i / 12;
+}
+
+void runLogCodecBenchmark() {
+  static logcodec::BlockEncoder encoder;
+  static TelemetrySample decoded[logcodec::MAX_SAMPLES_PER_BLOCK];
+  static uint8_t lastBlock[logcodec::BLOCK_BYTES];
+  encoder.reset(0);
+
+  Serial.println("=== LOG CODEC BENCHMARK ===");
+  uint32_t encodeCycles = 0, decodeCycles = 0, csvBytes = 0;
+  int blocks = 0;
+  TelemetrySample s;
+  char line[200];
+  for (int i = 0; i < LOG_BENCH_SAMPLES; i++) {
+    synthSample(i, s);
+    csvBytes += snprintf(
+        line, sizeof(line),
+        "%llu,%.2f,%.2f,%.2f,%ld,%.2f,%.2f,%ld,%.2f,%.2f,%.2f,%ld,%.2f,%ld,"
+        "%.7f,%.7f,1\n",
+        (unsigned long long)s.baro_us, s.temp_bmp, s.pressure, s.altitude,
+        (long)(s.env_us - s.baro_us), s.temp_dht, s.humidity,
+        (long)(s.imu_us - s.baro_us), s.ax, s.ay, s.az,
+        (long)(s.mag_us - s.baro_us), s.heading, (long)(s.gps_us - s.baro_us),
+        s.lat_e7 * 1e-7, s.lon_e7 * 1e-7);
+
+    uint32_t t0 = ESP.getCycleCount();
+    const uint8_t *block = encoder.push(s);
+    encodeCycles += ESP.getCycleCount() - t0;
+    if (block) {
+      memcpy(lastBlock, block, sizeof(lastBlock));
+      t0 = ESP.getCycleCount();
+      logcodec::decodeBlock(lastBlock, decoded);
+      decodeCycles += ESP.getCycleCount() - t0;
+      blocks++;
+    }
+  }
+
+  if (!blocks) {
+    Serial.println("  no block sealed");
+    return;
+  }
+  float stored = (float)blocks * logcodec::BLOCK_BYTES /
+                 (LOG_BENCH_SAMPLES - encoder.pendingSamples());
+  Serial.printf("  csv            %6.1f bytes/sample\n",
+                (float)csvBytes / LOG_BENCH_SAMPLES);
+  Serial.printf("  compressed     %6.1f bytes/sample (incl. block padding)\n",
+                stored);
+  Serial.printf("  ratio          %6.2fx\n",
+                (float)csvBytes / LOG_BENCH_SAMPLES / stored);
+  Serial.printf("  encode         %6lu cycles/block, %5lu cycles/sample\n",
+                (unsigned long)(encodeCycles / blocks),
+                (unsigned long)(encodeCycles / LOG_BENCH_SAMPLES));
+  Serial.printf("  decode + crc   %6lu cycles/block\n",
+                (unsigned long)(decodeCycles / blocks));
+  benchReportTicks("log_codec", "encode_sample", encodeCycles,
+                   LOG_BENCH_SAMPLES);
+  benchReportTicks("log_codec", "decode_block", decodeCycles, blocks);
+  benchReport("log_codec", "stored_sample", "B", stored);
+}
+
+#endif // !LOG_CODEC_BENCHMARK_H
@@ -0,0 +1,71 @@
+#ifndef LOOPBACK_RADIO_H
+#define LOOPBACK_RADIO_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// In-memory stand-in for LoRaDriver so the command/ack cycle runs on the
+// host (tools/uplink_loopback.cpp). Two instances are linked as the payload
+// and ground ends; a packet sent on one is delivered to the other, but only
+// if the receiver is listening at that moment, like a real half-duplex
+// link.
+class LoopbackRadio {
+public:
+  static const size_t MAX_PAYLOAD = 255;
+
+  LoopbackRadio()
+      : peer(nullptr), listening(false), pendingLen(0), sent(0), lost(0) {}
+
+  void link(LoopbackRadio &other) {
+    peer = &other;
+    other.peer = this;
+  }
+
+  bool sendPacket(const uint8_t *buffer, size_t length) {
+    if (!peer || length > MAX_PAYLOAD)
+      return false;
+    sent++;
+    listening = false; // transmitting leaves receive mode
+    if (!peer->listening || peer->pendingLen) {
+      lost++;
+      return true;
+    }
+    memcpy(peer->pending, buffer, length);
+    peer->pendingLen = length;
+    return true;
+  }
+
+  void startReceive() { listening = true; }
+
+  void stopReceive() { listening = false; }
+
+  int receivePacket(uint8_t *buffer, size_t maxLen) {
+    if (!pendingLen)
+      return 0;
+    size_t n = pendingLen < maxLen ? pendingLen : maxLen;
+    memcpy(buffer, pending, n);
+    pendingLen = 0;
+    listening = false;
+    return (int)n;
+  }
+
+  // same figure as LoRaDriver at SF7/125 kHz, 4/5, 8 preamble symbols
+  uint32_t airtimeUs(size_t payloadLen) const {
+    int blocks = ((int)(8 * payloadLen) + 27) / 28;
+    return 12544 + (8 + blocks * 5) * 1024;
+  }
+
+  uint32_t packetsSent() const { return sent; }
+  uint32_t packetsLost() const { return lost; }
+
+private:
+  LoopbackRadio *peer;
+  bool listening;
+  uint8_t pending[MAX_PAYLOAD];
+  size_t pendingLen;
+  uint32_t sent;
+  uint32_t lost;
+};
+
+#endif // !LOOPBACK_RADIO_H
@@ -1,27 +1,38 @@
 #ifndef LORA_DRIVER_H
 #define LORA_DRIVER_H
 
+#include "debug_log.h"
 #include <Arduino.h>
 #include <LoRa.h>
 #include <SPI.h>
 #include <cstddef>
 #include <cstdint>
+#include <esp_timer.h>
 
 class LoRaDriver {
 public:
+  // SX127x FIFO limit for one explicit-header packet
+  static const size_t MAX_PAYLOAD = 255;
+
   LoRaDriver(uint8_t csPin, uint8_t rstPin, uint8_t dio0Pin,
              long frequency = 433E6)
       : _csPin(csPin), _rstPin(rstPin), _dio0Pin(dio0Pin),
-        _frequency(frequency), _initialized(false) {}
+        _frequency(frequency), _initialized(false), _sf(7),
+        _bandwidth(125E3), _codingRate4(5), _preamble(8), _crc(false),
+        _rxDone(false), _rxDoneUs(0), _isrAttached(false) {}
 
   bool begin() {
     LoRa.setPins(_csPin, _rstPin, _dio0Pin);
     if (!LoRa.begin(_frequency)) {
-      Serial.println("LoRa init failed. Check wiring.");
+      DLOG_ERROR("LoRa init failed. Check wiring.");
       _initialized = false;
       return false;
     }
-    Serial.println("LoRa initialized");
+    applyProfile();
+    LoRa.setPreambleLength(_preamble);
+    if (_crc)
+      LoRa.enableCrc();
+    DLOG_INFO("LoRa initialized");
     _initialized = true;
     return true;
   }
@@ -33,7 +44,7 @@ public:
     LoRa.beginPacket();
     LoRa.print(data);
     LoRa.endPacket();
-    Serial.println("Packet sent: " + data);
+    DLOG_DEBUG("Packet sent: %u bytes", data.length());
     return true;
   }
 
@@ -44,16 +55,123 @@ public:
     LoRa.beginPacket();
     LoRa.write(buffer, length);
     LoRa.endPacket();
-    Serial.println("Binary packet sent.");
+    DLOG_DEBUG("Binary packet sent: %u bytes", length);
     return true;
   }
 
   bool isInitialized() const { return _initialized; }
 
+  // Continuous receive; DIO0 signals RX done through our own interrupt so
+  // the FIFO is read from task context, not from the ISR
+  void startReceive() {
+    if (!_initialized)
+      return;
+    if (!_isrAttached) {
+      pinMode(_dio0Pin, INPUT);
+      attachInterruptArg(digitalPinToInterrupt(_dio0Pin), onDio0, this,
+                         RISING);
+      _isrAttached = true;
+    }
+    _rxDone = false;
+    LoRa.receive();
+  }
+
+  void stopReceive() {
+    if (_initialized)
+      LoRa.idle();
+  }
+
+  // lowest power mode that keeps the configuration; the next
+  // sendPacket() or startReceive() wakes the radio
+  void sleep() {
+    if (_initialized)
+      LoRa.sleep();
+  }
+
+  // Copies a received packet into buffer; returns its length, 0 when
+  // nothing arrived and -1 for a bad or oversized packet. The radio is
+  // idle afterwards.
+  int receivePacket(uint8_t *buffer, size_t maxLen) {
+    if (!_rxDone)
+      return 0;
+    _rxDone = false;
+    int size = LoRa.parsePacket();
+    if (size <= 0 || (size_t)size > maxLen) {
+      LoRa.idle();
+      return -1;
+    }
+    for (int i = 0; i < size; i++)
+      buffer[i] = (uint8_t)LoRa.read();
+    DLOG_DEBUG("Packet received: %d bytes, RSSI %d", size, LoRa.packetRssi());
+    return size;
+  }
+
+  // esp_timer time the last packet finished arriving (DIO0 edge)
+  int64_t lastRxUs() const { return _rxDoneUs; }
+
+  // change the modem profile, e.g. on ground command
+  static bool isValidProfile(uint8_t sf, long bandwidth,
+                             uint8_t codingRate4) {
+    return sf >= 6 && sf <= 12 && codingRate4 >= 5 && codingRate4 <= 8 &&
+           bandwidth >= 7800 && bandwidth <= 500000;
+  }
+
+  bool setProfile(uint8_t sf, long bandwidth, uint8_t codingRate4) {
+    if (!isValidProfile(sf, bandwidth, codingRate4))
+      return false;
+    _sf = sf;
+    _bandwidth = bandwidth;
+    _codingRate4 = codingRate4;
+    if (_initialized)
+      applyProfile();
+    DLOG_INFO("LoRa profile SF%u BW%ld CR4/%u", sf, bandwidth, codingRate4);
+    return true;
+  }
+
+  // time on air of an explicit-header packet (Semtech SX127x datasheet)
+  uint32_t airtimeUs(size_t payloadLen) const {
+    const uint32_t symbolUs = (uint32_t)((1000000LL << _sf) / _bandwidth);
+    const int lowDataRate = symbolUs > 16000 ? 1 : 0;
+    int numerator = 8 * (int)payloadLen - 4 * _sf + 28 + (_crc ? 16 : 0);
+    int denominator = 4 * (_sf - 2 * lowDataRate);
+    int blocks = numerator > 0 ? (numerator + denominator - 1) / denominator
+                               : 0;
+    uint32_t payloadSymbols = 8 + blocks * _codingRate4;
+    // preamble is (n + 4.25) symbols
+    return (_preamble + 4) * symbolUs + symbolUs / 4 +
+           payloadSymbols * symbolUs;
+  }
+
+  uint8_t spreadingFactor() const { return _sf; }
+
+  long bandwidth() const { return _bandwidth; }
+
 private:
+  void applyProfile() {
+    LoRa.setSpreadingFactor(_sf);
+    LoRa.setSignalBandwidth(_bandwidth);
+    LoRa.setCodingRate4(_codingRate4);
+  }
+
+  static void IRAM_ATTR onDio0(void *arg) {
+    static_cast<LoRaDriver *>(arg)->_rxDoneUs = esp_timer_get_time();
+    static_cast<LoRaDriver *>(arg)->_rxDone = true;
+  }
+
   uint8_t _csPin, _rstPin, _dio0Pin;
   long _frequency;
   bool _initialized;
+
+  // modem profile, kept here so airtimeUs() matches what is configured
+  uint8_t _sf;
+  long _bandwidth;
+  uint8_t _codingRate4; // denominator of the 4/x coding rate
+  uint16_t _preamble;
+  bool _crc;
+
+  volatile bool _rxDone;
+  volatile int64_t _rxDoneUs;
+  bool _isrAttached;
 };
 
 #endif // !LORA_DRIVER_H
@@ -0,0 +1,115 @@
+#ifndef MATH_BENCHMARK_H
+#define MATH_BENCHMARK_H
+
+#include "bench_report.h"
+#include "fast_math.h"
+#include <Arduino.h>
+#include <math.h>
+
+// On-target timing and accuracy of the fast_math kernels against the libm
+// double versions they replace. Run from setup() in the esp32dev_bench env.
+
+static const int MATH_BENCH_N = 256;
+static const int MATH_BENCH_ROUNDS = 20;
+
+static volatile float benchSinkF;
+static volatile double benchSinkD;
+
+static void printBenchRow(const char *name, uint32_t refCycles,
+                          uint32_t fastCycles, double maxErr,
+                          const char *unit) {
+  const float calls = (float)(MATH_BENCH_N * MATH_BENCH_ROUNDS);
+  Serial.printf("  %-14s libm %7.1f cyc  fast %6.1f cyc  x%4.1f  max err %.3g %s\n",
+                name, refCycles / calls, fastCycles / calls,
+                (float)refCycles / (float)fastCycles, maxErr, unit);
+  benchReportTicks("math", name, fastCycles, MATH_BENCH_N * MATH_BENCH_ROUNDS);
+}
+
+void runMathBenchmark() {
+  static float xs[MATH_BENCH_N], ys[MATH_BENCH_N], ps[MATH_BENCH_N];
+  for (int i = 0; i < MATH_BENCH_N; i++) {
+    float a = -3.1f + 6.2f * i / MATH_BENCH_N;
+    xs[i] = 40.0f * cosf(a);
+    ys[i] = 40.0f * sinf(a);
+    ps[i] = 300.0f + 800.0f * i / MATH_BENCH_N; // hPa
+  }
+
+  Serial.println("=== MATH KERNEL BENCHMARK ===");
+  uint32_t t0, ref, fast;
+  double err;
+
+  // atan2 / heading
+  t0 = ESP.getCycleCount();
+  for (int r = 0; r < MATH_BENCH_ROUNDS; r++)
+    for (int i = 0; i < MATH_BENCH_N; i++)
+      benchSinkD = atan2(ys[i], xs[i]) * 180.0 / PI;
+  ref = ESP.getCycleCount() - t0;
+  t0 = ESP.getCycleCount();
+  for (int r = 0; r < MATH_BENCH_ROUNDS; r++)
+    for (int i = 0; i < MATH_BENCH_N; i++)
+      benchSinkF = fastmath::headingDeg(ys[i], xs[i]);
+  fast = ESP.getCycleCount() - t0;
+  err = 0.0;
+  for (int i = 0; i < MATH_BENCH_N; i++) {
+    double h = atan2(ys[i], xs[i]) * 180.0 / PI;
+    if (h < 0)
+      h += 360.0;
+    err = fmax(err, fabs(fastmath::headingDeg(ys[i], xs[i]) - h));
+  }
+  printBenchRow("heading", ref, fast, err, "deg");
+
+  // barometric altitude
+  t0 = ESP.getCycleCount();
+  for (int r = 0; r < MATH_BENCH_ROUNDS; r++)
+    for (int i = 0; i < MATH_BENCH_N; i++)
+      benchSinkD = 44330.0 * (1.0 - pow(ps[i] / 1013.25, 0.190295));
+  ref = ESP.getCycleCount() - t0;
+  t0 = ESP.getCycleCount();
+  for (int r = 0; r < MATH_BENCH_ROUNDS; r++)
+    for (int i = 0; i < MATH_BENCH_N; i++)
+      benchSinkF = fastmath::baroAltitude(ps[i]);
+  fast = ESP.getCycleCount() - t0;
+  err = 0.0;
+  for (int i = 0; i < MATH_BENCH_N; i++) {
+    double h = 44330.0 * (1.0 - pow(ps[i] / 1013.25, 0.190295));
+    err = fmax(err, fabs(fastmath::baroAltitude(ps[i]) - h));
+  }
+  printBenchRow("altitude", ref, fast, err, "m");
+
+  // vector norm
+  t0 = ESP.getCycleCount();
+  for (int r = 0; r < MATH_BENCH_ROUNDS; r++)
+    for (int i = 0; i < MATH_BENCH_N; i++)
+      benchSinkF = sqrtf(xs[i] * xs[i] + ys[i] * ys[i] + ps[i] * ps[i]);
+  ref = ESP.getCycleCount() - t0;
+  t0 = ESP.getCycleCount();
+  for (int r = 0; r < MATH_BENCH_ROUNDS; r++)
+    for (int i = 0; i < MATH_BENCH_N; i++)
+      benchSinkF = fastmath::norm3(xs[i], ys[i], ps[i]);
+  fast = ESP.getCycleCount() - t0;
+  err = 0.0;
+  for (int i = 0; i < MATH_BENCH_N; i++) {
+    double n = sqrt((double)xs[i] * xs[i] + (double)ys[i] * ys[i] +
+                    (double)ps[i] * ps[i]);
+    err = fmax(err, fabs(fastmath::norm3(xs[i], ys[i], ps[i]) / n - 1.0));
+  }
+  printBenchRow("norm3", ref, fast, err, "rel");
+
+  // inverse sqrt
+  t0 = ESP.getCycleCount();
+  for (int r = 0; r < MATH_BENCH_ROUNDS; r++)
+    for (int i = 0; i < MATH_BENCH_N; i++)
+      benchSinkF = 1.0f / sqrtf(ps[i]);
+  ref = ESP.getCycleCount() - t0;
+  t0 = ESP.getCycleCount();
+  for (int r = 0; r < MATH_BENCH_ROUNDS; r++)
+    for (int i = 0; i < MATH_BENCH_N; i++)
+      benchSinkF = fastmath::invSqrt(ps[i]);
+  fast = ESP.getCycleCount() - t0;
+  err = 0.0;
+  for (int i = 0; i < MATH_BENCH_N; i++)
+    err = fmax(err, fabs(fastmath::invSqrt(ps[i]) * sqrt((double)ps[i]) - 1.0));
+  printBenchRow("invSqrt", ref, fast, err, "rel");
+}
+
+#endif // !MATH_BENCHMARK_H
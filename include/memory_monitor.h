@@ -0,0 +1,74 @@
+#ifndef MEMORY_MONITOR_H
+#define MEMORY_MONITOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+// RAM budget instrumentation for long runs:
+//  - static allocations tagged per module (MEMORY_TAG), listed at the top
+//    of every boot's snapshots
+//  - internal heap free, low-water mark, largest free block and the
+//    fragmentation that follows from them (String churn shows up here)
+//  - stack high-water mark of every task registered with memoryWatchTask
+//
+// Snapshots are plain structs; the state machine hands them to the flight
+// logger, which writes them to /memory.csv. Flash and RAM per module at
+// build time come from tools/size_report.py.
+
+#ifndef MEMORY_SNAPSHOT_MS
+#define MEMORY_SNAPSHOT_MS 30000
+#endif
+
+static const int MEMORY_MAX_TAGS = 24;
+static const int MEMORY_MAX_TASKS = 8;
+
+enum MemorySnapshotReason : uint8_t {
+  MEMORY_BOOT,
+  MEMORY_PERIODIC,
+  MEMORY_TRANSITION,
+};
+
+struct MemorySnapshot {
+  uint32_t t_ms;
+  uint8_t reason; // MemorySnapshotReason
+  uint8_t state;  // FlightState
+  uint8_t taskCount;
+  uint32_t heapFree;
+  uint32_t heapMinFree; // lowest since boot
+  uint32_t heapLargest; // largest block malloc can still return
+  uint8_t fragmentationPct;
+  struct {
+    char name[configMAX_TASK_NAME_LEN];
+    uint32_t stackFree; // bytes never touched since the task started
+  } tasks[MEMORY_MAX_TASKS];
+};
+
+// registers a static object's size under a module; the constructor runs
+// before setup(), the registry is zero-initialised storage
+void memoryTag(const char *module, const char *object, size_t bytes);
+
+struct MemoryTag {
+  MemoryTag(const char *module, const char *object, size_t bytes) {
+    memoryTag(module, object, bytes);
+  }
+};
+
+#define MEMORY_TAG(module, object)                                             \
+  static MemoryTag memoryTag_##object(module, #object, sizeof(object))
+
+// stack accounting for a task, e.g. right after creating it; the loop
+// task registers itself with xTaskGetCurrentTaskHandle()
+void memoryWatchTask(TaskHandle_t task);
+
+void memoryTakeSnapshot(MemorySnapshot &s, uint8_t reason, uint8_t state);
+
+// static bytes tagged by all modules
+size_t memoryTaggedBytes();
+
+// CSV rows for one snapshot (tag rows first on MEMORY_BOOT); returns the
+// length written, truncated to fit
+size_t memoryFormatCsv(const MemorySnapshot &s, char *out, size_t len);
+
+#endif // !MEMORY_MONITOR_H
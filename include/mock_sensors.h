@@ -0,0 +1,126 @@
+#ifndef MOCK_SENSORS_H
+#define MOCK_SENSORS_H
+
+#include "fast_math.h"
+#include "lora_driver.h"
+#include "sdcard_driver.h"
+#include "sensor_pipeline.h"
+#include "telemetry_sample.h"
+#include "time_base.h"
+#include <cstdint>
+
+// Stand-ins for the sensor drivers, the radio and the SD card, so a
+// stateMachineUpdate() pass can be timed without I2C, UART, SPI or airtime
+// in it (pipeline_benchmark.h). The sensors read a quiet pad: steady
+// pressure with a little noise, 1 g on z, a fixed heading and a GPS fix
+// good enough to anchor the ground calibration. The flight never launches,
+// so nothing is logged or checkpointed as flying.
+
+struct MockSensor {
+  MockSensor() : n(0) {}
+  void powerDown() {}
+  // a few counts of noise, so the filters have something to do
+  float noise(float scale) { return scale * (float)((int)(n++ % 7) - 3); }
+  uint32_t n;
+};
+
+struct MockBaro : MockSensor {};
+struct MockEnv : MockSensor {};
+struct MockImu : MockSensor {};
+struct MockMag : MockSensor {};
+struct MockGps : MockSensor {};
+
+template <> struct SensorStage<MockBaro> : SensorStageBase {
+  static void acquire(MockBaro &d, TelemetrySample &s) {
+    s.temp_bmp = 21.0f;
+    s.pressure = 1008.0f + d.noise(0.01f);
+    s.altitude = fastmath::baroAltitude(s.pressure);
+    s.baro_us = timeBaseNowUs();
+  }
+};
+
+template <> struct SensorStage<MockEnv> : SensorStageBase {
+  static void acquire(MockEnv &, TelemetrySample &s) {
+    s.temp_dht = 22.0f;
+    s.humidity = 48.0f;
+    s.env_us = timeBaseNowUs();
+  }
+};
+
+template <> struct SensorStage<MockImu> : SensorStageBase {
+  static void acquire(MockImu &d, TelemetrySample &s) {
+    s.ax = d.noise(0.002f);
+    s.ay = d.noise(0.002f);
+    s.az = 1.0f + d.noise(0.002f);
+    s.gx = s.gy = s.gz = d.noise(0.01f);
+    s.imu_us = timeBaseNowUs();
+  }
+};
+
+template <> struct SensorStage<MockMag> : SensorStageBase {
+  static void acquire(MockMag &, TelemetrySample &s) {
+    s.heading = 123.0f;
+    s.mag_us = timeBaseNowUs();
+  }
+};
+
+template <> struct SensorStage<MockGps> : SensorStageBase {
+  static void acquire(MockGps &, TelemetrySample &s) {
+    s.lat_e7 = -338568000;
+    s.lon_e7 = 1512153000;
+    s.gps_us = timeBaseNowUs();
+  }
+
+  static bool hasFix(MockGps &) { return true; }
+
+  static bool altitude(MockGps &, float &metres) {
+    metres = 45.0f;
+    return true;
+  }
+};
+
+// Transmits take no time and nothing is ever received; airtime and
+// profile checks are LoRaDriver's own, so the downlink budget is the real
+// one. The hidden members are the ones the state machine calls through
+// Board::Radio.
+class MockRadio : public LoRaDriver {
+public:
+  MockRadio(uint8_t csPin, uint8_t rstPin, uint8_t dio0Pin, long frequency)
+      : LoRaDriver(csPin, rstPin, dio0Pin, frequency), sent(0) {}
+
+  bool begin() { return true; }
+  bool isInitialized() const { return true; }
+  bool sendPacket(const uint8_t *, size_t) {
+    sent++;
+    return true;
+  }
+  void startReceive() {}
+  void stopReceive() {}
+  void sleep() {}
+  int receivePacket(uint8_t *, size_t) { return 0; }
+  int64_t lastRxUs() const { return 0; }
+  bool setProfile(uint8_t sf, long bandwidth, uint8_t codingRate4) {
+    return isValidProfile(sf, bandwidth, codingRate4);
+  }
+
+  uint32_t packetsSent() const { return sent; }
+
+private:
+  uint32_t sent;
+};
+
+// A card that is never mounted: every write the logger task makes returns
+// at once, so SD time stays out of the pass.
+class MockStorage : public SDCard_Driver {
+public:
+  explicit MockStorage(uint8_t csPin) : SDCard_Driver(csPin) {}
+
+  bool begin() { return true; }
+};
+
+// nothing to self-test (test_functions.h)
+inline bool testSensor(MockSensor &) { return true; }
+inline bool testSensor(MockRadio &) { return true; }
+inline bool testSensor(MockStorage &) { return true; }
+
+#endif // !MOCK_SENSORS_H
@@ -1,38 +1,136 @@
 #ifndef MPU6050_DRIVER_H
 #define MPU6050_DRIVER_H
 
+#include "debug_log.h"
+#include "fast_math.h"
 #include <Adafruit_MPU6050.h>
 #include <Adafruit_Sensor.h>
 #include <Wire.h>
+#include <cmath>
 #include <cstdint>
 
 class MPU6050_Driver {
 public:
+  static const uint8_t FIFO_ACCEL_RANGE_G = 16;
+
+  MPU6050_Driver() : _accelScale(1.0f / 16384.0f) { clearBias(); }
+
   void begin() {
     if (!mpu.begin()) {
-      Serial.println("Failed to find MPU6050 chip");
+      DLOG_ERROR("Failed to find MPU6050 chip");
       while (1) {
         delay(10);
       }
     }
-    mpu.setAccelerometerRange(MPU6050_RANGE_2_G);
+    setAccelRange(2);
     mpu.setGyroRange(MPU6050_RANGE_250_DEG);
     mpu.setFilterBandwidth(MPU6050_BAND_21_HZ);
   }
 
+  // After a CPU reset in flight the part kept power and its setup, so
+  // skip begin()'s chip reset (a few hundred ms of delays) and only read
+  // the range back. False if it was power cycled or doesn't answer; call
+  // begin() then.
+  bool resume() {
+    uint8_t who, power, accelConfig;
+    if (!readRegisters(REG_WHO_AM_I, &who, 1) || who != WHO_AM_I_MPU6050 ||
+        !readRegisters(REG_PWR_MGMT_1, &power, 1) ||
+        (power & PWR_MGMT_1_SLEEP) ||
+        !readRegisters(REG_ACCEL_CONFIG, &accelConfig, 1))
+      return false;
+    _accelScale = (2 << ((accelConfig >> 3) & 3)) / 32768.0f;
+    return true;
+  }
+
+  // one register burst, so it works without begin() after resume()
   void readAccelGyro(float &ax, float &ay, float &az, float &gx, float &gy,
                      float &gz) {
-    sensors_event_t a, g, temp;
-    mpu.getEvent(&a, &g, &temp);
+    uint8_t b[14]; // accel xyz, temperature, gyro xyz
+    if (!readRegisters(REG_ACCEL_XOUT_H, b, sizeof(b))) {
+      ax = ay = az = gx = gy = gz = NAN;
+      return;
+    }
+    // raw counts to g and rad/s, bias removed in the same multiply-add
+    ax = raw16(b + 0) * _accelScale - _accelBias[0];
+    ay = raw16(b + 2) * _accelScale - _accelBias[1];
+    az = raw16(b + 4) * _accelScale - _accelBias[2];
+    gx = raw16(b + 8) * GYRO_SCALE - _gyroBias[0];
+    gy = raw16(b + 10) * GYRO_SCALE - _gyroBias[1];
+    gz = raw16(b + 12) * GYRO_SCALE - _gyroBias[2];
+  }
+
+  // full scale in g (2, 4, 8 or 16, rounded up); the read scale follows
+  void setAccelRange(uint8_t g) {
+    uint8_t afsSel = g <= 2 ? 0 : g <= 4 ? 1 : g <= 8 ? 2 : 3;
+    writeRegister(REG_ACCEL_CONFIG, (uint8_t)(afsSel << 3));
+    _accelScale = (2 << afsSel) / 32768.0f;
+  }
+
+  // accel bias in g, gyro bias in rad/s (sensor_calibration.h)
+  void setBias(const float accel[3], const float gyro[3]) {
+    for (int i = 0; i < 3; i++) {
+      _accelBias[i] = accel[i];
+      _gyroBias[i] = gyro[i];
+    }
+  }
 
-    // Convert accelerometer readings from m/s² to g by dividing by 9.80665
-    ax = a.acceleration.x / 9.80665f;
-    ay = a.acceleration.y / 9.80665f;
-    az = a.acceleration.z / 9.80665f;
+  void clearBias() {
+    for (int i = 0; i < 3; i++)
+      _accelBias[i] = _gyroBias[i] = 0.0f;
+  }
+
+  // Fixed-rate accel and gyro into the on-chip FIFO (vibration analysis).
+  // Opens the low-pass to 184 Hz and the accel range to FIFO_ACCEL_RANGE_G
+  // so the burn doesn't clip, which the register reads see too.
+  void startFifo(uint16_t rateHz) {
+    setAccelRange(FIFO_ACCEL_RANGE_G);
+    writeRegister(REG_CONFIG, DLPF_184_HZ); // 1 kHz internal rate
+    writeRegister(REG_SMPLRT_DIV, (uint8_t)(1000 / rateHz - 1));
+    writeRegister(REG_FIFO_EN, 0);
+    writeRegister(REG_USER_CTRL, USER_CTRL_FIFO_RESET);
+    writeRegister(REG_FIFO_EN, FIFO_EN_GYRO_ACCEL);
+    writeRegister(REG_USER_CTRL, USER_CTRL_FIFO_EN);
+  }
 
-    gx = g.gyro.x;
-    gy = g.gyro.y;
-    gz = g.gyro.z;
+  void stopFifo() {
+    writeRegister(REG_FIFO_EN, 0);
+    writeRegister(REG_USER_CTRL, 0);
+  }
+
+  // Drains up to maxFrames samples (accel g, gyro rad/s, bias removed).
+  // Returns the count, or -1 after an overflow, which resets the FIFO;
+  // 1024 bytes hold 85 ms at 1 kHz.
+  int readFifo(float (*accel)[3], float (*gyro)[3], int maxFrames) {
+    uint8_t buf[FIFO_CHUNK_FRAMES * FIFO_FRAME_BYTES];
+    if (!readRegisters(REG_INT_STATUS, buf, 1))
+      return 0;
+    if (buf[0] & INT_STATUS_FIFO_OFLOW) {
+      writeRegister(REG_USER_CTRL, USER_CTRL_FIFO_EN | USER_CTRL_FIFO_RESET);
+      return -1;
+    }
+    if (!readRegisters(REG_FIFO_COUNT_H, buf, 2))
+      return 0;
+    int frames = ((buf[0] << 8) | buf[1]) / FIFO_FRAME_BYTES;
+    if (frames > maxFrames)
+      frames = maxFrames;
+
+    // the Wire buffer limits each read to a few frames
+    const float accelScale = _accelScale;
+    for (int done = 0; done < frames;) {
+      int n = frames - done;
+      if (n > FIFO_CHUNK_FRAMES)
+        n = FIFO_CHUNK_FRAMES;
+      if (!readRegisters(REG_FIFO_R_W, buf, n * FIFO_FRAME_BYTES))
+        return done;
+      for (int i = 0; i < n; i++, done++) {
+        const uint8_t *f = buf + i * FIFO_FRAME_BYTES;
+        for (int a = 0; a < 3; a++) {
+          accel[done][a] = raw16(f + 2 * a) * accelScale - _accelBias[a];
+          gyro[done][a] = raw16(f + 6 + 2 * a) * GYRO_SCALE - _gyroBias[a];
+        }
+      }
+    }
+    return frames;
   }
 
   bool testConnection() {
@@ -40,21 +138,70 @@ public:
     readAccelGyro(ax, ay, az, gx, gy, gz);
 
     // Calculate the acceleration vector magnitude in g
-    float accelMag = sqrtf(ax * ax + ay * ay + az * az);
+    float accelMag = fastmath::norm3(ax, ay, az);
 
     // Check if accelMag is within reasonable range (near 1g at rest)
     bool valid = (accelMag > 0.5f) && (accelMag < 2.0f);
 
     if (!valid) {
-      Serial.println("MPU6050 acceleration sanity check FAILED!");
+      DLOG_WARN("MPU6050 acceleration sanity check FAILED!");
     }
     return valid;
   }
 
-  void powerDown() { Serial.println("Stop using MPU6050"); }
+  void powerDown() { DLOG_INFO("Stop using MPU6050"); }
 
 private:
+  static const uint8_t I2C_ADDRESS = 0x68;
+  // rad/s per count at +-250 dps
+  static constexpr float GYRO_SCALE = 3.14159265f / (131.0f * 180.0f);
+  static const uint8_t REG_SMPLRT_DIV = 0x19;
+  static const uint8_t REG_CONFIG = 0x1A;
+  static const uint8_t REG_ACCEL_CONFIG = 0x1C;
+  static const uint8_t REG_FIFO_EN = 0x23;
+  static const uint8_t REG_INT_STATUS = 0x3A;
+  static const uint8_t REG_ACCEL_XOUT_H = 0x3B;
+  static const uint8_t REG_USER_CTRL = 0x6A;
+  static const uint8_t REG_FIFO_COUNT_H = 0x72;
+  static const uint8_t REG_FIFO_R_W = 0x74;
+  static const uint8_t REG_PWR_MGMT_1 = 0x6B;
+  static const uint8_t REG_WHO_AM_I = 0x75;
+  static const uint8_t WHO_AM_I_MPU6050 = 0x68;
+  static const uint8_t PWR_MGMT_1_SLEEP = 0x40; // set after power-on
+  static const uint8_t DLPF_184_HZ = 1;
+  static const uint8_t FIFO_EN_GYRO_ACCEL = 0x78; // XG, YG, ZG, ACCEL
+  static const uint8_t USER_CTRL_FIFO_EN = 0x40;
+  static const uint8_t USER_CTRL_FIFO_RESET = 0x04;
+  static const uint8_t INT_STATUS_FIFO_OFLOW = 0x10;
+  static const int FIFO_FRAME_BYTES = 12; // accel xyz, gyro xyz
+  static const int FIFO_CHUNK_FRAMES = 10;
+
+  static int16_t raw16(const uint8_t *p) {
+    return (int16_t)((p[0] << 8) | p[1]);
+  }
+
+  void writeRegister(uint8_t reg, uint8_t value) {
+    Wire.beginTransmission(I2C_ADDRESS);
+    Wire.write(reg);
+    Wire.write(value);
+    Wire.endTransmission();
+  }
+
+  bool readRegisters(uint8_t reg, uint8_t *out, size_t len) {
+    Wire.beginTransmission(I2C_ADDRESS);
+    Wire.write(reg);
+    if (Wire.endTransmission(false) != 0 ||
+        Wire.requestFrom((int)I2C_ADDRESS, (int)len) != len)
+      return false;
+    for (size_t i = 0; i < len; i++)
+      out[i] = (uint8_t)Wire.read();
+    return true;
+  }
+
   Adafruit_MPU6050 mpu;
+  float _accelScale; // g per count at the configured range
+  float _accelBias[3];
+  float _gyroBias[3];
 };
 
 #endif // !MPU6050_DRIVER_H
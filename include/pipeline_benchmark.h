@@ -0,0 +1,55 @@
+#ifndef PIPELINE_BENCHMARK_H
+#define PIPELINE_BENCHMARK_H
+
+#include "bench_report.h"
+#include "calibration_store.h"
+#include "flight_checkpoint.h"
+#include "state_machine.h"
+#include <Arduino.h>
+#include <esp_timer.h>
+
+// On-target cost of one whole stateMachineUpdate() pass, with the sensors,
+// radio and SD card mocked (MockBoard, mock_sensors.h) so bus time and
+// airtime don't hide the processing: filtering, event detection, downlink
+// scheduling, memory snapshots and the checkpoint. The ground calibration
+// (and its NVS write) runs in untimed warm-up passes; its record and the
+// pad checkpoint are cleared afterwards. Run from setup() in the
+// esp32dev_pipeline_bench env.
+
+static const int PIPELINE_BENCH_WARMUP =
+    SensorCalibrator::WINDOW_SAMPLES + 10;
+static const int PIPELINE_BENCH_PASSES = 500;
+
+void runPipelineBenchmark() {
+  Serial.println("=== STATE MACHINE PASS BENCHMARK ===");
+  stateMachineInit();
+  for (int i = 0; i < PIPELINE_BENCH_WARMUP; i++) {
+    stateMachineUpdate();
+    delay(1);
+  }
+
+  uint64_t cycles = 0; // a uint32_t wraps after ~18 s at 240 MHz
+  int64_t total = 0, worst = 0;
+  for (int i = 0; i < PIPELINE_BENCH_PASSES; i++) {
+    int64_t t0 = esp_timer_get_time();
+    uint32_t c0 = ESP.getCycleCount();
+    stateMachineUpdate();
+    cycles += ESP.getCycleCount() - c0;
+    int64_t dt = esp_timer_get_time() - t0;
+    total += dt;
+    worst = dt > worst ? dt : worst;
+    delay(1); // let the logger and drain tasks run, as the loop does
+  }
+  CalibrationStore().clear();
+  checkpointClear();
+
+  Serial.printf("  pass  avg %7.1f us  %9.1f cycles  worst %lld us\n",
+                (float)total / PIPELINE_BENCH_PASSES,
+                (float)cycles / PIPELINE_BENCH_PASSES, (long long)worst);
+  benchReport("pipeline", "pass", BENCH_TICK_UNIT,
+              (double)cycles / PIPELINE_BENCH_PASSES);
+  benchReport("pipeline", "pass", "us", (double)total / PIPELINE_BENCH_PASSES);
+  benchReport("pipeline", "pass", "us_max", (double)worst);
+}
+
+#endif // !PIPELINE_BENCHMARK_H
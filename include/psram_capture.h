@@ -0,0 +1,62 @@
+#ifndef PSRAM_CAPTURE_H
+#define PSRAM_CAPTURE_H
+
+#include "capture_arena.h"
+#include <cstddef>
+#include <cstdint>
+
+// Whole-ascent capture at full rate for boards with PSRAM (the
+// esp32wrover env). SD write stalls during boost cost samples in the
+// regular log; here every IMU frame the vibration monitor drains from the
+// FIFO (VIBRATION_RATE_HZ) and a baro reading every state machine pass go
+// into a CAPTURE_ARENA_BYTES ring in PSRAM (capture_arena.h) from launch
+// to apogee, and the pass runs at the minimum sample period meanwhile.
+//
+// The logger task drains the ring into /capture.bin whenever the sample
+// queue leaves it idle, so it keeps up where the card allows and finishes
+// after landing where it doesn't. A ring that fills anyway decimates IMU
+// frames instead of dropping them. tools/capture_decode.cpp reads the file
+// back.
+//
+// Without -DPSRAM_CAPTURE=true, or with no PSRAM found, none of this runs
+// and the calls below return at once.
+
+#ifndef PSRAM_CAPTURE
+#define PSRAM_CAPTURE false
+#endif
+
+#ifndef CAPTURE_ARENA_BYTES
+#define CAPTURE_ARENA_BYTES (3 * 1024 * 1024)
+#endif
+
+// allocates the ring in PSRAM and a staging buffer for SD writes in
+// internal RAM; false if there is no PSRAM
+bool captureInit();
+
+// launch: record from now on
+void captureStart();
+
+// apogee or landing: stop recording, the logger keeps draining
+void captureStop();
+
+bool captureRecording();
+
+// from the vibration monitor task, per FIFO frame
+void captureImu(const float accel[3], const float gyro[3], uint64_t t_us,
+                bool utc);
+
+// from the sensor loop, per pass
+void captureBaro(float pressure_hPa, float temp_C, uint64_t t_us, bool utc);
+
+// logger task: the oldest records (a staging copy in internal RAM) and
+// their length in bytes, 0 when the ring is empty; release them once
+// written, or leave them to retry
+size_t captureTakeChunk(const uint8_t *&data);
+void captureRelease(size_t bytes);
+
+uint32_t captureRecords(); // written to the ring
+uint32_t captureDropped(); // ring full even at MAX_STEP
+uint8_t captureMaxStep();  // deepest IMU decimation so far
+size_t capturePendingBytes();
+
+#endif // !PSRAM_CAPTURE_H
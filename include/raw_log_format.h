@@ -0,0 +1,82 @@
+#ifndef RAW_LOG_FORMAT_H
+#define RAW_LOG_FORMAT_H
+
+#include "log_codec.h"
+#include <cstdint>
+
+// On-card layout of the raw-sector flight log, shared with the host
+// exporter (tools/raw_log_export.cpp).
+//
+// The region is a dedicated MBR partition of type 0xDA ("non-FS data")
+// next to the FAT volume. Its first sector is the superblock; log_codec
+// blocks follow, one per sector, written strictly sequentially. The last
+// SCRATCH_SECTORS are never logged to: the SD latency benchmark
+// (sd_latency_benchmark.h) times its raw writes there.
+
+namespace rawlog {
+
+static const uint8_t PARTITION_TYPE = 0xDA;
+static const uint32_t SECTOR_BYTES = 512;
+static const uint32_t SUPERBLOCK_MAGIC = 0x474F4C52; // "RLOG"
+static const uint16_t SUPERBLOCK_VERSION = 1;
+static const uint32_t SCRATCH_SECTORS = 512;
+
+// log blocks a region of regionSectors can hold
+inline uint32_t dataSectors(uint32_t regionSectors) {
+  return regionSectors > 1 + SCRATCH_SECTORS
+             ? regionSectors - 1 - SCRATCH_SECTORS
+             : 0;
+}
+
+struct Superblock {
+  uint32_t regionStart;   // absolute LBA of the superblock
+  uint32_t regionSectors; // including the superblock
+  uint32_t cursor;        // data sectors written (next = regionStart+1+cursor)
+  uint32_t nextSequence;  // log_codec block sequence at the cursor
+  uint32_t sessions;      // boots that opened the region
+};
+
+// Finds the first partition of PARTITION_TYPE in an MBR sector
+inline bool findPartition(const uint8_t *mbr, uint32_t &start,
+                          uint32_t &sectors) {
+  if (mbr[510] != 0x55 || mbr[511] != 0xAA)
+    return false;
+  for (int i = 0; i < 4; i++) {
+    const uint8_t *e = mbr + 446 + 16 * i;
+    if (e[4] == PARTITION_TYPE) {
+      start = logcodec::get32(e + 8);
+      sectors = logcodec::get32(e + 12);
+      return sectors > 1;
+    }
+  }
+  return false;
+}
+
+inline void encodeSuperblock(const Superblock &sb, uint8_t *sector) {
+  memset(sector, 0, SECTOR_BYTES);
+  logcodec::put32(sector, SUPERBLOCK_MAGIC);
+  logcodec::put16(sector + 4, SUPERBLOCK_VERSION);
+  logcodec::put32(sector + 8, sb.regionStart);
+  logcodec::put32(sector + 12, sb.regionSectors);
+  logcodec::put32(sector + 16, sb.cursor);
+  logcodec::put32(sector + 20, sb.nextSequence);
+  logcodec::put32(sector + 24, sb.sessions);
+  logcodec::put32(sector + 28, logcodec::crc32(sector, 28));
+}
+
+inline bool decodeSuperblock(const uint8_t *sector, Superblock &sb) {
+  if (logcodec::get32(sector) != SUPERBLOCK_MAGIC ||
+      logcodec::get16(sector + 4) != SUPERBLOCK_VERSION ||
+      logcodec::get32(sector + 28) != logcodec::crc32(sector, 28))
+    return false;
+  sb.regionStart = logcodec::get32(sector + 8);
+  sb.regionSectors = logcodec::get32(sector + 12);
+  sb.cursor = logcodec::get32(sector + 16);
+  sb.nextSequence = logcodec::get32(sector + 20);
+  sb.sessions = logcodec::get32(sector + 24);
+  return true;
+}
+
+} // namespace rawlog
+
+#endif // !RAW_LOG_FORMAT_H
@@ -0,0 +1,139 @@
+#ifndef RAW_LOG_REGION_H
+#define RAW_LOG_REGION_H
+
+#include "raw_log_format.h"
+#include "sdcard_driver.h"
+#include <Arduino.h>
+
+// Sequential sector writer for the raw log partition (raw_log_format.h).
+// Blocks are batched and written as one multi-block transfer; the write
+// cursor in the superblock is refreshed every SUPERBLOCK_INTERVAL sectors
+// and on flush. After a reset, open() rescans past the saved cursor for
+// blocks that continue the sequence, so at most the unflushed batch is
+// lost.
+class RawLogRegion {
+public:
+  static const uint32_t BATCH_SECTORS = 8; // 4 KB per transfer
+  static const uint32_t SUPERBLOCK_INTERVAL = 64;
+
+  RawLogRegion() : sd(nullptr), opened(false), batched(0), savedCursor(0) {}
+
+  bool open(SDCard_Driver &card) {
+    sd = &card;
+    opened = false;
+    uint8_t *sector = batch; // scratch until the first append
+
+    uint32_t start, sectors;
+    if (!sd->readSectors(0, sector, 1) ||
+        !rawlog::findPartition(sector, start, sectors))
+      return false;
+
+    if (!sd->readSectors(start, sector, 1) ||
+        !rawlog::decodeSuperblock(sector, sb) || sb.regionStart != start ||
+        sb.regionSectors != sectors || sb.cursor > sectors - 1) {
+      // first use of this partition
+      sb.regionStart = start;
+      sb.regionSectors = sectors;
+      sb.cursor = 0;
+      sb.nextSequence = 0;
+      sb.sessions = 0;
+    }
+
+    // recover blocks written after the last superblock update
+    uint32_t seq;
+    while (sb.cursor < rawlog::dataSectors(sb.regionSectors) &&
+           sd->readSectors(dataSector(sb.cursor), sector, 1) &&
+           logcodec::isValidBlock(sector, &seq) && seq == sb.nextSequence) {
+      sb.cursor++;
+      sb.nextSequence++;
+    }
+
+    sb.sessions++;
+    batched = 0;
+    if (!saveSuperblock())
+      return false;
+    opened = true;
+    return true;
+  }
+
+  // queues one 512-byte log block, false once the region is full
+  bool append(const uint8_t *block) {
+    if (!opened ||
+        sb.cursor + batched >= rawlog::dataSectors(sb.regionSectors))
+      return false;
+    memcpy(batch + batched * rawlog::SECTOR_BYTES, block,
+           rawlog::SECTOR_BYTES);
+    if (++batched == BATCH_SECTORS)
+      return writeBatch() &&
+             (sb.cursor - savedCursor < SUPERBLOCK_INTERVAL ||
+              saveSuperblock());
+    return true;
+  }
+
+  bool flush() {
+    if (!opened)
+      return false;
+    if (batched == 0 && sb.cursor == savedCursor)
+      return true; // nothing new since the last superblock
+    return writeBatch() && saveSuperblock();
+  }
+
+  bool isOpen() const { return opened; }
+
+  // log_codec sequence the next block must carry
+  uint32_t nextSequence() const { return sb.nextSequence + batched; }
+
+  uint32_t firstDataSector() const { return sb.regionStart + 1; }
+
+  uint32_t capacitySectors() const {
+    return rawlog::dataSectors(sb.regionSectors);
+  }
+
+  uint32_t usedSectors() const { return sb.cursor + batched; }
+
+  // one block by its index in the region, including the unwritten batch
+  bool readBlock(uint32_t index, uint8_t *block) {
+    if (!opened || index >= sb.cursor + batched)
+      return false;
+    if (index >= sb.cursor) {
+      memcpy(block, batch + (index - sb.cursor) * rawlog::SECTOR_BYTES,
+             rawlog::SECTOR_BYTES);
+      return true;
+    }
+    return sd->readSectors(dataSector(index), block, 1);
+  }
+
+private:
+  uint32_t dataSector(uint32_t index) const {
+    return sb.regionStart + 1 + index;
+  }
+
+  bool writeBatch() {
+    if (batched == 0)
+      return true;
+    if (!sd->writeSectors(dataSector(sb.cursor), batch, batched))
+      return false;
+    sb.cursor += batched;
+    sb.nextSequence += batched;
+    batched = 0;
+    return true;
+  }
+
+  bool saveSuperblock() {
+    uint8_t sector[rawlog::SECTOR_BYTES];
+    rawlog::encodeSuperblock(sb, sector);
+    if (!sd->writeSectors(sb.regionStart, sector, 1))
+      return false;
+    savedCursor = sb.cursor;
+    return true;
+  }
+
+  SDCard_Driver *sd;
+  rawlog::Superblock sb;
+  bool opened;
+  uint8_t batch[BATCH_SECTORS * rawlog::SECTOR_BYTES];
+  uint32_t batched;
+  uint32_t savedCursor;
+};
+
+#endif // !RAW_LOG_REGION_H
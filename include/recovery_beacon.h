@@ -0,0 +1,97 @@
+#ifndef RECOVERY_BEACON_H
+#define RECOVERY_BEACON_H
+
+#include <cstdint>
+
+// Recovery schedule after landing. Each cycle opens with a radio slot for
+// position packets and uplink, then the radio sleeps and the buzzer gets an
+// audio slot: locate chirps, and every few cycles the last fix in Morse.
+// Radio and buzzer never run together, and the cycle stretches the longer
+// the payload waits to be found.
+//
+// Plain C++ with no Arduino dependencies.
+class RecoveryBeacon {
+public:
+  enum Cue {
+    CUE_NONE,
+    CUE_RADIO,     // radio slot opened: send position, listen
+    CUE_CHIRPS,    // audio slot opened: locate chirps
+    CUE_MORSE_FIX, // audio slot opened: last fix in Morse
+  };
+
+  static const uint32_t RADIO_SLOT_MS = 3000;
+  static const int MORSE_EVERY = 4; // cycles
+  static const int CHIRPS_PER_SLOT = 16;
+
+  RecoveryBeacon()
+      : running(false), startMs(0), cycleStartMs(0), cycleMs(0), cycles(0),
+        audioCued(false) {}
+
+  void start(uint32_t nowMs) {
+    running = true;
+    startMs = nowMs;
+    cycles = 0;
+    beginCycle(nowMs);
+  }
+
+  void stop() { running = false; }
+  bool isRunning() const { return running; }
+
+  // Returns a cue once, when a slot opens; the caller plays or sends for
+  // it. Call every pass.
+  Cue update(uint32_t nowMs) {
+    if (!running)
+      return CUE_NONE;
+    if (nowMs - cycleStartMs >= cycleMs) {
+      cycles++;
+      beginCycle(nowMs);
+      return CUE_RADIO;
+    }
+    if (!audioCued && nowMs - cycleStartMs >= RADIO_SLOT_MS) {
+      audioCued = true;
+      return cycles % MORSE_EVERY == MORSE_EVERY - 1 ? CUE_MORSE_FIX
+                                                     : CUE_CHIRPS;
+    }
+    return CUE_NONE;
+  }
+
+  // a long audio cue (Morse) holds the next radio slot back until it ends
+  void audioStarted(uint32_t nowMs, uint32_t durationMs) {
+    uint32_t end = nowMs - cycleStartMs + durationMs;
+    if (end > cycleMs)
+      cycleMs = end;
+  }
+
+  bool radioSlot(uint32_t nowMs) const {
+    return running && nowMs - cycleStartMs < RADIO_SLOT_MS;
+  }
+
+  uint32_t cycleCount() const { return cycles; }
+
+  // 30 s for the first half hour, while a team is most likely searching
+  // nearby, 60 s up to two hours, then 120 s to last until found
+  uint32_t periodMs(uint32_t nowMs) const {
+    uint32_t waited = nowMs - startMs;
+    if (waited < 30UL * 60000UL)
+      return 30000;
+    if (waited < 120UL * 60000UL)
+      return 60000;
+    return 120000;
+  }
+
+private:
+  void beginCycle(uint32_t nowMs) {
+    cycleStartMs = nowMs;
+    cycleMs = periodMs(nowMs);
+    audioCued = false;
+  }
+
+  bool running;
+  uint32_t startMs;
+  uint32_t cycleStartMs;
+  uint32_t cycleMs;
+  uint32_t cycles;
+  bool audioCued;
+};
+
+#endif // !RECOVERY_BEACON_H
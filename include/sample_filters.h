@@ -0,0 +1,236 @@
+#ifndef SAMPLE_FILTERS_H
+#define SAMPLE_FILTERS_H
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+// Streaming filter kernels. Decimators work on blocks; the dot product in
+// the FIR is the esp-dsp optimized kernel on target and a plain scalar loop
+// elsewhere (or with -DFILTERS_SCALAR_ONLY, which is the reference).
+
+#if defined(ARDUINO_ARCH_ESP32) && !defined(FILTERS_SCALAR_ONLY) &&           \
+    __has_include(<esp_dsp.h>)
+#include <esp_dsp.h>
+#define FILTERS_USE_ESP_DSP 1
+#else
+#define FILTERS_USE_ESP_DSP 0
+#endif
+
+namespace filters {
+
+inline float dotProductScalar(const float *a, const float *b, int len) {
+  float acc = 0.0f;
+  for (int i = 0; i < len; i++)
+    acc += a[i] * b[i];
+  return acc;
+}
+
+inline float dotProduct(const float *a, const float *b, int len) {
+#if FILTERS_USE_ESP_DSP
+  float acc;
+  dsps_dotprod_f32(a, b, &acc, len);
+  return acc;
+#else
+  return dotProductScalar(a, b, len);
+#endif
+}
+
+// Hamming-windowed sinc lowpass with unity DC gain. cutoff is a fraction of
+// the input sample rate (0 < cutoff < 0.5).
+inline void designLowpass(float *h, int taps, float cutoff) {
+  const float pi = 3.14159265f;
+  const float mid = 0.5f * (taps - 1);
+  float sum = 0.0f;
+  for (int i = 0; i < taps; i++) {
+    float n = i - mid;
+    float sinc = n == 0.0f ? 2.0f * cutoff
+                           : sinf(2.0f * pi * cutoff * n) / (pi * n);
+    float window = 0.54f - 0.46f * cosf(2.0f * pi * i / (taps - 1));
+    h[i] = sinc * window;
+    sum += h[i];
+  }
+  for (int i = 0; i < taps; i++)
+    h[i] /= sum;
+}
+
+// Anti-aliasing FIR decimator, one output per DECIM inputs. The delay line
+// is stored twice so the newest TAPS samples are always contiguous and the
+// dot product runs over flat memory.
+template <int TAPS, int DECIM> class FirDecimator {
+public:
+  static const int GROUP_DELAY = (TAPS - 1) / 2;
+
+  FirDecimator() {
+    // pass band edge at 80% of the output Nyquist frequency
+    float h[TAPS];
+    designLowpass(h, TAPS, 0.4f / DECIM);
+    for (int i = 0; i < TAPS; i++)
+      coeffs[i] = h[TAPS - 1 - i]; // oldest-first to match the delay line
+    reset();
+  }
+
+  void reset() {
+    memset(delay, 0, sizeof(delay));
+    pos = 0;
+    phase = 0;
+    primed = false;
+  }
+
+  // returns the number of outputs written (n / DECIM on a primed filter)
+  int process(const float *in, int n, float *out) {
+    int produced = 0;
+    for (int i = 0; i < n; i++) {
+      if (!primed) { // start from the first value instead of a zero step
+        for (int k = 0; k < 2 * TAPS; k++)
+          delay[k] = in[i];
+        primed = true;
+      }
+      delay[pos] = in[i];
+      delay[pos + TAPS] = in[i];
+      pos = pos + 1 == TAPS ? 0 : pos + 1;
+      if (++phase == DECIM) {
+        phase = 0;
+        out[produced++] = dotProduct(&delay[pos], coeffs, TAPS);
+      }
+    }
+    return produced;
+  }
+
+private:
+  float coeffs[TAPS];
+  float delay[2 * TAPS];
+  int pos;
+  int phase;
+  bool primed;
+};
+
+// ORDER-stage CIC decimator on fixed-point input. Integrator wrap-around is
+// harmless as long as the output fits, which holds for |x| * R^ORDER < 2^31.
+template <int ORDER, int R> class CicDecimator {
+public:
+  CicDecimator() { reset(); }
+
+  void reset() {
+    memset(integ, 0, sizeof(integ));
+    memset(comb, 0, sizeof(comb));
+    phase = 0;
+    warmup = ORDER;
+  }
+
+  // returns true when out holds a new decimated value (input units)
+  bool push(int32_t x, int32_t &out) {
+    uint32_t v = (uint32_t)x;
+    for (int s = 0; s < ORDER; s++) {
+      integ[s] += v;
+      v = integ[s];
+    }
+    if (++phase < R)
+      return false;
+    phase = 0;
+    for (int s = 0; s < ORDER; s++) {
+      uint32_t prev = comb[s];
+      comb[s] = v;
+      v -= prev;
+    }
+    if (warmup > 0) { // first ORDER outputs still see the zero start state
+      warmup--;
+      return false;
+    }
+    out = (int32_t)v / gain();
+    return true;
+  }
+
+private:
+  static constexpr int32_t gain(int stages = ORDER) {
+    return stages == 0 ? 1 : R * gain(stages - 1);
+  }
+
+  uint32_t integ[ORDER];
+  uint32_t comb[ORDER];
+  int phase;
+  int warmup;
+};
+
+// Sliding median over the last N samples (N odd and small)
+template <int N> class MedianFilter {
+public:
+  MedianFilter() : count(0), pos(0) {}
+
+  float push(float x) {
+    window[pos] = x;
+    pos = pos + 1 == N ? 0 : pos + 1;
+    if (count < N)
+      count++;
+    float sorted[N];
+    for (int i = 0; i < count; i++) { // insertion sort, N is tiny
+      float v = window[i];
+      int j = i;
+      for (; j > 0 && sorted[j - 1] > v; j--)
+        sorted[j] = sorted[j - 1];
+      sorted[j] = v;
+    }
+    return sorted[count / 2];
+  }
+
+private:
+  float window[N];
+  int count;
+  int pos;
+};
+
+// Replaces a sample by the window median when it deviates from it by more
+// than maxDeviation (single-sample spikes, NaNs).
+template <int N> class OutlierRejector {
+public:
+  explicit OutlierRejector(float maxDeviation)
+      : maxDev(maxDeviation), last(NAN) {}
+
+  float push(float x) {
+    if (std::isnan(x))
+      return last;
+    float med = median.push(x);
+    last = fabsf(x - med) > maxDev ? med : x;
+    return last;
+  }
+
+private:
+  MedianFilter<N> median;
+  float maxDev;
+  float last;
+};
+
+// Boxcar average over the last N samples. The running sum is rebuilt once
+// per window so float rounding does not accumulate.
+template <int N> class MovingAverage {
+public:
+  MovingAverage() : sum(0.0f), count(0), pos(0) {}
+
+  float push(float x) {
+    if (count == N)
+      sum -= window[pos];
+    else
+      count++;
+    window[pos] = x;
+    sum += x;
+    pos = pos + 1 == N ? 0 : pos + 1;
+    if (pos == 0) {
+      sum = 0.0f;
+      for (int i = 0; i < count; i++)
+        sum += window[i];
+    }
+    return sum / count;
+  }
+
+  float value() const { return count ? sum / count : NAN; }
+
+private:
+  float window[N];
+  float sum;
+  int count;
+  int pos;
+};
+
+} // namespace filters
+
+#endif // !SAMPLE_FILTERS_H
@@ -0,0 +1,83 @@
+#ifndef SD_LATENCY_BENCHMARK_H
+#define SD_LATENCY_BENCHMARK_H
+
+#include "bench_report.h"
+#include "raw_log_region.h"
+#include "sdcard_driver.h"
+#include <Arduino.h>
+#include <esp_timer.h>
+
+// On-target write latency of the FAT append path against raw multi-sector
+// writes, per 512-byte log block. Worst case is what matters: one stall
+// longer than the logger queue depth drops samples. The raw half writes
+// to the partition's scratch sectors, which the log never uses, and
+// refuses if a log from older firmware already reaches them. Run from
+// setup() in the esp32dev_bench env.
+
+static const int SD_BENCH_BLOCKS = rawlog::SCRATCH_SECTORS;
+
+static void printLatencyRow(const char *name, const char *key, int64_t total,
+                            int64_t worst, int blocksPerCall) {
+  Serial.printf("  %-18s avg %7.1f us/block  worst call %7lld us "
+                "(%d blocks/call)\n",
+                name, (float)total / SD_BENCH_BLOCKS, (long long)worst,
+                blocksPerCall);
+  benchReport("sd", key, "us", (double)total / SD_BENCH_BLOCKS);
+  benchReport("sd", key, "us_max", (double)worst);
+}
+
+void runSdLatencyBenchmark(SDCard_Driver &sdcard) {
+  static uint8_t block[RawLogRegion::BATCH_SECTORS * rawlog::SECTOR_BYTES];
+  for (size_t i = 0; i < sizeof(block); i++)
+    block[i] = (uint8_t)i;
+
+  Serial.println("=== SD WRITE LATENCY BENCHMARK ===");
+  if (!sdcard.isInitialized()) {
+    Serial.println("  SD not initialized");
+    return;
+  }
+
+  // FAT: one append per block, as the file logger does
+  int64_t total = 0, worst = 0;
+  for (int i = 0; i < SD_BENCH_BLOCKS; i++) {
+    int64_t t0 = esp_timer_get_time();
+    sdcard.appendBytes("/bench_fat.bin", block, rawlog::SECTOR_BYTES);
+    int64_t dt = esp_timer_get_time() - t0;
+    total += dt;
+    worst = dt > worst ? dt : worst;
+  }
+  sdcard.deleteFile("/bench_fat.bin");
+  printLatencyRow("FAT append", "fat_append", total, worst, 1);
+
+  // raw: batched multi-sector writes to the scratch sectors
+  uint8_t sector[rawlog::SECTOR_BYTES];
+  uint32_t start, sectors;
+  if (!sdcard.readSectors(0, sector, 1) ||
+      !rawlog::findPartition(sector, start, sectors) ||
+      rawlog::dataSectors(sectors) == 0) {
+    Serial.println("  raw: no raw log partition");
+    return;
+  }
+  const uint32_t first = start + 1 + rawlog::dataSectors(sectors);
+  // blocks past the saved cursor are logged too, up to an interval's worth
+  rawlog::Superblock sb;
+  if (!sdcard.readSectors(start, sector, 1) ||
+      (rawlog::decodeSuperblock(sector, sb) &&
+       start + 1 + sb.cursor + RawLogRegion::SUPERBLOCK_INTERVAL > first)) {
+    Serial.println("  raw: log reaches the scratch sectors, not writing");
+    return;
+  }
+  const uint32_t batch = RawLogRegion::BATCH_SECTORS;
+  total = worst = 0;
+  for (uint32_t i = 0; i < SD_BENCH_BLOCKS; i += batch) {
+    int64_t t0 = esp_timer_get_time();
+    sdcard.writeSectors(first + i, block, batch);
+    int64_t dt = esp_timer_get_time() - t0;
+    total += dt;
+    worst = dt > worst ? dt : worst;
+  }
+  printLatencyRow("raw multi-sector", "raw_write", total, worst,
+                  (int)batch);
+}
+
+#endif // !SD_LATENCY_BENCHMARK_H
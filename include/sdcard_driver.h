@@ -1,9 +1,13 @@
 #ifndef SDCARD_DRIVER_H
 #define SDCARD_DRIVER_H
 
+#include "debug_log.h"
 #include <Arduino.h>
 #include <SD.h>
 #include <cstdint>
+#include <ff.h>
+#include <diskio.h>
+#include <sd_diskio.h>
 
 class SDCard_Driver {
 public:
@@ -33,6 +37,31 @@ public:
     return true;
   }
 
+  // Append a raw binary buffer to a file
+  bool appendBytes(const String &fileName, const uint8_t *data, size_t len) {
+    if (!_initialized)
+      return false;
+    File file = SD.open(fileName, FILE_APPEND);
+    if (!file)
+      return false;
+    size_t written = file.write(data, len);
+    file.close();
+    return written == len;
+  }
+
+  // Read len bytes at offset; false if the file is shorter
+  bool readBytes(const String &fileName, uint32_t offset, uint8_t *data,
+                 size_t len) {
+    if (!_initialized)
+      return false;
+    File file = SD.open(fileName, FILE_READ);
+    if (!file)
+      return false;
+    bool ok = file.seek(offset) && file.read(data, len) == len;
+    file.close();
+    return ok;
+  }
+
   // Read entire file contents as String
   String readFile(const String &fileName) {
     if (!_initialized)
@@ -53,18 +82,18 @@ public:
 
   bool deleteFile(const String &fileName) {
     if (!_initialized) {
-      Serial.println("SD not initialized");
+      DLOG_WARN("SD not initialized");
       return -1;
     }
     if (!SD.exists(fileName)) {
-      Serial.println("File does not exist: " + fileName);
+      DLOG_WARN("File does not exist: %s", fileName.c_str());
       return false;
     }
     if (SD.remove(fileName)) {
-      Serial.println("Deleted file: " + fileName);
+      DLOG_INFO("Deleted file: %s", fileName.c_str());
       return true;
     } else {
-      Serial.println("Failed to delete file: " + fileName);
+      DLOG_WARN("Failed to delete file: %s", fileName.c_str());
       return false;
     }
   }
@@ -88,7 +117,7 @@ public:
       if (!file.isDirectory()) {
         String filename = file.name();
         file.close();
-        Serial.println("Deleting: " + filename);
+        DLOG_INFO("Deleting: %s", filename.c_str());
         if (SD.remove(filename)) {
           deletedCount++;
         }
@@ -131,7 +160,34 @@ public:
   // Check if SD is initialized and ready
   bool isInitialized() const { return _initialized; }
 
+  // Raw sector access below the filesystem. Multi-sector writes go out as a
+  // single multi-block transfer. Only touch sectors outside the FAT volume.
+  bool readSectors(uint32_t sector, uint8_t *buffer, uint32_t count) {
+    if (!_initialized)
+      return false;
+    return disk_read(drive(), buffer, sector, count) == RES_OK;
+  }
+
+  bool writeSectors(uint32_t sector, const uint8_t *buffer, uint32_t count) {
+    if (!_initialized)
+      return false;
+    return disk_write(drive(), buffer, sector, count) == RES_OK;
+  }
+
+  uint32_t sectorCount() {
+    if (!_initialized)
+      return 0;
+    return sdcard_num_sectors(drive());
+  }
+
 private:
+  // SD.h keeps the FatFS drive number protected; read it through a
+  // pointer-to-member formed in a derived class
+  struct DriveAccess : fs::SDFS {
+    static uint8_t of(fs::SDFS &sd) { return sd.*(&DriveAccess::_pdrv); }
+  };
+  static uint8_t drive() { return DriveAccess::of(SD); }
+
   uint8_t _csPin;
   bool _initialized;
 };
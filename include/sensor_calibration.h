@@ -0,0 +1,109 @@
+#ifndef SENSOR_CALIBRATION_H
+#define SENSOR_CALIBRATION_H
+
+#include "fast_math.h"
+#include "telemetry_sample.h"
+#include <cmath>
+#include <cstdint>
+
+// Ground reference taken on the pad in PRELAUNCH.
+struct CalibrationData {
+  float seaLevelHpa;    // BMP280 reference pressure
+  float groundAltitude; // m; GPS MSL when anchored, 0 (AGL) otherwise
+  float accelBias[3];   // g
+  float gyroBias[3];    // rad/s
+  uint32_t utcSeconds;  // when it was taken, 0 if GPS time was unknown
+  uint8_t gpsAnchored;
+};
+
+// Averages pressure, accelerometer and gyro over WINDOW_SAMPLES raw samples
+// while the payload sits still. If the accel magnitude spreads by more
+// than MAX_ACCEL_SPREAD_G the payload was moved, and the window restarts.
+class SensorCalibrator {
+public:
+  static const int WINDOW_SAMPLES = 50;
+  static constexpr float MAX_ACCEL_SPREAD_G = 0.05f;
+  static constexpr float MAX_GPS_HDOP = 2.0f;
+
+  SensorCalibrator() { start(); }
+
+  void start() {
+    count = 0;
+    gpsCount = 0;
+    pressureSum = gpsAltitudeSum = 0.0f;
+    for (int i = 0; i < 3; i++)
+      accelSum[i] = gyroSum[i] = 0.0f;
+    minAccel = INFINITY;
+    maxAccel = -INFINITY;
+  }
+
+  // raw (unbiased) sample plus a GPS altitude when one is good enough;
+  // returns true once the window is complete
+  bool push(const TelemetrySample &s, bool gpsValid, float gpsAltitude) {
+    if (std::isnan(s.pressure))
+      return false;
+    float mag = fastmath::norm3(s.ax, s.ay, s.az);
+    minAccel = mag < minAccel ? mag : minAccel;
+    maxAccel = mag > maxAccel ? mag : maxAccel;
+    if (maxAccel - minAccel > MAX_ACCEL_SPREAD_G) {
+      start();
+      return false;
+    }
+    pressureSum += s.pressure;
+    accelSum[0] += s.ax;
+    accelSum[1] += s.ay;
+    accelSum[2] += s.az;
+    gyroSum[0] += s.gx;
+    gyroSum[1] += s.gy;
+    gyroSum[2] += s.gz;
+    if (gpsValid) {
+      gpsAltitudeSum += gpsAltitude;
+      gpsCount++;
+    }
+    return ++count >= WINDOW_SAMPLES;
+  }
+
+  // call once push() returned true; utcSeconds is left to the caller
+  CalibrationData result() const {
+    CalibrationData d;
+    const float inv = 1.0f / count;
+    const float pressure = pressureSum * inv;
+
+    // anchor to GPS only if it was good for most of the window
+    d.gpsAnchored = gpsCount * 2 >= count;
+    if (d.gpsAnchored) {
+      d.groundAltitude = gpsAltitudeSum / gpsCount;
+      d.seaLevelHpa =
+          pressure / powf(1.0f - d.groundAltitude / 44330.0f, 5.255f);
+    } else {
+      d.groundAltitude = 0.0f;
+      d.seaLevelHpa = pressure;
+    }
+
+    // gravity is whatever direction the mean points, so a tilted rail
+    // isn't taken for bias; only the magnitude's departure from 1 g is
+    float mean[3];
+    for (int i = 0; i < 3; i++)
+      mean[i] = accelSum[i] * inv;
+    float g = fastmath::norm3(mean[0], mean[1], mean[2]);
+    for (int i = 0; i < 3; i++) {
+      d.accelBias[i] = g > 0.0f ? mean[i] - mean[i] / g : 0.0f;
+      d.gyroBias[i] = gyroSum[i] * inv;
+    }
+    d.utcSeconds = 0;
+    return d;
+  }
+
+  int samples() const { return count; }
+
+private:
+  int count;
+  int gpsCount;
+  float pressureSum;
+  float gpsAltitudeSum;
+  float accelSum[3];
+  float gyroSum[3];
+  float minAccel, maxAccel;
+};
+
+#endif // !SENSOR_CALIBRATION_H
@@ -0,0 +1,334 @@
+#ifndef SENSOR_PIPELINE_H
+#define SENSOR_PIPELINE_H
+
+#include "bmp280_driver.h"
+#include "compass_driver.h"
+#include "debug_log.h"
+#include "dht11_driver.h"
+#include "fast_math.h"
+#include "gps_driver.h"
+#include "mpu6050_driver.h"
+#include "sensor_calibration.h"
+#include "telemetry_sample.h"
+#include "time_base.h"
+#include "vibration_monitor.h"
+#include <cstdint>
+#include <math.h>
+
+// The sensor set of a board, fixed at compile time. A board config type
+// (board_config.h) names one driver per role, and its minimum read period:
+//
+//   Baro  pressure, temperature, altitude
+//   Env   temperature, humidity
+//   Imu   accel, gyro, vibration FIFO
+//   Mag   heading
+//   Gps   position, time base discipline
+//
+// What a driver does in each step of the pass is its SensorStage<>
+// specialisation below, picked by overload at compile time; there are no
+// driver pointers, virtual calls or "is it fitted" checks at run time. A
+// role filled with NoSensor compiles to nothing: its sample fields and
+// timestamp stay zero, and nothing from its driver is linked in.
+//
+// A new sensor part is one SensorStage<> specialisation; a new board is
+// one config type.
+
+// a role the board doesn't fit
+struct NoSensor {};
+
+// defaults for every step, so each stage only spells out what its sensor
+// takes part in
+struct SensorStageBase {
+  template <typename D> static void begin(D &) {}
+  // warm restart after an in-flight reset; false means begin() is needed
+  template <typename D> static bool resume(D &) { return false; }
+  template <typename D> static void acquire(D &, TelemetrySample &) {}
+  template <typename D> static void checkSanity(D &) {}
+  template <typename D> static void powerDown(D &d) { d.powerDown(); }
+
+  // calibration (sensor_calibration.h)
+  template <typename D> static void applyCalibration(D &,
+                                                     const CalibrationData &) {}
+  template <typename D> static void clearCalibration(D &) {}
+
+  // position and time
+  template <typename D>
+  static void beginGps(D &, uint8_t, uint8_t, uint32_t, uint8_t) {}
+  template <typename D> static void poll(D &) {}
+  template <typename D> static bool hasFix(D &) { return false; }
+  template <typename D> static bool altitude(D &, float &) { return false; }
+
+  // IMU FIFO (vibration_monitor.h)
+  template <typename D> static void startVibration(D &) {}
+};
+
+template <typename Driver> struct SensorStage;
+
+template <> struct SensorStage<NoSensor> : SensorStageBase {
+  static void powerDown(NoSensor &) {}
+};
+
+static inline void sensorCheck(bool ok, const char *sensorName) {
+  if (ok) {
+    DLOG_INFO("%s sanity check PASSED.", sensorName);
+  } else {
+    DLOG_WARN("%s sanity check FAILED!", sensorName);
+  }
+}
+
+template <> struct SensorStage<BMP280_Driver> : SensorStageBase {
+  static void begin(BMP280_Driver &d) {
+    if (!d.begin())
+      DLOG_ERROR("BMP280 init failed");
+  }
+
+  static void acquire(BMP280_Driver &d, TelemetrySample &s) {
+    s.temp_bmp = d.readTemperature_C();
+    s.pressure = d.returnPressure_hPa();
+    s.altitude = d.altitudeAt(s.pressure);
+    s.baro_us = timeBaseNowUs();
+  }
+
+  // temperature range -40 to +85 °C & pressure range ~300 to ~1100 hPa
+  static void checkSanity(BMP280_Driver &d) {
+    float temp = d.readTemperature_C();
+    sensorCheck(!isnan(temp) && temp >= -40.0f && temp <= 85.0f,
+                "BMP280 Temperature");
+    float pres = d.returnPressure_hPa();
+    sensorCheck(!isnan(pres) && pres >= 300.0f && pres <= 1100.0f,
+                "BMP280 Pressure");
+  }
+
+  static void applyCalibration(BMP280_Driver &d, const CalibrationData &c) {
+    d.setSeaLevel(c.seaLevelHpa);
+  }
+};
+
+template <> struct SensorStage<DHT11_Driver> : SensorStageBase {
+  static void begin(DHT11_Driver &d) { d.begin(); }
+
+  static void acquire(DHT11_Driver &d, TelemetrySample &s) {
+    s.temp_dht = d.readTemperature();
+    s.humidity = d.readHumidity();
+    s.env_us = timeBaseNowUs();
+  }
+
+  // temperature typically 0 to 50 °C & humidity typically 20% to 90%
+  static void checkSanity(DHT11_Driver &d) {
+    float temp = d.readTemperature();
+    sensorCheck(!isnan(temp) && temp >= 0.0f && temp <= 50.0f,
+                "DHT11 Temperature");
+    float hum = d.readHumidity();
+    sensorCheck(!isnan(hum) && hum >= 20.0f && hum <= 90.0f,
+                "DHT11 Humidity");
+  }
+};
+
+template <> struct SensorStage<MPU6050_Driver> : SensorStageBase {
+  static void begin(MPU6050_Driver &d) { d.begin(); }
+
+  static bool resume(MPU6050_Driver &d) { return d.resume(); }
+
+  // FIFO mean when the vibration monitor runs
+  static void acquire(MPU6050_Driver &d, TelemetrySample &s) {
+    float accel[3], gyro[3];
+    if (vibrationTakeImuMean(accel, gyro)) {
+      s.ax = accel[0];
+      s.ay = accel[1];
+      s.az = accel[2];
+      s.gx = gyro[0];
+      s.gy = gyro[1];
+      s.gz = gyro[2];
+    } else {
+      d.readAccelGyro(s.ax, s.ay, s.az, s.gx, s.gy, s.gz);
+    }
+    s.imu_us = timeBaseNowUs();
+  }
+
+  // accel magnitude in g within the ±16 g range
+  static void checkSanity(MPU6050_Driver &d) {
+    float ax, ay, az, gx, gy, gz;
+    d.readAccelGyro(ax, ay, az, gx, gy, gz);
+    float accelMag = fastmath::norm3(ax, ay, az);
+    sensorCheck(accelMag >= 0.0f && accelMag <= 16.0f, "MPU6050 Acceleration");
+  }
+
+  // the FIFO is stopped before the IMU
+  static void powerDown(MPU6050_Driver &d) {
+    vibrationMonitorStop();
+    d.powerDown();
+  }
+
+  static void applyCalibration(MPU6050_Driver &d, const CalibrationData &c) {
+    d.setBias(c.accelBias, c.gyroBias);
+  }
+
+  static void clearCalibration(MPU6050_Driver &d) { d.clearBias(); }
+
+  static void startVibration(MPU6050_Driver &d) { vibrationMonitorInit(d); }
+};
+
+template <> struct SensorStage<Compass_Driver> : SensorStageBase {
+  static void begin(Compass_Driver &d) { d.begin(); }
+
+  static void acquire(Compass_Driver &d, TelemetrySample &s) {
+    s.heading = d.readHeading();
+    s.mag_us = timeBaseNowUs();
+  }
+
+  static void checkSanity(Compass_Driver &d) {
+    float heading = d.readHeading();
+    sensorCheck(heading >= 0.0f && heading <= 360.0f, "Compass Heading");
+  }
+};
+
+template <> struct SensorStage<GPS_Driver> : SensorStageBase {
+  static void beginGps(GPS_Driver &d, uint8_t rx, uint8_t tx, uint32_t baud,
+                       uint8_t pps) {
+    d.begin(rx, tx, baud);
+    timeBaseInit(pps);
+  }
+
+  // already drained by poll()
+  static void acquire(GPS_Driver &d, TelemetrySample &s) {
+    s.lat_e7 = d.latitudeE7();
+    s.lon_e7 = d.longitudeE7();
+    s.gps_us = timeBaseNowUs();
+  }
+
+  static void checkSanity(GPS_Driver &d) { sensorCheck(d.hasFix(), "GPS Fix"); }
+
+  // drain NMEA so the time base stays disciplined
+  static void poll(GPS_Driver &d) {
+    d.read();
+    timeBaseUpdate(d);
+  }
+
+  static bool hasFix(GPS_Driver &d) { return d.hasFix(); }
+
+  // metres above mean sea level, if good enough to anchor calibration
+  static bool altitude(GPS_Driver &d, float &metres) {
+    if (!d.hasAltitude() || d.hdop() >= SensorCalibrator::MAX_GPS_HDOP)
+      return false;
+    metres = d.altitudeMeters();
+    return true;
+  }
+};
+
+// one role of the pipeline: the driver and its rate limit
+template <typename Driver, uint32_t PERIOD_MS> class SensorSlot {
+public:
+  typedef SensorStage<Driver> Stage;
+
+  SensorSlot() : lastMs(0), read(false) {}
+
+  // a rate-limited sensor keeps its last reading (and timestamp) in the
+  // sample until its period is up
+  void acquire(TelemetrySample &s, uint32_t nowMs) {
+    if (PERIOD_MS && read && nowMs - lastMs < PERIOD_MS)
+      return;
+    Stage::acquire(driver, s);
+    lastMs = nowMs;
+    read = true;
+  }
+
+  Driver driver;
+
+private:
+  uint32_t lastMs;
+  bool read;
+};
+
+template <typename Board> class SensorPipeline {
+public:
+  typedef typename Board::Baro Baro;
+  typedef typename Board::Env Env;
+  typedef typename Board::Imu Imu;
+  typedef typename Board::Mag Mag;
+  typedef typename Board::Gps Gps;
+
+  Baro &baro() { return _baro.driver; }
+  Env &env() { return _env.driver; }
+  Imu &imu() { return _imu.driver; }
+  Mag &mag() { return _mag.driver; }
+  Gps &gps() { return _gps.driver; }
+
+  // I2C must be up; without a GPS the time base stays on boot time
+  void begin() {
+    SensorStage<Baro>::begin(baro());
+    SensorStage<Env>::begin(env());
+    SensorStage<Imu>::begin(imu());
+    SensorStage<Mag>::begin(mag());
+    SensorStage<Gps>::beginGps(gps(), Board::GPS_RX, Board::GPS_TX,
+                               Board::GPS_BAUD, Board::GPS_PPS);
+  }
+
+  // After a reset in flight: no chip resets, so samples flow again within
+  // a few ms. The baro's begin() (100 ms settle) is left to resumeSlow(),
+  // and it reads NAN until then.
+  void resume() {
+    SensorStage<Env>::begin(env());
+    if (!SensorStage<Imu>::resume(imu())) {
+      DLOG_WARN("IMU lost its setup, full restart");
+      SensorStage<Imu>::begin(imu());
+    }
+    SensorStage<Mag>::begin(mag());
+    SensorStage<Gps>::beginGps(gps(), Board::GPS_RX, Board::GPS_TX,
+                               Board::GPS_BAUD, Board::GPS_PPS);
+  }
+
+  // the rest of resume(), once logging runs again
+  void resumeSlow() { SensorStage<Baro>::begin(baro()); }
+
+  // every fitted sensor once, stamping each group as soon as it is read
+  void acquire(TelemetrySample &s, uint32_t nowMs) {
+    _baro.acquire(s, nowMs);
+    _env.acquire(s, nowMs);
+    _imu.acquire(s, nowMs);
+    _mag.acquire(s, nowMs);
+    _gps.acquire(s, nowMs);
+  }
+
+  void checkSanity() {
+    SensorStage<Baro>::checkSanity(baro());
+    SensorStage<Env>::checkSanity(env());
+    SensorStage<Imu>::checkSanity(imu());
+    SensorStage<Mag>::checkSanity(mag());
+    SensorStage<Gps>::checkSanity(gps());
+  }
+
+  // heavy sensors off after landing; GPS stays up for recovery
+  void powerDown() {
+    SensorStage<Imu>::powerDown(imu());
+    SensorStage<Mag>::powerDown(mag());
+    SensorStage<Baro>::powerDown(baro());
+  }
+
+  // biases and reference pressure go into the drivers' read path
+  void applyCalibration(const CalibrationData &c) {
+    SensorStage<Baro>::applyCalibration(baro(), c);
+    SensorStage<Imu>::applyCalibration(imu(), c);
+  }
+
+  // raw readings while the calibrator averages
+  void clearCalibration() { SensorStage<Imu>::clearCalibration(imu()); }
+
+  void poll() { SensorStage<Gps>::poll(gps()); }
+
+  bool hasFix() { return SensorStage<Gps>::hasFix(gps()); }
+
+  bool gpsAltitude(float &metres) {
+    return SensorStage<Gps>::altitude(gps(), metres);
+  }
+
+  void startVibration() { SensorStage<Imu>::startVibration(imu()); }
+
+private:
+  SensorSlot<Baro, Board::BARO_PERIOD_MS> _baro;
+  SensorSlot<Env, Board::ENV_PERIOD_MS> _env;
+  SensorSlot<Imu, Board::IMU_PERIOD_MS> _imu;
+  SensorSlot<Mag, Board::MAG_PERIOD_MS> _mag;
+  SensorSlot<Gps, Board::GPS_PERIOD_MS> _gps;
+};
+
+#endif // !SENSOR_PIPELINE_H
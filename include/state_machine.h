@@ -1,21 +1,15 @@
 #ifndef STATE_MACHINE_H
 #define STATE_MACHINE_H
 
-#include "bmp280_driver.h"
-#include "buzzer_driver.h"
-#include "compass_driver.h"
-#include "dht11_driver.h"
-#include "gps_driver.h"
-#include "lora_driver.h"
-#include "mpu6050_driver.h"
-#include "sdcard_driver.h"
+#include "board_config.h"
+#include "flight_state.h"
+#include <cstdint>
 
-enum FlightState { PRELAUNCH, ASCENT, DESCENT, POSTLAND };
-
-void stateMachineInit(BMP280_Driver &bmp, DHT11_Driver &dht,
-                      MPU6050_Driver &mpu, Compass_Driver &compass,
-                      GPS_Driver &gps, Buzzer_Driver &buzzer,
-                      SDCard_Driver &sdcard, LoRaDriver &lora);
+// runs on the board's drivers (board_config.h), begun by main
+void stateMachineInit();
 void stateMachineUpdate();
 
+// loop pacing, adjustable from the ground in PRELAUNCH
+uint32_t stateMachineSamplePeriodMs();
+
 #endif // !STATE_MACHINE_H
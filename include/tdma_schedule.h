@@ -0,0 +1,141 @@
+#ifndef TDMA_SCHEDULE_H
+#define TDMA_SCHEDULE_H
+
+#include <cstdint>
+
+// Time-division channel sharing for several payloads on one LoRa
+// frequency. Network time is cut into superframes of slotCount equal
+// slots, aligned to GPS UTC so every payload agrees on them without
+// talking; payload nodeId owns slot nodeId. Without GPS a ground station
+// time sync (uplink CMD_TIME_SYNC) stands in.
+//
+// A payload that isn't synced can't know where its slot is, so it sends
+// once per superframe at a pseudo-random point instead. That still lets
+// the ground hear it (and sync it) when two unsynced clocks would
+// otherwise put their "slots" on top of each other for good.
+//
+// Slot layout, all lengths from the airtime calculator:
+//   guard | transmit window | longest frame | ground turnaround +
+//   longest command (uplink receive window) | guard
+// The transmit window covers the sensor loop's latency in getting to the
+// radio; a guard covers the worst sync error between two payloads.
+//
+// Every payload in the fleet must share slotCount and the LoRa profile,
+// or their slots won't line up.
+//
+// Plain C++ with no Arduino dependencies so the host simulation
+// (tools/tdma_sim.cpp) runs the same schedule.
+class TdmaSchedule {
+public:
+  static const uint32_t TX_WINDOW_US = 50000;
+  static const uint32_t TURNAROUND_US = 50000; // ground answer latency
+  static const uint32_t GUARD_US = 5000;       // worst sync error allowed
+  static const uint32_t GPS_ERROR_US = 100;    // PPS-disciplined time base
+  static const uint32_t BEACON_ERROR_US = 1000; // rx timestamp, ground tx
+  static const uint32_t DRIFT_PPM = 50; // free-running crystal, worst case
+
+  TdmaSchedule(uint8_t nodeId, uint8_t slotCount)
+      : node(nodeId), slots(slotCount), slotLen(0), rxWindow(0),
+        beaconOffsetUs(0), beaconLocalUs(0), haveBeacon(false),
+        lastSlot(UINT64_MAX) {}
+
+  bool enabled() const { return slots > 0 && node < slots && slotLen > 0; }
+
+  // call at start-up and after every LoRa profile change
+  void configure(uint32_t frameAirtimeUs, uint32_t commandAirtimeUs) {
+    rxWindow = TURNAROUND_US + commandAirtimeUs;
+    slotLen = 2 * GUARD_US + TX_WINDOW_US + frameAirtimeUs + rxWindow;
+  }
+
+  uint32_t slotUs() const { return slotLen; }
+  uint64_t superframeUs() const { return (uint64_t)slotLen * slots; }
+  uint32_t rxWindowUs() const { return rxWindow; }
+
+  // localUs: the payload's free-running clock when the ground started
+  // transmitting the sync; groundUs: network time it carried
+  void beaconReceived(int64_t localUs, uint64_t groundUs) {
+    beaconOffsetUs = (int64_t)groundUs - localUs;
+    beaconLocalUs = localUs;
+    haveBeacon = true;
+  }
+
+  // network time: GPS when the time base is disciplined, else the local
+  // clock corrected by the last ground sync
+  uint64_t networkUs(int64_t localUs, bool gpsValid, uint64_t gpsUs) const {
+    if (gpsValid)
+      return gpsUs;
+    return (uint64_t)(localUs + (haveBeacon ? beaconOffsetUs : 0));
+  }
+
+  // bound on this payload's slot timing error right now
+  uint32_t syncErrorUs(int64_t localUs, bool gpsValid) const {
+    if (gpsValid)
+      return GPS_ERROR_US;
+    if (!haveBeacon)
+      return UINT32_MAX;
+    uint64_t drift = (uint64_t)(localUs - beaconLocalUs) * DRIFT_PPM / 1000000;
+    return drift > UINT32_MAX - BEACON_ERROR_US
+               ? UINT32_MAX
+               : BEACON_ERROR_US + (uint32_t)drift;
+  }
+
+  // within the guard, so slots can't overlap another synced payload's
+  bool isSynced(int64_t localUs, bool gpsValid) const {
+    return syncErrorUs(localUs, gpsValid) <= GUARD_US;
+  }
+
+  // true inside this payload's transmit window, once per superframe
+  bool mayTransmit(uint64_t netUs, bool synced) const {
+    if (!enabled())
+      return true;
+    uint64_t frame = netUs / superframeUs();
+    uint64_t offset = netUs % superframeUs();
+    uint64_t start = windowStart(frame, synced);
+    return offset >= start && offset - start < TX_WINDOW_US &&
+           frame != lastSlot;
+  }
+
+  void transmitted(uint64_t netUs) {
+    if (enabled())
+      lastSlot = netUs / superframeUs();
+  }
+
+  // time until the next transmit window opens (not the one we may be in),
+  // so the sensor loop can wake up for it
+  uint32_t usUntilWindow(uint64_t netUs, bool synced) const {
+    if (!enabled())
+      return UINT32_MAX;
+    uint64_t super = superframeUs();
+    uint64_t frame = netUs / super;
+    uint64_t offset = netUs % super;
+    uint64_t start = windowStart(frame, synced);
+    uint64_t wait = offset < start
+                        ? start - offset
+                        : super - offset + windowStart(frame + 1, synced);
+    return wait > UINT32_MAX ? UINT32_MAX : (uint32_t)wait;
+  }
+
+private:
+  uint64_t windowStart(uint64_t frame, bool synced) const {
+    if (synced)
+      return (uint64_t)node * slotLen + GUARD_US;
+    // integer hash of (node, superframe), spread over the superframe
+    uint32_t h = (uint32_t)frame * 2654435761u ^ (uint32_t)(frame >> 32) ^
+                 (node + 1u) * 40503u;
+    h ^= h >> 15;
+    h *= 2246822519u;
+    h ^= h >> 13;
+    return h % (superframeUs() - TX_WINDOW_US);
+  }
+
+  uint8_t node;
+  uint8_t slots;
+  uint32_t slotLen;
+  uint32_t rxWindow;
+  int64_t beaconOffsetUs;
+  int64_t beaconLocalUs;
+  bool haveBeacon;
+  uint64_t lastSlot; // superframe index of the last transmission
+};
+
+#endif // !TDMA_SCHEDULE_H
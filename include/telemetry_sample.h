@@ -0,0 +1,38 @@
+#ifndef TELEMETRY_SAMPLE_H
+#define TELEMETRY_SAMPLE_H
+
+#include <cstdint>
+
+// One acquisition pass over all sensors. Each group carries the time base
+// timestamp (see time_base.h) taken immediately after that sensor was read.
+struct TelemetrySample {
+  // timestamps are GPS UTC rather than time since boot
+  bool utc;
+
+  // bmp
+  uint64_t baro_us;
+  float temp_bmp;
+  float pressure;
+  float altitude;
+
+  // dht
+  uint64_t env_us;
+  float temp_dht;
+  float humidity;
+
+  // mpu
+  uint64_t imu_us;
+  float ax, ay, az;
+  float gx, gy, gz;
+
+  // compass
+  uint64_t mag_us;
+  float heading;
+
+  // gps
+  uint64_t gps_us;
+  int32_t lat_e7; // 1e-7 deg
+  int32_t lon_e7;
+};
+
+#endif // !TELEMETRY_SAMPLE_H
@@ -1,14 +1,8 @@
 #ifndef TEST_FUNCTIONS_H
 #define TEST_FUNCTIONS_H
 
-#include "bmp280_driver.h"
-#include "buzzer_driver.h"
-#include "compass_driver.h"
-#include "dht11_driver.h"
-#include "gps_driver.h"
-#include "lora_driver.h"
-#include "mpu6050_driver.h"
-#include "sdcard_driver.h"
+#include "board_config.h"
+#include "fast_math.h"
 #include "state_machine.h"
 #include <stdio.h>
 
@@ -52,7 +46,7 @@ bool testMPU6050(MPU6050_Driver &mpu)
   Serial.printf("  Gyro: X=%.2f Y=%.2f Z=%.2f °/s\n", gx, gy, gz);
 
   // Check if values are reasonable (not NaN, within expected ranges)
-  float accelMag = sqrt(ax * ax + ay * ay + az * az);
+  float accelMag = fastmath::norm3(ax, ay, az);
   return (accelMag >= 0.5f &&
           accelMag <= 2.0f); // Should be close to 1g at rest
 }
@@ -139,109 +133,45 @@ bool testLoRa(LoRaDriver &lora)
   return true;
 }
 
-bool testAllSensors(BMP280_Driver &bmp, DHT11_Driver &dht, MPU6050_Driver &mpu,
-                    Compass_Driver &compass, GPS_Driver &gps,
-                    Buzzer_Driver &buzzer, SDCard_Driver &sdcard,
-                    LoRaDriver &lora)
+// one overload per driver, so a board only pulls in the tests (and the
+// drivers) it fits
+inline bool testSensor(BMP280_Driver &bmp) { return testBMP280(bmp); }
+inline bool testSensor(DHT11_Driver &dht) { return testDHT11(dht); }
+inline bool testSensor(MPU6050_Driver &mpu) { return testMPU6050(mpu); }
+inline bool testSensor(Compass_Driver &compass) { return testCompass(compass); }
+inline bool testSensor(GPS_Driver &gps) { return testGPS(gps); }
+inline bool testSensor(Buzzer_Driver &buzzer) { return testBuzzer(buzzer); }
+inline bool testSensor(SDCard_Driver &sdcard) { return testSDCard(sdcard); }
+inline bool testSensor(LoRaDriver &lora) { return testLoRa(lora); }
+
+template <typename Driver> bool runTest(const char *name, Driver &driver)
 {
-  Serial.println("=== STARTING STATIC SENSOR TESTS ===");
-  bool allTestsPassed = true;
-
-  // Test BMP280
-  Serial.print("Testing BMP280... ");
-  if (testBMP280(bmp))
-  {
-    Serial.println("PASSED");
-  }
-  else
-  {
-    Serial.println("FAILED");
-    allTestsPassed = false;
-  }
-
-  // Test DHT11
-  Serial.print("Testing DHT11... ");
-  if (testDHT11(dht))
-  {
-    Serial.println("PASSED");
-  }
-  else
-  {
-    Serial.println("FAILED");
-    allTestsPassed = false;
-  }
-
-  // Test MPU6050
-  Serial.print("Testing MPU6050... ");
-  if (testMPU6050(mpu))
-  {
-    Serial.println("PASSED");
-  }
-  else
-  {
-    Serial.println("FAILED");
-    allTestsPassed = false;
-  }
-
-  // Test Compass
-  Serial.print("Testing Compass... ");
-  if (testCompass(compass))
-  {
-    Serial.println("PASSED");
-  }
-  else
-  {
-    Serial.println("FAILED");
-    allTestsPassed = false;
-  }
-
-  // Test GPS
-  Serial.print("Testing GPS... ");
-  if (testGPS(gps))
-  {
-    Serial.println("PASSED");
-  }
-  else
-  {
-    Serial.println("FAILED");
-    allTestsPassed = false;
-  }
+  Serial.printf("Testing %s... ", name);
+  bool passed = testSensor(driver);
+  Serial.println(passed ? "PASSED" : "FAILED");
+  return passed;
+}
 
-  // Test Buzzer
-  Serial.print("Testing Buzzer... ");
-  if (testBuzzer(buzzer))
-  {
-    Serial.println("PASSED");
-  }
-  else
-  {
-    Serial.println("FAILED");
-    allTestsPassed = false;
-  }
+// a role the board config leaves empty
+inline bool runTest(const char *name, NoSensor &)
+{
+  Serial.printf("Testing %s... not fitted\n", name);
+  return true;
+}
 
-  // Test SD Card
-  Serial.print("Testing SD Card... ");
-  if (testSDCard(sdcard))
-  {
-    Serial.println("PASSED");
-  }
-  else
-  {
-    Serial.println("FAILED");
-    allTestsPassed = false;
-  }
+bool testAllSensors(Payload &payload)
+{
+  Serial.println("=== STARTING STATIC SENSOR TESTS ===");
+  bool allTestsPassed = true;
 
-  // Test LoRa
-  Serial.print("Testing LoRa...");
-  if (testLoRa(lora))
-  {
-    Serial.println("PASSED");
-  }
-  else
-  {
-    Serial.println("FAILED");
-    allTestsPassed = false;
-  }
+  allTestsPassed &= runTest("BMP280", payload.sensors.baro());
+  allTestsPassed &= runTest("DHT11", payload.sensors.env());
+  allTestsPassed &= runTest("MPU6050", payload.sensors.imu());
+  allTestsPassed &= runTest("Compass", payload.sensors.mag());
+  allTestsPassed &= runTest("GPS", payload.sensors.gps());
+  allTestsPassed &= runTest("Buzzer", payload.buzzer);
+  allTestsPassed &= runTest("SD Card", payload.sdcard);
+  allTestsPassed &= runTest("LoRa", payload.lora);
 
   Serial.println("=== TEST SUMMARY ===");
   Serial.print("Overall result: ");
@@ -0,0 +1,26 @@
+#ifndef TIME_BASE_H
+#define TIME_BASE_H
+
+#include "gps_driver.h"
+#include <cstdint>
+
+// GPS PPS-disciplined microsecond clock. The PPS rising edge is captured in
+// an interrupt against esp_timer; once an edge has been paired with a GPS UTC
+// second, timeBaseNowUs() returns UTC microseconds since the Unix epoch with
+// the local oscillator rate corrected from consecutive PPS periods. Before
+// that it returns microseconds since boot.
+
+void timeBaseInit(uint8_t ppsPin);
+
+// call after gps.read(), pairs new PPS edges with the decoded NMEA time
+void timeBaseUpdate(GPS_Driver &gps);
+
+uint64_t timeBaseNowUs();
+
+// true once timestamps are in the GPS UTC domain
+bool timeBaseIsDisciplined();
+
+// measured local oscillator error in parts per million
+float timeBaseDriftPpm();
+
+#endif // !TIME_BASE_H
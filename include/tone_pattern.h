@@ -0,0 +1,155 @@
+#ifndef TONE_PATTERN_H
+#define TONE_PATTERN_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+// Buzzer sequences as a list of (frequency, duration) steps, frequency 0
+// being silence. Buzzer_Driver::play() steps through them from a timer, so
+// building and playing a pattern never blocks the caller.
+//
+// Plain C++ with no Arduino dependencies.
+
+namespace tones {
+
+static const int MAX_STEPS = 256;
+static const uint16_t STATUS_HZ = 2000;
+static const uint16_t MORSE_HZ = 1800;
+static const uint16_t CHIRP_HZ = 3500; // near the piezo's resonance
+static const uint16_t MORSE_UNIT_MS = 80; // 15 wpm
+
+struct ToneStep {
+  uint16_t freq; // Hz, 0 = silent
+  uint16_t ms;
+};
+
+struct TonePattern {
+  ToneStep steps[MAX_STEPS];
+  int count;
+  bool repeat; // loop until stopped
+
+  TonePattern() : count(0), repeat(false) {}
+
+  void clear() {
+    count = 0;
+    repeat = false;
+  }
+
+  // adjacent steps of the same frequency merge; false once full
+  bool add(uint16_t freq, uint16_t ms) {
+    if (count > 0 && steps[count - 1].freq == freq &&
+        steps[count - 1].ms + ms <= 0xFFFF) {
+      steps[count - 1].ms += ms;
+      return true;
+    }
+    if (count >= MAX_STEPS)
+      return false;
+    steps[count].freq = freq;
+    steps[count].ms = ms;
+    count++;
+    return true;
+  }
+
+  uint32_t durationMs() const {
+    uint32_t total = 0;
+    for (int i = 0; i < count; i++)
+      total += steps[i].ms;
+    return total;
+  }
+
+  // fraction of the pattern spent sounding
+  float dutyCycle() const {
+    uint32_t on = 0, total = durationMs();
+    for (int i = 0; i < count; i++)
+      if (steps[i].freq)
+        on += steps[i].ms;
+    return total ? (float)on / total : 0.0f;
+  }
+};
+
+// n beeps then a pause, e.g. 2 = calibrated, 3 = resumed after a reset
+inline void statusCode(TonePattern &p, int n) {
+  for (int i = 0; i < n; i++) {
+    p.add(STATUS_HZ, 150);
+    p.add(0, 150);
+  }
+  p.add(0, 850);
+}
+
+// International Morse for the characters a position needs
+inline const char *morseCode(char c) {
+  static const char *digits[] = {"-----", ".----", "..---", "...--", "....-",
+                                 ".....", "-....", "--...", "---..", "----."};
+  if (c >= '0' && c <= '9')
+    return digits[c - '0'];
+  switch (c) {
+  case '.':
+    return ".-.-.-";
+  case '-':
+    return "-....-";
+  case 'N':
+    return "-.";
+  case 'S':
+    return "...";
+  case 'E':
+    return ".";
+  case 'W':
+    return ".--";
+  }
+  return nullptr;
+}
+
+// standard timing: dot 1 unit, dash 3, 1 between elements, 3 between
+// characters, 7 between words; unknown characters are skipped
+inline void morse(TonePattern &p, const char *text) {
+  const uint16_t u = MORSE_UNIT_MS;
+  for (const char *c = text; *c; c++) {
+    if (*c == ' ') {
+      p.add(0, 4 * u); // plus the 3 after the previous character
+      continue;
+    }
+    const char *code = morseCode(*c);
+    if (!code)
+      continue;
+    for (const char *e = code; *e; e++) {
+      p.add(MORSE_HZ, *e == '-' ? 3 * u : u);
+      p.add(0, u);
+    }
+    p.add(0, 2 * u);
+  }
+}
+
+// "33.8568S 151.2153E": 4 decimals (~10 m), hemisphere letters
+inline void formatFix(int32_t lat_e7, int32_t lon_e7, char *out, size_t len) {
+  uint32_t lat = lat_e7 < 0 ? -(uint32_t)lat_e7 : (uint32_t)lat_e7;
+  uint32_t lon = lon_e7 < 0 ? -(uint32_t)lon_e7 : (uint32_t)lon_e7;
+  lat = (lat + 500) / 1000;
+  lon = (lon + 500) / 1000;
+  snprintf(out, len, "%lu.%04lu%c %lu.%04lu%c", (unsigned long)(lat / 10000),
+           (unsigned long)(lat % 10000), lat_e7 < 0 ? 'S' : 'N',
+           (unsigned long)(lon / 10000), (unsigned long)(lon % 10000),
+           lon_e7 < 0 ? 'W' : 'E');
+}
+
+// last fix in Morse, preceded by a long attention tone
+inline void morseFix(TonePattern &p, int32_t lat_e7, int32_t lon_e7) {
+  char text[24];
+  formatFix(lat_e7, lon_e7, text, sizeof(text));
+  p.add(MORSE_HZ, 1000);
+  p.add(0, 7 * MORSE_UNIT_MS);
+  morse(p, text);
+}
+
+// short high chirps, one a second, to home in on the payload by ear at a
+// 4% duty
+inline void locateChirps(TonePattern &p, int chirps) {
+  for (int i = 0; i < chirps; i++) {
+    p.add(CHIRP_HZ, 40);
+    p.add(0, 960);
+  }
+}
+
+} // namespace tones
+
+#endif // !TONE_PATTERN_H
@@ -0,0 +1,56 @@
+#ifndef UPLINK_COUNTER_STORE_H
+#define UPLINK_COUNTER_STORE_H
+
+#include "debug_log.h"
+#include "log_codec.h"
+#include <Arduino.h>
+#include <Preferences.h>
+#include <cstdint>
+
+// Keeps the last accepted uplink command counter in NVS, so the replay
+// check (command_dispatcher.h) survives power cycles and pad reboots, not
+// only the in-flight resets the RTC checkpoint covers. Written once per
+// accepted command, which is a handful per flight.
+class UplinkCounterStore {
+public:
+  // 0 when nothing valid is stored
+  uint32_t load() {
+    Record r;
+    Preferences prefs;
+    if (!prefs.begin("uplink", true))
+      return 0;
+    size_t n = prefs.getBytesLength("counter") == sizeof(r)
+                   ? prefs.getBytes("counter", &r, sizeof(r))
+                   : 0;
+    prefs.end();
+    if (n != sizeof(r) || r.crc != crcOf(r))
+      return 0;
+    return r.counter;
+  }
+
+  bool save(uint32_t counter) {
+    Record r;
+    r.counter = counter;
+    r.crc = crcOf(r);
+    Preferences prefs;
+    if (!prefs.begin("uplink", false))
+      return false;
+    bool ok = prefs.putBytes("counter", &r, sizeof(r)) == sizeof(r);
+    prefs.end();
+    if (!ok)
+      DLOG_WARN("Uplink counter not saved");
+    return ok;
+  }
+
+private:
+  struct Record {
+    uint32_t counter;
+    uint32_t crc;
+  };
+
+  static uint32_t crcOf(const Record &r) {
+    return logcodec::crc32((const uint8_t *)&r.counter, sizeof(r.counter));
+  }
+};
+
+#endif // !UPLINK_COUNTER_STORE_H
@@ -0,0 +1,180 @@
+#ifndef UPLINK_PROTOCOL_H
+#define UPLINK_PROTOCOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Ground-to-payload command frames. Every command carries a counter that
+// must increase from one accepted command to the next (replay protection)
+// and a SipHash-2-4 tag keyed with a pre-shared 128-bit key, so a stray or
+// forged packet on the channel is dropped without being acted on.
+//
+// Command (little endian):
+//   u8 COMMAND_MAGIC, u32 counter, u8 opcode, u8 argument length,
+//   arguments, u64 tag over everything before it
+//
+// Arguments:
+//   PING              none
+//   SET_LOG_LEVEL     u8 DLOG_LEVEL_*
+//   SET_SAMPLE_PERIOD u16 ms
+//   SET_LORA_PROFILE  u8 spreading factor, u32 bandwidth Hz, u8 coding
+//                     rate denominator
+//   RESEND_LOG        u32 first block index, u8 block count
+//   TIME_SYNC         u64 network time us (GPS UTC) when the ground started
+//                     sending this command (tdma_schedule.h)
+//
+// Acks go back in the downlink (downlink_scheduler.h, MSG_ACK) with the
+// command counter and one of the ACK_* status codes. Commands that fail
+// authentication are never acked.
+//
+// Plain C++ with no Arduino dependencies so the host tools share it.
+
+namespace uplink {
+
+static const uint8_t COMMAND_MAGIC = 0xC3;
+static const size_t HEADER_BYTES = 7;
+static const size_t TAG_BYTES = 8;
+static const size_t MAX_ARG_BYTES = 16;
+static const size_t MAX_COMMAND_BYTES = HEADER_BYTES + MAX_ARG_BYTES + TAG_BYTES;
+static const size_t KEY_BYTES = 16;
+
+enum Opcode : uint8_t {
+  CMD_PING,
+  CMD_SET_LOG_LEVEL,
+  CMD_SET_SAMPLE_PERIOD,
+  CMD_SET_LORA_PROFILE,
+  CMD_RESEND_LOG,
+  CMD_TIME_SYNC,
+  CMD_OPCODE_COUNT
+};
+
+enum AckStatus : uint8_t {
+  ACK_OK,
+  ACK_BAD_ARGS,
+  ACK_UNKNOWN_OPCODE,
+  ACK_WRONG_STATE, // not allowed in the current flight state
+  ACK_BUSY
+};
+
+enum ParseResult { PARSE_OK, PARSE_MALFORMED, PARSE_BAD_TAG };
+
+struct Command {
+  uint32_t counter;
+  uint8_t opcode;
+  uint8_t argLen;
+  uint8_t args[MAX_ARG_BYTES];
+};
+
+static inline uint16_t get16(const uint8_t *p) {
+  return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t get32(const uint8_t *p) {
+  return (uint32_t)get16(p) | ((uint32_t)get16(p + 2) << 16);
+}
+
+static inline uint64_t get64(const uint8_t *p) {
+  return (uint64_t)get32(p) | ((uint64_t)get32(p + 4) << 32);
+}
+
+static inline void put32(uint8_t *p, uint32_t v) {
+  for (int i = 0; i < 4; i++)
+    p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static inline void put64(uint8_t *p, uint64_t v) {
+  put32(p, (uint32_t)v);
+  put32(p + 4, (uint32_t)(v >> 32));
+}
+
+static inline uint64_t rotl(uint64_t x, int b) {
+  return (x << b) | (x >> (64 - b));
+}
+
+static inline void sipRound(uint64_t &v0, uint64_t &v1, uint64_t &v2,
+                            uint64_t &v3) {
+  v0 += v1;
+  v1 = rotl(v1, 13) ^ v0;
+  v0 = rotl(v0, 32);
+  v2 += v3;
+  v3 = rotl(v3, 16) ^ v2;
+  v0 += v3;
+  v3 = rotl(v3, 21) ^ v0;
+  v2 += v1;
+  v1 = rotl(v1, 17) ^ v2;
+  v2 = rotl(v2, 32);
+}
+
+// SipHash-2-4 (Aumasson & Bernstein), 64-bit output
+static inline uint64_t siphash24(const uint8_t *key, const uint8_t *data,
+                                 size_t len) {
+  const uint64_t k0 = get64(key), k1 = get64(key + 8);
+  uint64_t v0 = k0 ^ 0x736f6d6570736575ULL;
+  uint64_t v1 = k1 ^ 0x646f72616e646f6dULL;
+  uint64_t v2 = k0 ^ 0x6c7967656e657261ULL;
+  uint64_t v3 = k1 ^ 0x7465646279746573ULL;
+
+  size_t full = len & ~(size_t)7;
+  for (size_t i = 0; i < full; i += 8) {
+    uint64_t m = get64(data + i);
+    v3 ^= m;
+    sipRound(v0, v1, v2, v3);
+    sipRound(v0, v1, v2, v3);
+    v0 ^= m;
+  }
+  uint64_t b = (uint64_t)len << 56;
+  for (size_t i = full; i < len; i++)
+    b |= (uint64_t)data[i] << (8 * (i - full));
+  v3 ^= b;
+  sipRound(v0, v1, v2, v3);
+  sipRound(v0, v1, v2, v3);
+  v0 ^= b;
+
+  v2 ^= 0xff;
+  for (int i = 0; i < 4; i++)
+    sipRound(v0, v1, v2, v3);
+  return v0 ^ v1 ^ v2 ^ v3;
+}
+
+// Builds a signed command into out (MAX_COMMAND_BYTES). Returns its length,
+// 0 if the arguments are too long.
+static inline size_t encodeCommand(const uint8_t *key, uint32_t counter,
+                                   uint8_t opcode, const uint8_t *args,
+                                   size_t argLen, uint8_t *out) {
+  if (argLen > MAX_ARG_BYTES)
+    return 0;
+  out[0] = COMMAND_MAGIC;
+  put32(out + 1, counter);
+  out[5] = opcode;
+  out[6] = (uint8_t)argLen;
+  if (argLen)
+    memcpy(out + HEADER_BYTES, args, argLen);
+  size_t len = HEADER_BYTES + argLen;
+  put64(out + len, siphash24(key, out, len));
+  return len + TAG_BYTES;
+}
+
+// Checks framing and tag; replay checking is up to the caller
+static inline ParseResult parseCommand(const uint8_t *key, const uint8_t *buf,
+                                       size_t len, Command &cmd) {
+  if (len < HEADER_BYTES + TAG_BYTES || buf[0] != COMMAND_MAGIC)
+    return PARSE_MALFORMED;
+  size_t argLen = buf[6];
+  if (argLen > MAX_ARG_BYTES || len != HEADER_BYTES + argLen + TAG_BYTES)
+    return PARSE_MALFORMED;
+  size_t signedLen = HEADER_BYTES + argLen;
+  // compare without an early exit so timing does not leak the tag
+  uint64_t diff = siphash24(key, buf, signedLen) ^ get64(buf + signedLen);
+  if (diff != 0)
+    return PARSE_BAD_TAG;
+  cmd.counter = get32(buf + 1);
+  cmd.opcode = buf[5];
+  cmd.argLen = (uint8_t)argLen;
+  memcpy(cmd.args, buf + HEADER_BYTES, argLen);
+  return PARSE_OK;
+}
+
+} // namespace uplink
+
+#endif // !UPLINK_PROTOCOL_H
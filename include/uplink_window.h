@@ -0,0 +1,68 @@
+#ifndef UPLINK_WINDOW_H
+#define UPLINK_WINDOW_H
+
+#include "command_dispatcher.h"
+#include "uplink_protocol.h"
+#include <cstddef>
+#include <cstdint>
+
+// Short receive window opened right after each downlink transmission, so
+// the ground station knows when the payload is listening. Outside the
+// windows the radio stays idle and transmits on schedule.
+//
+// Radio is LoRaDriver on the payload, LoopbackRadio (loopback_radio.h) on
+// the host; it needs startReceive(), stopReceive() and
+// receivePacket(buffer, maxLen) returning the packet length, 0 when nothing
+// arrived or negative for a bad packet.
+template <typename Radio> class UplinkWindow {
+public:
+  UplinkWindow(Radio &radio, uint32_t windowMs)
+      : radio(radio), windowMs(windowMs), open(false), openedMs(0),
+        received(0) {}
+
+  // call right after a downlink frame went out
+  void afterTransmit(uint32_t nowMs) {
+    radio.startReceive();
+    open = true;
+    openedMs = nowMs;
+  }
+
+  // Hands any received command to the dispatcher and closes the window
+  // once it expires. Returns true if a command was accepted.
+  bool poll(uint32_t nowMs, CommandDispatcher &dispatcher,
+            DownlinkScheduler &downlink) {
+    if (!open)
+      return false;
+    bool accepted = false;
+    uint8_t buf[uplink::MAX_COMMAND_BYTES];
+    int len = radio.receivePacket(buf, sizeof(buf));
+    if (len > 0) {
+      accepted = dispatcher.receive(buf, (size_t)len, downlink);
+      received++;
+    }
+    if (nowMs - openedMs >= windowMs) {
+      radio.stopReceive();
+      open = false;
+    } else if (len != 0) {
+      radio.startReceive(); // the radio drops out of receive per packet
+    }
+    return accepted;
+  }
+
+  // takes effect from the next window
+  void setWindowMs(uint32_t ms) { windowMs = ms; }
+
+  // no transmission while the ground may still be talking
+  bool isOpen() const { return open; }
+
+  uint32_t packetsReceived() const { return received; }
+
+private:
+  Radio &radio;
+  uint32_t windowMs;
+  bool open;
+  uint32_t openedMs;
+  uint32_t received;
+};
+
+#endif // !UPLINK_WINDOW_H
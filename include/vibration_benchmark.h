@@ -0,0 +1,81 @@
+#ifndef VIBRATION_BENCHMARK_H
+#define VIBRATION_BENCHMARK_H
+
+#include "bench_report.h"
+#include "vibration_spectrum.h"
+#include <Arduino.h>
+#include <new>
+
+// On-target cost of the vibration stage per window size: one complex FFT
+// with the scalar reference and the esp-dsp kernel, then a whole window
+// through VibrationAnalyzer (two sensors, four transforms), as a share of
+// the time the window spans at 1 kHz. Run from setup() in the
+// esp32dev_bench env.
+
+static const int VIBRATION_BENCH_ROUNDS = 8;
+static const uint16_t VIBRATION_BENCH_RATE_HZ = 1000;
+
+static volatile float vibrationBenchSink;
+
+template <int N> static void benchVibrationWindow() {
+  const float cpuMHz = ESP.getCpuFreqMHz();
+  static float x[2 * N];
+  uint32_t scalar = 0, kernel = 0;
+  for (int r = 0; r < VIBRATION_BENCH_ROUNDS; r++) {
+    for (int i = 0; i < 2 * N; i++)
+      x[i] = sinf(0.37f * i);
+    uint32_t t0 = ESP.getCycleCount();
+    vibration::fftScalar(x, N);
+    scalar += ESP.getCycleCount() - t0;
+    for (int i = 0; i < 2 * N; i++)
+      x[i] = sinf(0.37f * i);
+    t0 = ESP.getCycleCount();
+    vibration::fft(x, N);
+    kernel += ESP.getCycleCount() - t0;
+    vibrationBenchSink = x[2];
+  }
+
+  // too big to keep around for every size
+  vibration::VibrationAnalyzer<N> *analyzer = new (std::nothrow)
+      vibration::VibrationAnalyzer<N>(VIBRATION_BENCH_RATE_HZ);
+  if (!analyzer) {
+    Serial.printf("  %5d  no memory for the analyzer\n", N);
+    return;
+  }
+  float accel[3] = {0, 0, 1}, gyro[3] = {0, 0, 0};
+  for (int i = 0; i < N - 1; i++) {
+    accel[0] = 0.5f * sinf(0.53f * i);
+    analyzer->push(accel, gyro, i, false);
+  }
+  uint32_t t0 = ESP.getCycleCount();
+  analyzer->push(accel, gyro, N, false); // completes the window
+  uint32_t window = ESP.getCycleCount() - t0;
+  vibrationBenchSink = analyzer->summary(vibration::CH_ACCEL).peakHz;
+  delete analyzer;
+
+  float windowUs = window / cpuMHz;
+  float spanUs = 1e6f * N / VIBRATION_BENCH_RATE_HZ;
+  Serial.printf("  %5d  scalar %8.1f us  kernel %8.1f us  window %8.1f us"
+                "  %5.2f%% cpu\n",
+                N, scalar / cpuMHz / VIBRATION_BENCH_ROUNDS,
+                kernel / cpuMHz / VIBRATION_BENCH_ROUNDS, windowUs,
+                100.0f * windowUs / spanUs);
+  char key[24];
+  snprintf(key, sizeof(key), "fft%d", N);
+  benchReportTicks("vibration", key, kernel, VIBRATION_BENCH_ROUNDS);
+  snprintf(key, sizeof(key), "window%d", N);
+  benchReportTicks("vibration", key, window, 1);
+}
+
+void runVibrationBenchmark() {
+  Serial.println("=== VIBRATION FFT BENCHMARK ===");
+  Serial.printf("  esp-dsp kernels: %s\n",
+                VIBRATION_USE_ESP_DSP ? "yes" : "no");
+  benchVibrationWindow<64>();
+  benchVibrationWindow<128>();
+  benchVibrationWindow<256>();
+  benchVibrationWindow<512>();
+  benchVibrationWindow<1024>();
+}
+
+#endif // !VIBRATION_BENCHMARK_H
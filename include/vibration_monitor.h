@@ -0,0 +1,41 @@
+#ifndef VIBRATION_MONITOR_H
+#define VIBRATION_MONITOR_H
+
+#include "mpu6050_driver.h"
+#include "vibration_spectrum.h"
+#include <cstdint>
+
+// Motor and airframe vibration from the MPU6050 FIFO. A task drains the
+// FIFO at VIBRATION_RATE_HZ, runs VIBRATION_WINDOW-point spectra over it
+// (vibration_spectrum.h) and logs one summary per sensor and window. The
+// sensor loop gets the mean of the samples drained since its last pass in
+// place of a single register read, which doubles as the anti-aliasing the
+// wider IMU low-pass now needs.
+//
+// The task shares the I2C bus with the sensor loop; the ESP32 Wire driver
+// holds its lock for a whole register read, repeated start included.
+
+#ifndef VIBRATION_RATE_HZ
+#define VIBRATION_RATE_HZ 1000
+#endif
+
+#ifndef VIBRATION_WINDOW
+#define VIBRATION_WINDOW 256
+#endif
+
+void vibrationMonitorInit(MPU6050_Driver &mpu);
+
+// stops the FIFO before the IMU is powered down
+void vibrationMonitorStop();
+
+// mean accel (g) and gyro (rad/s) since the last call; false if no sample
+// arrived, e.g. before init or after stop
+bool vibrationTakeImuMean(float accel[3], float gyro[3]);
+
+// newest accelerometer summary, once per window (for the downlink)
+bool vibrationTakeSummary(vibration::Summary &s);
+
+uint32_t vibrationWindows();
+uint32_t vibrationOverflows();
+
+#endif // !VIBRATION_MONITOR_H
@@ -0,0 +1,288 @@
+#ifndef VIBRATION_SPECTRUM_H
+#define VIBRATION_SPECTRUM_H
+
+#include "log_codec.h"
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Vibration spectra of fixed-rate IMU blocks, reduced to a few numbers per
+// window: RMS, dominant frequency and RMS in a handful of bands. Power is
+// summed over the three axes of each sensor after removing the window
+// mean, so gravity, bias and mounting orientation drop out.
+//
+// The FFT is the esp-dsp radix-2 kernel on target and a plain scalar loop
+// elsewhere (or with -DVIBRATION_SCALAR_FFT), which is the reference.
+//
+// Log record (little endian, RECORD_BYTES, 16 to a 512-byte batch):
+//   u8 RECORD_MAGIC, u8 channel (bit 7: timestamp is GPS UTC),
+//   u16 sample rate Hz, u16 window size, u16 dominant frequency 0.1 Hz,
+//   u16 RMS, u16 band RMS x BANDS (mg or mrad/s), u64 time base us of the
+//   window's last sample, u16 low half of the CRC-32 of the bytes before
+
+#if defined(ARDUINO_ARCH_ESP32) && !defined(VIBRATION_SCALAR_FFT) &&          \
+    __has_include(<esp_dsp.h>)
+#include <esp_dsp.h>
+#define VIBRATION_USE_ESP_DSP 1
+#else
+#define VIBRATION_USE_ESP_DSP 0
+#endif
+
+namespace vibration {
+
+enum Channel { CH_ACCEL, CH_GYRO, CHANNELS };
+
+static const int MAX_WINDOW = 1024;
+static const int BANDS = 6;
+static const uint8_t RECORD_MAGIC = 0x56; // "V"
+static const size_t RECORD_BYTES = 32;
+
+// band edges in Hz; below the first edge is rigid-body motion, not
+// vibration, and bands end at Nyquist
+inline const float *bandEdges() {
+  static const float edges[BANDS + 1] = {2, 10, 30, 60, 120, 250, 500};
+  return edges;
+}
+
+struct Summary {
+  uint64_t t_us; // last sample of the window
+  bool utc;
+  uint8_t channel;
+  uint16_t sampleRateHz;
+  uint16_t windowSize;
+  float rms; // g or rad/s
+  float peakHz;
+  float bandRms[BANDS];
+};
+
+// In-place complex FFT of n (a power of two) interleaved re/im pairs,
+// output in natural order.
+inline void fftScalar(float *x, int n) {
+  for (int i = 1, j = 0; i < n; i++) {
+    int bit = n >> 1;
+    for (; j & bit; bit >>= 1)
+      j ^= bit;
+    j |= bit;
+    if (i < j) {
+      float t = x[2 * i];
+      x[2 * i] = x[2 * j];
+      x[2 * j] = t;
+      t = x[2 * i + 1];
+      x[2 * i + 1] = x[2 * j + 1];
+      x[2 * j + 1] = t;
+    }
+  }
+  const float pi = 3.14159265f;
+  for (int len = 2; len <= n; len <<= 1) {
+    int half = len >> 1;
+    for (int k = 0; k < half; k++) {
+      float wr = cosf(2.0f * pi * k / len);
+      float wi = -sinf(2.0f * pi * k / len);
+      for (int i = k; i < n; i += len) {
+        float *a = x + 2 * i, *b = x + 2 * (i + half);
+        float tr = b[0] * wr - b[1] * wi;
+        float ti = b[0] * wi + b[1] * wr;
+        b[0] = a[0] - tr;
+        b[1] = a[1] - ti;
+        a[0] += tr;
+        a[1] += ti;
+      }
+    }
+  }
+}
+
+inline void fft(float *x, int n) {
+#if VIBRATION_USE_ESP_DSP
+  // twiddles for every size up to MAX_WINDOW, built on first use
+  static float table[MAX_WINDOW];
+  static bool tableReady = false;
+  if (!tableReady)
+    tableReady = dsps_fft2r_init_fc32(table, MAX_WINDOW) == ESP_OK;
+  if (tableReady) {
+    dsps_fft2r_fc32(x, n);
+    dsps_bit_rev_fc32(x, n);
+    return;
+  }
+#endif
+  fftScalar(x, n);
+}
+
+inline uint16_t sat16u(float v) {
+  if (!(v > 0.0f))
+    return 0;
+  return v > 65535.0f ? 0xFFFF : (uint16_t)lrintf(v);
+}
+
+inline void put16(uint8_t *p, uint16_t v) {
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+}
+
+inline uint16_t get16(const uint8_t *p) {
+  return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+inline void encodeRecord(const Summary &s, uint8_t *out) {
+  out[0] = RECORD_MAGIC;
+  out[1] = (uint8_t)(s.channel | (s.utc ? 0x80 : 0));
+  put16(out + 2, s.sampleRateHz);
+  put16(out + 4, s.windowSize);
+  put16(out + 6, sat16u(s.peakHz * 10.0f));
+  put16(out + 8, sat16u(s.rms * 1000.0f));
+  for (int b = 0; b < BANDS; b++)
+    put16(out + 10 + 2 * b, sat16u(s.bandRms[b] * 1000.0f));
+  for (int i = 0; i < 8; i++)
+    out[22 + i] = (uint8_t)(s.t_us >> (8 * i));
+  put16(out + 30, (uint16_t)logcodec::crc32(out, 30));
+}
+
+// false for padding or a damaged record
+inline bool decodeRecord(const uint8_t *in, Summary &s) {
+  if (in[0] != RECORD_MAGIC ||
+      get16(in + 30) != (uint16_t)logcodec::crc32(in, 30))
+    return false;
+  s.channel = in[1] & 0x7F;
+  s.utc = in[1] & 0x80;
+  s.sampleRateHz = get16(in + 2);
+  s.windowSize = get16(in + 4);
+  s.peakHz = get16(in + 6) * 0.1f;
+  s.rms = get16(in + 8) * 0.001f;
+  for (int b = 0; b < BANDS; b++)
+    s.bandRms[b] = get16(in + 10 + 2 * b) * 0.001f;
+  s.t_us = 0;
+  for (int i = 0; i < 8; i++)
+    s.t_us |= (uint64_t)in[22 + i] << (8 * i);
+  return true;
+}
+
+// Collects N samples of both sensors at a fixed rate and summarizes each
+// full window. N is a power of two up to MAX_WINDOW; windows don't
+// overlap.
+template <int N> class VibrationAnalyzer {
+  static_assert(N >= 16 && N <= MAX_WINDOW && (N & (N - 1)) == 0,
+                "window must be a power of two");
+
+public:
+  explicit VibrationAnalyzer(uint16_t sampleRateHz = 1000)
+      : rateHz(sampleRateHz), fill(0) {
+    const float pi = 3.14159265f;
+    windowPower = 0.0f;
+    for (int i = 0; i < N; i++) {
+      window[i] = 0.5f - 0.5f * cosf(2.0f * pi * i / N); // Hann
+      windowPower += window[i] * window[i];
+    }
+  }
+
+  void reset() { fill = 0; }
+  uint16_t sampleRate() const { return rateHz; }
+
+  // accel in g, gyro in rad/s; true when this sample completed a window
+  // and summary() holds both channels
+  bool push(const float accel[3], const float gyro[3], uint64_t t_us,
+            bool utc) {
+    for (int a = 0; a < 3; a++) {
+      data[CH_ACCEL][a][fill] = accel[a];
+      data[CH_GYRO][a][fill] = gyro[a];
+    }
+    if (++fill < N)
+      return false;
+    fill = 0;
+    for (int c = 0; c < CHANNELS; c++)
+      analyze(c, t_us, utc);
+    return true;
+  }
+
+  const Summary &summary(int channel) const { return result[channel]; }
+
+private:
+  // One complex FFT carries two real axes (x + iy). For real inputs the
+  // power of both at bin k is (|Z[k]|^2 + |Z[N-k]|^2) / 2, which is all we
+  // need, so three axes take two transforms.
+  void analyze(int c, uint64_t t_us, bool utc) {
+    float mean[3], sq = 0.0f;
+    for (int a = 0; a < 3; a++) {
+      float sum = 0.0f;
+      for (int i = 0; i < N; i++)
+        sum += data[c][a][i];
+      mean[a] = sum / N;
+      for (int i = 0; i < N; i++) {
+        float d = data[c][a][i] - mean[a];
+        sq += d * d;
+      }
+    }
+
+    for (int i = 0; i < N; i++) {
+      work[0][2 * i] = (data[c][0][i] - mean[0]) * window[i];
+      work[0][2 * i + 1] = (data[c][1][i] - mean[1]) * window[i];
+      work[1][2 * i] = (data[c][2][i] - mean[2]) * window[i];
+      work[1][2 * i + 1] = 0.0f;
+    }
+    fft(work[0], N);
+    fft(work[1], N);
+
+    // one-sided mean-square per bin (Parseval, Hann power corrected)
+    const float norm = 1.0f / (N * windowPower);
+    for (int k = 1; k < N / 2; k++) {
+      float p = 0.0f;
+      for (int w = 0; w < 2; w++) {
+        const float *z = work[w];
+        p += z[2 * k] * z[2 * k] + z[2 * k + 1] * z[2 * k + 1] +
+             z[2 * (N - k)] * z[2 * (N - k)] +
+             z[2 * (N - k) + 1] * z[2 * (N - k) + 1];
+      }
+      power[k] = p * norm;
+    }
+
+    Summary &s = result[c];
+    s.t_us = t_us;
+    s.utc = utc;
+    s.channel = (uint8_t)c;
+    s.sampleRateHz = rateHz;
+    s.windowSize = N;
+    s.rms = sqrtf(sq / N);
+
+    const float binHz = (float)rateHz / N;
+    const float *edges = bandEdges();
+    int peak = 0;
+    for (int b = 0; b < BANDS; b++)
+      s.bandRms[b] = 0.0f;
+    for (int k = 1; k < N / 2; k++) {
+      float f = k * binHz;
+      if (f < edges[0])
+        continue;
+      int b = 0;
+      while (b < BANDS - 1 && f >= edges[b + 1])
+        b++;
+      s.bandRms[b] += power[k];
+      if (!peak || power[k] > power[peak])
+        peak = k;
+    }
+    for (int b = 0; b < BANDS; b++)
+      s.bandRms[b] = sqrtf(s.bandRms[b]);
+
+    // parabolic interpolation between the neighbouring bins
+    float offset = 0.0f;
+    if (peak > 1 && peak < N / 2 - 1) {
+      float l = sqrtf(power[peak - 1]), m = sqrtf(power[peak]),
+            r = sqrtf(power[peak + 1]);
+      float d = l - 2.0f * m + r;
+      if (d < 0.0f)
+        offset = 0.5f * (l - r) / d;
+    }
+    s.peakHz = peak ? (peak + offset) * binHz : 0.0f;
+  }
+
+  uint16_t rateHz;
+  int fill;
+  float data[CHANNELS][3][N];
+  float window[N];
+  float windowPower;
+  float work[2][2 * N];
+  float power[N / 2];
+  Summary result[CHANNELS];
+};
+
+} // namespace vibration
+
+#endif // !VIBRATION_SPECTRUM_H
@@ -0,0 +1,216 @@
+#include "../include/debug_log.h"
+#include "../include/memory_monitor.h"
+#include <Arduino.h>
+#include <atomic>
+
+static const uint32_t RING_SIZE = 64; // entries, power of two
+static const uint32_t DRAIN_STACK_BYTES = 3072;
+static const UBaseType_t DRAIN_PRIORITY = 0; // idle-level, below logger
+static const TickType_t DRAIN_PERIOD_TICKS = pdMS_TO_TICKS(10);
+
+static const uint8_t FRAME_SYNC0 = 0xA5;
+static const uint8_t FRAME_SYNC1 = 0x5A;
+
+volatile uint8_t debugLogRuntimeLevel = DLOG_LEVEL;
+
+// bounded lock-free queue (Vyukov): each cell's sequence tells producers
+// and the consumer whose turn it is. Sequences are stored minus the cell
+// index so the zero-initialized ring is already valid before init.
+struct RingCell {
+  std::atomic<uint32_t> seq;
+  DebugLogEntry entry;
+};
+
+static RingCell ring[RING_SIZE];
+static std::atomic<uint32_t> enqueuePos(0);
+static uint32_t dequeuePos = 0; // drain task only
+static std::atomic<uint32_t> dropped(0);
+static volatile bool binaryMode = false;
+static bool started = false;
+
+MEMORY_TAG("dlog", ring);
+
+void debugLogPush(const DebugLogEntry &entry) {
+  uint32_t pos = enqueuePos.load(std::memory_order_relaxed);
+  for (;;) {
+    uint32_t idx = pos & (RING_SIZE - 1);
+    RingCell &cell = ring[idx];
+    uint32_t seq = cell.seq.load(std::memory_order_acquire) + idx;
+    int32_t dif = (int32_t)(seq - pos);
+    if (dif == 0) {
+      if (enqueuePos.compare_exchange_weak(pos, pos + 1,
+                                           std::memory_order_relaxed)) {
+        cell.entry = entry;
+        cell.seq.store(pos + 1 - idx, std::memory_order_release);
+        return;
+      }
+    } else if (dif < 0) {
+      dropped.fetch_add(1, std::memory_order_relaxed); // full
+      return;
+    } else {
+      pos = enqueuePos.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+static bool popEntry(DebugLogEntry &out) {
+  uint32_t idx = dequeuePos & (RING_SIZE - 1);
+  RingCell &cell = ring[idx];
+  uint32_t seq = cell.seq.load(std::memory_order_acquire) + idx;
+  if ((int32_t)(seq - (dequeuePos + 1)) < 0)
+    return false;
+  out = cell.entry;
+  cell.seq.store(dequeuePos + RING_SIZE - idx, std::memory_order_release);
+  dequeuePos++;
+  return true;
+}
+
+static uint8_t argType(const DebugLogEntry &e, int i) {
+  return (e.types >> (2 * i)) & 0x3;
+}
+
+// printf-style expansion of a captured entry, one conversion at a time
+static size_t formatEntry(const DebugLogEntry &e, char *out, size_t cap) {
+  static const char levelChar[] = {'-', 'E', 'W', 'I', 'D'};
+  size_t n = snprintf(out, cap, "[%10.6f] %c ", e.timestamp_us * 1e-6,
+                      levelChar[e.level <= DLOG_LEVEL_DEBUG ? e.level : 0]);
+  int arg = 0;
+  for (const char *p = e.fmt; *p && n < cap - 1;) {
+    if (*p != '%') {
+      out[n++] = *p++;
+      continue;
+    }
+    if (p[1] == '%') {
+      out[n++] = '%';
+      p += 2;
+      continue;
+    }
+    // copy flags, width and precision; drop length modifiers
+    char spec[16];
+    size_t s = 0;
+    spec[s++] = *p++;
+    while (*p && strchr("-+ #0123456789.", *p) && s < sizeof(spec) - 3)
+      spec[s++] = *p++;
+    while (*p && strchr("hlLqjzt", *p))
+      p++;
+    char conv = *p ? *p++ : 'd';
+    if (arg >= e.nargs) {
+      n += snprintf(out + n, cap - n, "?");
+      continue;
+    }
+    uint32_t raw = e.args[arg];
+    uint8_t type = argType(e, arg++);
+    if (strchr("fFeEgGaA", conv)) {
+      spec[s++] = conv;
+      spec[s] = '\0';
+      float f;
+      memcpy(&f, &raw, sizeof(f));
+      n += snprintf(out + n, cap - n, spec,
+                    type == DLOG_ARG_FLOAT ? (double)f : (double)(int32_t)raw);
+    } else if (conv == 's') {
+      spec[s++] = 's';
+      spec[s] = '\0';
+      n += snprintf(out + n, cap - n, spec,
+                    type == DLOG_ARG_STRING ? e.str : "?");
+    } else if (conv == 'c') {
+      spec[s++] = 'c';
+      spec[s] = '\0';
+      n += snprintf(out + n, cap - n, spec, (int)raw);
+    } else {
+      spec[s++] = 'l';
+      spec[s++] = conv;
+      spec[s] = '\0';
+      if (type == DLOG_ARG_FLOAT) {
+        float f;
+        memcpy(&f, &raw, sizeof(f));
+        raw = (uint32_t)(int32_t)f;
+      }
+      if (conv == 'd' || conv == 'i')
+        n += snprintf(out + n, cap - n, spec, (long)(int32_t)raw);
+      else
+        n += snprintf(out + n, cap - n, spec, (unsigned long)raw);
+    }
+    if (n > cap - 1)
+      n = cap - 1;
+  }
+  out[n++] = '\n';
+  return n;
+}
+
+// tokenized frame: sync, length, format address, timestamp, level, arg
+// count, type tags, raw args, optional string, additive checksum
+static size_t encodeFrame(const DebugLogEntry &e, uint8_t *out) {
+  size_t n = 3;
+  auto put32 = [&](uint32_t v) {
+    memcpy(out + n, &v, sizeof(v));
+    n += sizeof(v);
+  };
+  put32((uint32_t)(uintptr_t)e.fmt);
+  put32(e.timestamp_us);
+  out[n++] = e.level;
+  out[n++] = e.nargs;
+  out[n++] = e.types;
+  for (int i = 0; i < e.nargs; i++)
+    put32(e.args[i]);
+  if (e.str[0] != '\0') {
+    size_t len = strnlen(e.str, DLOG_STRING_BYTES - 1);
+    memcpy(out + n, e.str, len);
+    n += len;
+    out[n++] = '\0';
+  }
+  out[0] = FRAME_SYNC0;
+  out[1] = FRAME_SYNC1;
+  out[2] = (uint8_t)(n - 3);
+  uint8_t sum = 0;
+  for (size_t i = 3; i < n; i++)
+    sum += out[i];
+  out[n++] = sum;
+  return n;
+}
+
+static void drainTask(void *) {
+  DebugLogEntry e;
+  char line[160];
+  uint32_t reportedDrops = 0;
+  for (;;) {
+    while (popEntry(e)) {
+      if (binaryMode) {
+        size_t n = encodeFrame(e, (uint8_t *)line);
+        Serial.write((const uint8_t *)line, n);
+      } else {
+        size_t n = formatEntry(e, line, sizeof(line));
+        Serial.write((const uint8_t *)line, n);
+      }
+    }
+    uint32_t drops = dropped.load(std::memory_order_relaxed);
+    if (drops != reportedDrops && !binaryMode) {
+      Serial.printf("[log] %lu entries dropped\n",
+                    (unsigned long)(drops - reportedDrops));
+      reportedDrops = drops;
+    }
+    vTaskDelay(DRAIN_PERIOD_TICKS);
+  }
+}
+
+void debugLogInit(bool binary) {
+  if (started)
+    return;
+  binaryMode = binary;
+  started = true;
+  TaskHandle_t task = nullptr;
+  xTaskCreatePinnedToCore(drainTask, "dlog", DRAIN_STACK_BYTES, nullptr,
+                          DRAIN_PRIORITY, &task, 0);
+  memoryWatchTask(task);
+}
+
+void debugLogSetLevel(uint8_t level) {
+  debugLogRuntimeLevel = level > DLOG_LEVEL ? DLOG_LEVEL : level;
+}
+
+uint8_t debugLogLevel() { return debugLogRuntimeLevel; }
+
+void debugLogSetBinary(bool binary) { binaryMode = binary; }
+
+uint32_t debugLogDropped() {
+  return dropped.load(std::memory_order_relaxed);
+}
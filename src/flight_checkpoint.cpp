@@ -0,0 +1,92 @@
+#include "../include/flight_checkpoint.h"
+#include "../include/debug_log.h"
+#include "../include/flight_state.h"
+#include "../include/log_codec.h"
+#include <Arduino.h>
+#include <cstddef>
+#include <cstring>
+#include <esp_system.h>
+
+static const uint32_t CHECKPOINT_MAGIC = 0x50434C46; // "FLCP"
+static const uint16_t CHECKPOINT_VERSION = 2;
+
+struct CheckpointSlot {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t size;
+  uint32_t saves; // newer slot wins
+  FlightCheckpoint data;
+  uint32_t crc;
+};
+
+// RTC_NOINIT keeps the startup code from zeroing these on reset
+RTC_NOINIT_ATTR static CheckpointSlot slots[2];
+
+static bool checked = false;
+static bool inFlight = false;
+static FlightCheckpoint saved;
+static uint32_t saveCount = 0;
+
+static uint32_t slotCrc(const CheckpointSlot &s) {
+  return logcodec::crc32((const uint8_t *)&s, offsetof(CheckpointSlot, crc));
+}
+
+static bool slotValid(const CheckpointSlot &s) {
+  return s.magic == CHECKPOINT_MAGIC && s.version == CHECKPOINT_VERSION &&
+         s.size == sizeof(CheckpointSlot) && s.crc == slotCrc(s);
+}
+
+// read the slots once, before the first save overwrites them
+static void check() {
+  if (checked)
+    return;
+  checked = true;
+
+  esp_reset_reason_t reason = esp_reset_reason();
+  if (reason == ESP_RST_POWERON || reason == ESP_RST_DEEPSLEEP)
+    return; // RTC memory is not meaningful
+  const CheckpointSlot *best = nullptr;
+  for (int i = 0; i < 2; i++)
+    if (slotValid(slots[i]) && (!best || slots[i].saves > best->saves))
+      best = &slots[i];
+  if (!best || best->data.state == PRELAUNCH)
+    return; // pad resets start over with full self-tests
+
+  saved = best->data;
+  saveCount = best->saves;
+  inFlight = true;
+  DLOG_WARN("Reset in flight (reason %d), resuming state %u", (int)reason,
+            saved.state);
+}
+
+bool checkpointInFlight() {
+  check();
+  return inFlight;
+}
+
+bool checkpointLoad(FlightCheckpoint &cp) {
+  check();
+  if (!inFlight)
+    return false;
+  cp = saved;
+  return true;
+}
+
+void checkpointSave(const FlightCheckpoint &cp) {
+  check();
+  // build the whole slot first, padding included, so the crc is stable
+  CheckpointSlot s;
+  memset(&s, 0, sizeof(s));
+  s.magic = CHECKPOINT_MAGIC;
+  s.version = CHECKPOINT_VERSION;
+  s.size = sizeof(CheckpointSlot);
+  s.saves = ++saveCount;
+  s.data = cp;
+  s.crc = slotCrc(s);
+  memcpy(&slots[s.saves & 1], &s, sizeof(s));
+}
+
+void checkpointClear() {
+  memset(slots, 0, sizeof(slots));
+  inFlight = false;
+}
@@ -0,0 +1,258 @@
+#include "../include/flight_logger.h"
+#include "../include/debug_log.h"
+#include "../include/log_codec.h"
+#include "../include/psram_capture.h"
+#include "../include/raw_log_region.h"
+#include <Arduino.h>
+#include <freertos/queue.h>
+
+static const int LOGGER_QUEUE_DEPTH = 64; // samples
+static const int VIBRATION_QUEUE_DEPTH = 8; // summaries
+static const int MEMORY_QUEUE_DEPTH = 4;    // snapshots
+static const uint32_t LOGGER_STACK_BYTES = 4096;
+static const UBaseType_t LOGGER_PRIORITY = 1; // below the arduino loop
+static const TickType_t LOGGER_IDLE_FLUSH_TICKS =
+    pdMS_TO_TICKS(2000); // seal a partial block when no sample arrives
+
+static SDCard_Driver *sdcard_ptr = nullptr;
+static String logFileName;
+static QueueHandle_t sampleQueue = nullptr;
+static logcodec::BlockEncoder encoder;
+static RawLogRegion rawRegion;
+static volatile bool flushRequested = false;
+static bool wantRawRegion = false;
+static bool mountPending = false; // the task mounts the card (a resume)
+static volatile uint32_t droppedSamples = 0;
+static volatile uint32_t droppedVibration = 0;
+static volatile uint32_t droppedMemory = 0;
+static volatile uint32_t writeLostSamples = 0; // in blocks the card refused
+static volatile bool rawFailed = false; // the file took over from the region
+static volatile uint32_t blocksWritten = 0;
+
+// vibration summaries, batched into whole records (always on FAT)
+static const char *VIBRATION_FILE_NAME = "/vibration.bin";
+static QueueHandle_t vibrationQueue = nullptr;
+static uint8_t vibrationBatch[logcodec::BLOCK_BYTES];
+static size_t vibrationFill = 0;
+
+// memory snapshots, one text append each (they come every few seconds at
+// most)
+static const char *MEMORY_FILE_NAME = "/memory.csv";
+static QueueHandle_t memoryQueue = nullptr;
+static char memoryText[1024];
+
+// full-rate capture drained from PSRAM (psram_capture.h), between samples
+static const char *CAPTURE_FILE_NAME = "/capture.bin";
+
+// block readback for ground-requested resends, done on the logger task so
+// the card is only ever touched from one place
+enum ReadbackState { READBACK_IDLE, READBACK_REQUESTED, READBACK_DONE };
+static volatile ReadbackState readbackState = READBACK_IDLE;
+static uint32_t readbackIndex = 0;
+static bool readbackOk = false;
+static uint8_t readbackBlock[logcodec::BLOCK_BYTES];
+
+MEMORY_TAG("logger", encoder);
+MEMORY_TAG("logger", rawRegion);
+MEMORY_TAG("logger", vibrationBatch);
+MEMORY_TAG("logger", memoryText);
+MEMORY_TAG("logger", readbackBlock);
+
+static bool rawActive() { return rawRegion.isOpen() && !rawFailed; }
+
+// the raw region gives way to the file on its first failed write
+static void writeBlock(const uint8_t *block) {
+  if (!block)
+    return;
+  if (rawActive()) {
+    if (rawRegion.append(block)) {
+      blocksWritten = blocksWritten + 1;
+      return;
+    }
+    rawFailed = true;
+    DLOG_WARN("Raw log write failed at block %lu, logging to file",
+              blocksWritten);
+  }
+  if (sdcard_ptr->appendBytes(logFileName, block, logcodec::BLOCK_BYTES))
+    blocksWritten = blocksWritten + 1;
+  else
+    writeLostSamples = writeLostSamples + block[3]; // header sample count
+}
+
+static void serviceReadback() {
+  if (readbackState != READBACK_REQUESTED)
+    return;
+  readbackOk = rawRegion.isOpen()
+                   ? rawRegion.readBlock(readbackIndex, readbackBlock)
+                   : sdcard_ptr->readBytes(
+                         logFileName, readbackIndex * logcodec::BLOCK_BYTES,
+                         readbackBlock, logcodec::BLOCK_BYTES);
+  readbackState = READBACK_DONE;
+}
+
+static void serviceVibration(bool flush) {
+  vibration::Summary v;
+  while (xQueueReceive(vibrationQueue, &v, 0) == pdTRUE) {
+    vibration::encodeRecord(v, vibrationBatch + vibrationFill);
+    vibrationFill += vibration::RECORD_BYTES;
+    if (vibrationFill + vibration::RECORD_BYTES > sizeof(vibrationBatch)) {
+      sdcard_ptr->appendBytes(VIBRATION_FILE_NAME, vibrationBatch,
+                              vibrationFill);
+      vibrationFill = 0;
+    }
+  }
+  if (flush && vibrationFill) {
+    sdcard_ptr->appendBytes(VIBRATION_FILE_NAME, vibrationBatch,
+                            vibrationFill);
+    vibrationFill = 0;
+  }
+}
+
+static void serviceMemory() {
+  MemorySnapshot m;
+  while (xQueueReceive(memoryQueue, &m, 0) == pdTRUE) {
+    size_t len = memoryFormatCsv(m, memoryText, sizeof(memoryText));
+    sdcard_ptr->appendBytes(MEMORY_FILE_NAME, (const uint8_t *)memoryText,
+                            len);
+  }
+}
+
+// one chunk; true if it was written, so there may be more
+static bool serviceCapture() {
+  const uint8_t *data;
+  size_t len = captureTakeChunk(data);
+  if (!len || !sdcard_ptr->appendBytes(CAPTURE_FILE_NAME, data, len))
+    return false;
+  captureRelease(len);
+  return true;
+}
+
+// the raw region (or the file fallback); on the logger task when the
+// card is mounted there
+static void openStorage() {
+  if (mountPending) {
+    mountPending = false;
+    if (!sdcard_ptr->begin())
+      DLOG_ERROR("SD card mount failed");
+  }
+  if (!wantRawRegion)
+    return;
+  if (rawRegion.open(*sdcard_ptr)) {
+    // continue the block sequence so the region reads as one stream
+    encoder.reset(rawRegion.nextSequence());
+    DLOG_INFO("Raw log region: %lu/%lu sectors used", rawRegion.usedSectors(),
+              rawRegion.capacitySectors());
+  } else {
+    DLOG_WARN("No raw log partition, logging to file");
+  }
+}
+
+static void loggerTask(void *) {
+  TelemetrySample s;
+  bool capturePending = false;
+  if (mountPending)
+    openStorage();
+  for (;;) {
+    // a capture backlog only waits a tick for the next sample
+    TickType_t wait = capturePending ? 1 : LOGGER_IDLE_FLUSH_TICKS;
+    if (xQueueReceive(sampleQueue, &s, wait) == pdTRUE) {
+      writeBlock(encoder.push(s));
+    } else if (!capturePending) {
+      flushRequested = true;
+    }
+    bool flush = flushRequested && uxQueueMessagesWaiting(sampleQueue) == 0;
+    serviceVibration(flush);
+    serviceMemory();
+    if (flush) {
+      flushRequested = false;
+      writeBlock(encoder.flush());
+      if (rawActive())
+        rawRegion.flush();
+    }
+    serviceReadback();
+    capturePending = PSRAM_CAPTURE &&
+                     uxQueueMessagesWaiting(sampleQueue) == 0 &&
+                     serviceCapture();
+  }
+}
+
+void flightLoggerInit(SDCard_Driver &sdcard, const char *fileName,
+                      bool useRawRegion, uint32_t resumeSequence,
+                      bool mountCard) {
+  if (sampleQueue)
+    return;
+  sdcard_ptr = &sdcard;
+  logFileName = fileName;
+  encoder.reset(resumeSequence);
+  wantRawRegion = useRawRegion;
+  mountPending = mountCard;
+  if (!mountCard)
+    openStorage();
+  sampleQueue = xQueueCreate(LOGGER_QUEUE_DEPTH, sizeof(TelemetrySample));
+  vibrationQueue =
+      xQueueCreate(VIBRATION_QUEUE_DEPTH, sizeof(vibration::Summary));
+  memoryQueue = xQueueCreate(MEMORY_QUEUE_DEPTH, sizeof(MemorySnapshot));
+  TaskHandle_t task = nullptr;
+  xTaskCreatePinnedToCore(loggerTask, "logger", LOGGER_STACK_BYTES, nullptr,
+                          LOGGER_PRIORITY, &task, 0);
+  memoryWatchTask(task);
+}
+
+bool flightLoggerPush(const TelemetrySample &s) {
+  if (!sampleQueue || xQueueSend(sampleQueue, &s, 0) != pdTRUE) {
+    droppedSamples = droppedSamples + 1;
+    return false;
+  }
+  return true;
+}
+
+bool flightLoggerPushVibration(const vibration::Summary &s) {
+  if (!vibrationQueue || xQueueSend(vibrationQueue, &s, 0) != pdTRUE) {
+    droppedVibration = droppedVibration + 1;
+    return false;
+  }
+  return true;
+}
+
+bool flightLoggerPushMemory(const MemorySnapshot &s) {
+  if (!memoryQueue || xQueueSend(memoryQueue, &s, 0) != pdTRUE) {
+    droppedMemory = droppedMemory + 1;
+    return false;
+  }
+  return true;
+}
+
+void flightLoggerFlush() { flushRequested = true; }
+
+uint32_t flightLoggerNextSequence() { return encoder.nextSequence(); }
+
+bool flightLoggerIsRaw() { return rawActive(); }
+
+bool flightLoggerRequestBlock(uint32_t index) {
+  if (!sampleQueue || readbackState != READBACK_IDLE)
+    return false;
+  readbackIndex = index;
+  readbackState = READBACK_REQUESTED;
+  return true;
+}
+
+bool flightLoggerTakeBlock(uint32_t &index, uint8_t *block, bool &ok) {
+  if (readbackState != READBACK_DONE)
+    return false;
+  index = readbackIndex;
+  ok = readbackOk;
+  if (ok)
+    memcpy(block, readbackBlock, logcodec::BLOCK_BYTES);
+  readbackState = READBACK_IDLE;
+  return true;
+}
+
+uint32_t flightLoggerDropped() { return droppedSamples; }
+
+uint32_t flightLoggerVibrationDropped() { return droppedVibration; }
+
+uint32_t flightLoggerMemoryDropped() { return droppedMemory; }
+
+uint32_t flightLoggerWriteLost() { return writeLostSamples; }
+
+uint32_t flightLoggerBlocksWritten() { return blocksWritten; }
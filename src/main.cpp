@@ -1,60 +1,104 @@
 #include "../include/state_machine.h"
-#include "../include/bmp280_driver.h"
-#include "../include/dht11_driver.h"
-#include "../include/buzzer_driver.h"
-#include "../include/mpu6050_driver.h"
-#include "../include/compass_driver.h"
-#include "../include/gps_driver.h"
-#include "../include/sdcard_driver.h"
-#include "../include/lora_driver.h"
+#include "../include/board_config.h"
+#include "../include/debug_log.h"
+#include "../include/flight_checkpoint.h"
+#include "../include/memory_monitor.h"
 #include "../include/test_functions.h"
+#include "../include/time_base.h"
+#ifdef MATH_BENCHMARK
+#include "../include/math_benchmark.h"
+#endif
+#ifdef FILTER_BENCHMARK
+#include "../include/filter_benchmark.h"
+#endif
+#ifdef LOG_CODEC_BENCHMARK
+#include "../include/log_codec_benchmark.h"
+#endif
+#ifdef SD_LATENCY_BENCHMARK
+#include "../include/sd_latency_benchmark.h"
+#endif
+#ifdef DEBUG_LOG_BENCHMARK
+#include "../include/debug_log_benchmark.h"
+#endif
+#ifdef VIBRATION_BENCHMARK
+#include "../include/vibration_benchmark.h"
+#endif
+#ifdef HOT_PATH_BENCHMARK
+#include "../include/hot_path_benchmark.h"
+#endif
+#ifdef PIPELINE_BENCHMARK
+#include "../include/pipeline_benchmark.h"
+#endif
 
-#define SD_CS      5
-#define LORA_CS    17
-#define LORA_RST   16
-#define LORA_DIO0  14
-#define BUZZER_PIN 27
-#define GPS_RX     13
-#define GPS_TX     15
-#define GPS_BAUD   115200
-#define I2C_SDA    21
-#define I2C_SCL    22
-
-
-BMP280_Driver bmp;
-DHT11_Driver dht;
-MPU6050_Driver mpu;
-Compass_Driver compass;
-GPS_Driver gps;
-Buzzer_Driver buzzer(BUZZER_PIN);
-SDCard_Driver sdcard(SD_CS);
-LoRaDriver lora(LORA_CS, LORA_RST, LORA_DIO0, 433E6);
+// drivers and pins come from the board config (board_config.h)
+Payload payload;
+MEMORY_TAG("drivers", payload);
+
+// the slow starts an in-flight resume put off until after the first pass
+static bool resumeSlowPending = false;
 
 void setup() {
   Serial.begin(115200);
-  Wire.begin(I2C_SDA, I2C_SCL);
-
-  pinMode(SD_CS, OUTPUT);
-  pinMode(LORA_CS, OUTPUT);
-  digitalWrite(SD_CS, HIGH);
-  digitalWrite(LORA_CS, HIGH);
-
-  // initialize all sensors
-  if (!bmp.begin()) Serial.println("BMP280 init failed");
-  dht.begin();
-  mpu.begin();
-  compass.begin();
-  gps.begin(GPS_RX, GPS_TX, GPS_BAUD);
-  sdcard.begin();
-  lora.begin();
-
-  // test everything
-  testAllSensors(bmp, dht, mpu, compass, gps, buzzer, sdcard, lora);
-
-  // stateMachineInit(bmp, dht, mpu, compass, gps, buzzer, sdcard, lora);
+  debugLogInit();
+  memoryWatchTask(xTaskGetCurrentTaskHandle()); // setup() and loop()
+  Wire.begin(Board::I2C_SDA, Board::I2C_SCL);
+  Wire.setClock(400000); // room for the IMU FIFO drain next to the sensors
+
+  pinMode(Board::SD_CS, OUTPUT);
+  pinMode(Board::LORA_CS, OUTPUT);
+  digitalWrite(Board::SD_CS, HIGH);
+  digitalWrite(Board::LORA_CS, HIGH);
+
+  // A reset in flight skips benchmarks and self-tests and goes straight
+  // back to logging from the RTC checkpoint: no chip resets, the logger
+  // task mounts the card, and the baro and radio start from loop() once
+  // samples flow again.
+  resumeSlowPending = checkpointInFlight();
+  if (resumeSlowPending) {
+    payload.sensors.resume();
+  } else {
+    payload.sensors.begin();
+    payload.sdcard.begin();
+    payload.lora.begin();
+
+#ifdef MATH_BENCHMARK
+    runMathBenchmark();
+#endif
+#ifdef FILTER_BENCHMARK
+    runFilterBenchmark();
+#endif
+#ifdef LOG_CODEC_BENCHMARK
+    runLogCodecBenchmark();
+#endif
+#ifdef SD_LATENCY_BENCHMARK
+    runSdLatencyBenchmark(payload.sdcard);
+#endif
+#ifdef DEBUG_LOG_BENCHMARK
+    runDebugLogBenchmark();
+#endif
+#ifdef VIBRATION_BENCHMARK
+    runVibrationBenchmark();
+#endif
+#ifdef HOT_PATH_BENCHMARK
+    runHotPathBenchmark();
+#endif
+#ifdef PIPELINE_BENCHMARK
+    runPipelineBenchmark();
+#endif
+
+    // test everything
+    testAllSensors(payload);
+  }
+
+  stateMachineInit();
 }
 
 void loop() {
-  // stateMachineUpdate();
-  delay(100);
+  stateMachineUpdate();
+  if (resumeSlowPending) {
+    resumeSlowPending = false;
+    payload.sensors.resumeSlow();
+    payload.lora.begin();
+  }
+  delay(stateMachineSamplePeriodMs());
 }
@@ -0,0 +1,119 @@
+#include "../include/memory_monitor.h"
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+// the heap everything but PSRAM buffers comes from
+static const uint32_t HEAP_CAPS = MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT;
+
+// plain zero-initialised arrays, so MEMORY_TAG constructors in other
+// translation units can run first
+struct TagEntry {
+  const char *module;
+  const char *object;
+  size_t bytes;
+};
+static TagEntry tags[MEMORY_MAX_TAGS];
+static int tagCount;
+static size_t untaggedBytes; // registry full
+
+static TaskHandle_t tasks[MEMORY_MAX_TASKS];
+static int taskCount;
+static portMUX_TYPE taskMux = portMUX_INITIALIZER_UNLOCKED;
+
+void memoryTag(const char *module, const char *object, size_t bytes) {
+  if (tagCount == MEMORY_MAX_TAGS) {
+    untaggedBytes += bytes;
+    return;
+  }
+  tags[tagCount].module = module;
+  tags[tagCount].object = object;
+  tags[tagCount].bytes = bytes;
+  tagCount++;
+}
+
+void memoryWatchTask(TaskHandle_t task) {
+  if (!task)
+    return; // creation failed
+  portENTER_CRITICAL(&taskMux);
+  if (taskCount < MEMORY_MAX_TASKS)
+    tasks[taskCount++] = task;
+  portEXIT_CRITICAL(&taskMux);
+}
+
+void memoryTakeSnapshot(MemorySnapshot &s, uint8_t reason, uint8_t state) {
+  s.t_ms = millis();
+  s.reason = reason;
+  s.state = state;
+  s.heapFree = heap_caps_get_free_size(HEAP_CAPS);
+  s.heapMinFree = heap_caps_get_minimum_free_size(HEAP_CAPS);
+  s.heapLargest = heap_caps_get_largest_free_block(HEAP_CAPS);
+  // share of the free heap a single allocation can't reach
+  s.fragmentationPct =
+      s.heapFree ? (uint8_t)(100 - (uint64_t)s.heapLargest * 100 / s.heapFree)
+                 : 0;
+
+  portENTER_CRITICAL(&taskMux);
+  int n = taskCount;
+  portEXIT_CRITICAL(&taskMux);
+  s.taskCount = (uint8_t)n;
+  for (int i = 0; i < n; i++) {
+    // ESP-IDF counts stack in bytes
+    strncpy(s.tasks[i].name, pcTaskGetName(tasks[i]),
+            sizeof(s.tasks[i].name) - 1);
+    s.tasks[i].name[sizeof(s.tasks[i].name) - 1] = '\0';
+    s.tasks[i].stackFree = uxTaskGetStackHighWaterMark(tasks[i]);
+  }
+}
+
+size_t memoryTaggedBytes() {
+  size_t total = untaggedBytes;
+  for (int i = 0; i < tagCount; i++)
+    total += tags[i].bytes;
+  return total;
+}
+
+static const char *const REASON_NAMES[] = {"boot", "periodic", "transition"};
+
+// snprintf that keeps the running length inside the buffer
+static void append(char *out, size_t len, size_t &n, const char *fmt, ...)
+    __attribute__((format(printf, 4, 5)));
+
+static void append(char *out, size_t len, size_t &n, const char *fmt, ...) {
+  if (n + 1 >= len)
+    return;
+  va_list args;
+  va_start(args, fmt);
+  int w = vsnprintf(out + n, len - n, fmt, args);
+  va_end(args);
+  if (w > 0)
+    n = n + (size_t)w < len ? n + (size_t)w : len - 1;
+}
+
+// rows: "tag,<module>,<object>,<bytes>" once per boot, then
+// "mem,<t_ms>,<reason>,<state>,<free>,<min free>,<largest>,<frag %>" and
+// one "stack,<t_ms>,<task>,<bytes free>" per watched task
+size_t memoryFormatCsv(const MemorySnapshot &s, char *out, size_t len) {
+  size_t n = 0;
+  if (!len)
+    return 0;
+  out[0] = '\0';
+  if (s.reason == MEMORY_BOOT) {
+    for (int i = 0; i < tagCount; i++)
+      append(out, len, n, "tag,%s,%s,%u\n", tags[i].module, tags[i].object,
+             (unsigned)tags[i].bytes);
+    if (untaggedBytes)
+      append(out, len, n, "tag,other,untagged,%u\n", (unsigned)untaggedBytes);
+  }
+  append(out, len, n, "mem,%lu,%s,%u,%lu,%lu,%lu,%u\n", (unsigned long)s.t_ms,
+         s.reason <= MEMORY_TRANSITION ? REASON_NAMES[s.reason] : "?",
+         (unsigned)s.state, (unsigned long)s.heapFree,
+         (unsigned long)s.heapMinFree, (unsigned long)s.heapLargest,
+         (unsigned)s.fragmentationPct);
+  for (int i = 0; i < s.taskCount; i++)
+    append(out, len, n, "stack,%lu,%s,%lu\n", (unsigned long)s.t_ms,
+           s.tasks[i].name, (unsigned long)s.tasks[i].stackFree);
+  return n;
+}
@@ -0,0 +1,136 @@
+#include "../include/psram_capture.h"
+#include "../include/debug_log.h"
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+
+// one SD append per chunk; FAT appends reopen the file, so bigger is
+// cheaper per record
+static const size_t CHUNK_RECORDS = 170; // 4080 bytes
+
+static capture::Arena arena;
+static uint8_t *staging = nullptr; // internal RAM, SD writes don't DMA PSRAM
+static portMUX_TYPE arenaMux = portMUX_INITIALIZER_UNLOCKED;
+static volatile bool recording = false;
+static uint32_t imuIndex = 0; // vibration task only
+static volatile uint32_t records = 0;
+static volatile uint32_t dropped = 0;
+static volatile uint8_t maxStep = 1;
+
+bool captureInit() {
+  if (arena.attached())
+    return true;
+  uint8_t *mem = (uint8_t *)heap_caps_malloc(
+      CAPTURE_ARENA_BYTES, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+  staging = (uint8_t *)heap_caps_malloc(
+      CHUNK_RECORDS * capture::RECORD_BYTES,
+      MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+  if (!mem || !staging) {
+    heap_caps_free(mem);
+    heap_caps_free(staging);
+    staging = nullptr;
+    DLOG_WARN("No PSRAM for the capture buffer");
+    return false;
+  }
+  arena.attach(mem, CAPTURE_ARENA_BYTES);
+  DLOG_INFO("Capture buffer: %lu records in PSRAM",
+            (unsigned long)arena.capacityRecords());
+  return true;
+}
+
+void captureStart() {
+  if (!arena.attached() || recording)
+    return;
+  recording = true;
+  DLOG_INFO("Capture started");
+}
+
+void captureStop() {
+  if (!recording)
+    return;
+  recording = false;
+  DLOG_INFO("Capture stopped: %lu records, IMU step up to %u, %lu dropped, "
+            "%lu bytes left to write",
+            (unsigned long)records, (unsigned)maxStep, (unsigned long)dropped,
+            (unsigned long)capturePendingBytes());
+}
+
+bool captureRecording() { return recording; }
+
+static void push(const uint8_t *record) {
+  portENTER_CRITICAL(&arenaMux); // IMU and baro come from both cores
+  if (arena.push(record))
+    records = records + 1;
+  else
+    dropped = dropped + 1;
+  portEXIT_CRITICAL(&arenaMux);
+}
+
+void captureImu(const float accel[3], const float gyro[3], uint64_t t_us,
+                bool utc) {
+  if (!recording)
+    return;
+  uint8_t step = arena.step(); // a stale count only shifts the threshold
+  if (step > maxStep)
+    maxStep = step;
+  if (imuIndex++ % step)
+    return;
+  capture::Record r;
+  r.kind = capture::KIND_IMU;
+  r.utc = utc;
+  r.step = step;
+  r.t_us = t_us;
+  for (int k = 0; k < 3; k++) {
+    r.v[k] = accel[k];
+    r.v[3 + k] = gyro[k];
+  }
+  uint8_t record[capture::RECORD_BYTES];
+  capture::encodeRecord(r, record);
+  push(record);
+}
+
+void captureBaro(float pressure_hPa, float temp_C, uint64_t t_us, bool utc) {
+  if (!recording)
+    return;
+  capture::Record r = {};
+  r.kind = capture::KIND_BARO;
+  r.utc = utc;
+  r.step = 1;
+  r.t_us = t_us;
+  r.v[0] = pressure_hPa;
+  r.v[1] = temp_C;
+  uint8_t record[capture::RECORD_BYTES];
+  capture::encodeRecord(r, record);
+  push(record);
+}
+
+size_t captureTakeChunk(const uint8_t *&data) {
+  if (!staging)
+    return 0;
+  portENTER_CRITICAL(&arenaMux);
+  size_t n = arena.pending();
+  portEXIT_CRITICAL(&arenaMux);
+  if (n > CHUNK_RECORDS)
+    n = CHUNK_RECORDS;
+  arena.copy(staging, n); // producers only write past these
+  data = staging;
+  return n * capture::RECORD_BYTES;
+}
+
+void captureRelease(size_t bytes) {
+  portENTER_CRITICAL(&arenaMux);
+  arena.release(bytes / capture::RECORD_BYTES);
+  portEXIT_CRITICAL(&arenaMux);
+}
+
+uint32_t captureRecords() { return records; }
+
+uint32_t captureDropped() { return dropped; }
+
+uint8_t captureMaxStep() { return maxStep; }
+
+size_t capturePendingBytes() {
+  portENTER_CRITICAL(&arenaMux);
+  size_t n = arena.pending();
+  portEXIT_CRITICAL(&arenaMux);
+  return n * capture::RECORD_BYTES;
+}
@@ -1,316 +1,643 @@
 #include "../include/state_machine.h"
+#include "../include/calibration_store.h"
+#include "../include/command_dispatcher.h"
+#include "../include/debug_log.h"
+#include "../include/downlink_scheduler.h"
+#include "../include/fast_math.h"
+#include "../include/filter_stage.h"
+#include "../include/flight_checkpoint.h"
+#include "../include/flight_events.h"
+#include "../include/flight_logger.h"
+#include "../include/memory_monitor.h"
+#include "../include/psram_capture.h"
+#include "../include/recovery_beacon.h"
+#include "../include/tdma_schedule.h"
+#include "../include/telemetry_sample.h"
+#include "../include/time_base.h"
+#include "../include/tone_pattern.h"
+#include "../include/uplink_counter_store.h"
+#include "../include/uplink_window.h"
+#include "../include/vibration_monitor.h"
 #include <Arduino.h>
+#include <esp_system.h>
+#include <esp_timer.h>
 #include <math.h>
 
-static BMP280_Driver *bmp_ptr = nullptr;
-static DHT11_Driver *dht_ptr = nullptr;
-static MPU6050_Driver *mpu_ptr = nullptr;
-static Compass_Driver *compass_ptr = nullptr;
-static GPS_Driver *gps_ptr = nullptr;
-static Buzzer_Driver *buzzer_ptr = nullptr;
-static SDCard_Driver *sdcard_ptr = nullptr;
-static LoRaDriver *lora_ptr = nullptr;
+// the board's drivers, resolved at link time
+static SensorPipeline<Board> &sensors = payload.sensors;
+static Buzzer_Driver &buzzer = payload.buzzer;
+static Board::Radio &lora = payload.lora;
 
 // current state
 static FlightState currentState = PRELAUNCH;
 
-// variables to track state transitions
+// transitions are voted by the event engine against the ground reference
+static FlightEventEngine flightEvents;
 static float initialAltitude = NAN;
-static float lastAltitude = NAN;
-static unsigned long landedStableTime = 0;
-static const unsigned long LANDING_STABLE_DURATION_MS =
-    3000; // 3 seconds for landing confirmation
 
-// thresholds
-static const float ASCENT_ACCELERATION_THRESHOLD = 0.5f; // g(gravity)
-static const float ALTITUDE_CHANGE_THRESHOLD =
-    2.0f; // meters, for "no altitude change" detection
+// log straight to the raw SD partition instead of a FAT file
+#ifndef SD_RAW_LOG
+#define SD_RAW_LOG false
+#endif
 
 // sensor calibration bool
 static bool sensorsCalibrated = false;
+static bool powerDownComplete = false;
+
+// ground reference; launch detection waits for it except on acceleration
+static SensorCalibrator calibrator;
+static CalibrationStore calibrationStore;
+static CalibrationData calibration;
+static bool calibrationReady = false;
+static bool calibrationAgeChecked = false;
+
+// set after a reset in flight until the first sample is logged again
+static bool resumed = false;
+static uint8_t inFlightResets = 0;
+
+// latest raw acquisition and the filtered streams derived from it
+static TelemetrySample sample;
+static TelemetryFilterStage filterStage;
+
+// IMU vibration spectra from the FIFO; summaries are always logged and
+// optionally sent down
+#ifndef VIBRATION_ANALYSIS
+#define VIBRATION_ANALYSIS true
+#endif
+#ifndef VIBRATION_DOWNLINK
+#define VIBRATION_DOWNLINK true
+#endif
+
+// telemetry downlink; 64-byte frames are ~120 ms on air at SF7/125 kHz
+static const size_t DOWNLINK_MAX_FRAME = 64;
+static const float DOWNLINK_DUTY_CYCLE = 0.25f;
+static DownlinkScheduler downlink(DOWNLINK_MAX_FRAME, DOWNLINK_DUTY_CYCLE);
+
+// command uplink; the ground transmits inside the window after each frame.
+// The key comes from the build (-DUPLINK_KEY="{0x.., ...}", 16 bytes, kept
+// out of the repo); without one the uplink stays off, since a key in the
+// source would let anyone sign commands.
+#ifdef UPLINK_KEY
+#define UPLINK_ENABLED true
+static const uint8_t uplinkKey[uplink::KEY_BYTES] = UPLINK_KEY;
+#else
+#define UPLINK_ENABLED false
+static const uint8_t uplinkKey[uplink::KEY_BYTES] = {0};
+#endif
+static const uint32_t UPLINK_WINDOW_MS = 250;
+static CommandDispatcher dispatcher(uplinkKey);
+static UplinkWindow<Board::Radio> *uplinkWindow = nullptr;
+static UplinkCounterStore uplinkCounterStore;
+static uint32_t savedUplinkCounter = 0;
+
+// several payloads on one frequency: TDMA_SLOTS > 0 gives this one slot
+// TDMA_NODE_ID of a GPS-aligned superframe (tdma_schedule.h); the uplink
+// window then shrinks to fit the slot
+#ifndef TDMA_SLOTS
+#define TDMA_SLOTS 0
+#endif
+#ifndef TDMA_NODE_ID
+#define TDMA_NODE_ID 0
+#endif
+static TdmaSchedule tdma(TDMA_NODE_ID, TDMA_SLOTS);
+
+static const uint32_t MIN_SAMPLE_PERIOD_MS = 20;
+static const uint32_t MAX_SAMPLE_PERIOD_MS = 1000;
+static uint32_t samplePeriodMs = 100;
+
+// lora profile change waits until its ack has gone out on the old one
+static bool profilePending = false;
+static uint8_t pendingSf, pendingCodingRate4;
+static long pendingBandwidth;
+
+// ground-requested log blocks still to resend
+static uint32_t resendNextBlock = 0;
+static uint32_t resendRemaining = 0;
+
+// after landing the radio and the buzzer take turns
+static RecoveryBeacon beacon;
+static tones::TonePattern beaconPattern;
+static bool radioAsleep = false;
+static bool haveFix = false;
+static int32_t lastFixLat = 0, lastFixLon = 0;
+
+// RAM budget snapshots to /memory.csv
+static uint32_t lastMemoryMs = 0;
+
+MEMORY_TAG("state", flightEvents);
+MEMORY_TAG("state", calibrator);
+MEMORY_TAG("state", filterStage);
+MEMORY_TAG("state", downlink);
+MEMORY_TAG("state", dispatcher);
+MEMORY_TAG("state", beaconPattern);
+
+// status codes, counted in beeps
+static const int STATUS_CALIBRATED = 2;
+static const int STATUS_RESUMED = 3;
+
+static void playStatus(int code) {
+  beaconPattern.clear();
+  tones::statusCode(beaconPattern, code);
+  buzzer.play(beaconPattern);
+}
 
-// helper to read altitude from BMP280
-static float getAltitude() {
-  if (bmp_ptr)
-    return bmp_ptr->calculateAltitude(1013.25f);
-  return NAN;
+// slot lengths follow the LoRa profile's time on air
+static void configureTdma() {
+  if (!TDMA_SLOTS)
+    return;
+  tdma.configure(lora.airtimeUs(DOWNLINK_MAX_FRAME),
+                 lora.airtimeUs(uplink::MAX_COMMAND_BYTES));
+  if (uplinkWindow)
+    uplinkWindow->setWindowMs((tdma.rxWindowUs() + 999) / 1000);
 }
 
-// helper to read acceleration magnitude from MPU6050
-static float getAccelGyro() {
-  if (mpu_ptr) {
-    float ax, ay, az, gx, gy, gz;
-    mpu_ptr->readAccelGyro(ax, ay, az, gx, gy, gz);
-    return sqrtf(ax * ax + ay * ay + az * az);
-  }
-  return 0.0f;
+static uint64_t tdmaNowUs() {
+  return tdma.networkUs(esp_timer_get_time(), timeBaseIsDisciplined(),
+                        timeBaseNowUs());
 }
 
-// helper to check increase in altitude and acceleration in PRELAUNCH
-static bool detectLaunch() {
-  float alt = getAltitude();
-  if (isnan(initialAltitude)) {
-    initialAltitude = alt;
-    return false;
-  }
-  float accelMag = getAccelGyro();
-  // launch if altitude increase by more than 10m or acceleration significantly
-  // above 1g
-  if ((alt - initialAltitude) > 10.0f ||
-      (accelMag - 1.0f) > ASCENT_ACCELERATION_THRESHOLD) {
-    Serial.println("Launch detected");
-    return true;
-  }
-  return false;
+static bool tdmaSynced() {
+  return tdma.isSynced(esp_timer_get_time(), timeBaseIsDisciplined());
 }
 
-// helper to detect descent (altitude starting to dcrease)
-static bool detectDescent() {
-  float alt = getAltitude();
-  if (!isnan(lastAltitude) && alt < lastAltitude - 1.0f) { // altitude drop > 1m
-    Serial.println("Descent detected");
-    return true;
+static void applyCalibration(const CalibrationData &c) {
+  calibration = c;
+  sensors.applyCalibration(c);
+  filterStage.resetDetection();
+  calibrationReady = true;
+}
+
+static void startCalibration() {
+  calibrationReady = false;
+  calibrationAgeChecked = false;
+  sensors.clearCalibration(); // average raw readings
+  calibrator.start();
+  DLOG_INFO("Ground calibration started");
+}
+
+static void updateCalibration() {
+  if (calibrationReady) {
+    // a stored calibration without a usable age is rechecked once GPS
+    // time is known
+    if (!calibrationAgeChecked && timeBaseIsDisciplined()) {
+      calibrationAgeChecked = true;
+      uint32_t now = (uint32_t)(timeBaseNowUs() / 1000000ULL);
+      if (!CalibrationStore::isFresh(calibration, now)) {
+        DLOG_WARN("Stored calibration is stale");
+        startCalibration();
+      }
+    }
+    return;
   }
-  return false;
+  float gpsAltitude = NAN;
+  bool gpsGood = sensors.gpsAltitude(gpsAltitude);
+  if (!calibrator.push(sample, gpsGood, gpsAltitude))
+    return;
+
+  CalibrationData c = calibrator.result();
+  c.utcSeconds = timeBaseIsDisciplined()
+                     ? (uint32_t)(timeBaseNowUs() / 1000000ULL)
+                     : 0;
+  applyCalibration(c);
+  calibrationAgeChecked = c.utcSeconds != 0;
+  initialAltitude = c.groundAltitude;
+  flightEvents.setGround(initialAltitude);
+  calibrationStore.save(c);
+  playStatus(STATUS_CALIBRATED);
+  DLOG_INFO("Ground calibration done: %.2f hPa, ground %.1f m (%s)",
+            c.seaLevelHpa, c.groundAltitude, c.gpsAnchored ? "GPS" : "AGL");
 }
 
-// helper to detect stable altitude (landing)
-static bool detectLanding() {
-  float alt = getAltitude();
-  if (isnan(lastAltitude)) {
-    lastAltitude = alt;
-    return false;
+// read every fitted sensor (sensor_pipeline.h)
+static void acquireSample(TelemetrySample &s) {
+  sensors.acquire(s, millis());
+  s.utc = timeBaseIsDisciplined();
+  if (sensors.hasFix()) {
+    haveFix = true;
+    lastFixLat = s.lat_e7;
+    lastFixLon = s.lon_e7;
   }
-  float diff = fabsf(alt - lastAltitude);
-  lastAltitude = alt;
-
-  if (diff < ALTITUDE_CHANGE_THRESHOLD) {
-    unsigned long now = millis();
-    if (landedStableTime == 0) {
-      landedStableTime = now;
-    } else if (now - landedStableTime >= LANDING_STABLE_DURATION_MS) {
-      Serial.println("Landing detected");
-      return true;
-    }
-  } else {
-    landedStableTime = 0;
+}
+
+// log every raw sample to sd card (compressed, on the logger task)
+static void logData() {
+  flightLoggerPush(sample);
+  if (resumed) {
+    DLOG_INFO("Logging again %lu ms after reset", (unsigned long)millis());
+    resumed = false;
   }
-  return false;
 }
 
-static void transmitAndLogData() {
-  static unsigned long lastLoRaSend = 0;
-  unsigned long now = millis();
+static void logMemory(uint8_t reason) {
+  MemorySnapshot m;
+  memoryTakeSnapshot(m, reason, (uint8_t)currentState);
+  flightLoggerPushMemory(m);
+  lastMemoryMs = m.t_ms;
+}
 
-  if (!bmp_ptr || !dht_ptr || !mpu_ptr || !compass_ptr || !gps_ptr)
+// heavy sensors off after landing; GPS and SD stay up for recovery
+static void powerDownSensors() {
+  if (powerDownComplete)
     return;
+  DLOG_INFO("Powering down sensors...");
+  sensors.powerDown();
+  powerDownComplete = true;
+}
 
-  // collect data
-  // bmp
-  float temp_bmp = bmp_ptr->readTemperature_C();
-  float pres = bmp_ptr->returnPressure_hPa();
-  float alt = getAltitude();
-
-  // dht
-  float temp_dht = dht_ptr->readTemperature();
-  float hum = dht_ptr->readHumidity();
-
-  // mpu
-  float ax, ay, az, gx, gy, gz;
-  mpu_ptr->readAccelGyro(ax, ay, az, gx, gy, gz);
-
-  // compass
-  float heading = compass_ptr->readHeading();
-
-  // gps
-  gps_ptr->read();
-  float lat = gps_ptr->latitude();
-  float lon = gps_ptr->longitude();
-
-  // format into csv string
-  String packet =
-      String(millis()) + "," + String(temp_bmp, 2) + "," + String(pres, 2) +
-      "," + String(alt, 2) + "," + String(temp_dht, 2) + "," + String(hum, 2) +
-      "," + String(ax, 2) + "," + String(ay, 2) + "," + String(az, 2) + "," +
-      String(heading, 2) + "," + String(lat, 6) + "," + String(lon, 6);
-
-  // send data over lora
-  if (now - lastLoRaSend >= 1000) { // 1 second rate limit
-    if (lora_ptr && lora_ptr->isInitialized()) {
-      lora_ptr->sendPacket(packet);
-    }
-  }
+static void saveCheckpoint() {
+  FlightCheckpoint cp;
+  cp.state = (uint8_t)currentState;
+  cp.flags = (sensorsCalibrated ? CHECKPOINT_CALIBRATED : 0) |
+             (powerDownComplete ? CHECKPOINT_POWERED_DOWN : 0);
+  cp.resets = inFlightResets;
+  cp.downlinkSeq = downlink.frameSequence();
+  cp.samplePeriodMs = (uint16_t)samplePeriodMs;
+  cp.phase = (uint8_t)flightEvents.phase();
+  cp.reserved = 0;
+  cp.initialAltitude = initialAltitude;
+  cp.peakAltitude = flightEvents.peakAltitude();
+  cp.msInPhase = flightEvents.msInPhase(millis());
+  cp.logSequence = flightLoggerNextSequence();
+  cp.uplinkCounter = dispatcher.lastCounterAccepted();
+  checkpointSave(cp);
+}
 
-  // log to sd card
-  if (sdcard_ptr) {
-    sdcard_ptr->writeLine("/flight_log.csv", packet);
-  }
+static void restoreCheckpoint(const FlightCheckpoint &cp) {
+  currentState = (FlightState)cp.state;
+  sensorsCalibrated = cp.flags & CHECKPOINT_CALIBRATED;
+  inFlightResets = cp.resets + 1;
+  downlink.setFrameSequence(cp.downlinkSeq);
+  samplePeriodMs = cp.samplePeriodMs;
+  initialAltitude = cp.initialAltitude;
+  // millis() restarted; keep the time already spent in the phase
+  flightEvents.resume((FlightPhase)cp.phase, millis(), cp.msInPhase,
+                      cp.initialAltitude, cp.peakAltitude);
+  dispatcher.resumeCounter(cp.uplinkCounter);
+  resumed = true;
 }
 
-// helper for calibration sensor condition
-static void checkSensorCondition(bool condition, const char *sensorName) {
-  if (condition) {
-    Serial.print(sensorName);
-    Serial.println(" sanity check PASSED.");
-  } else {
-    Serial.print(sensorName);
-    Serial.println(" sanity check FAILED!");
-  }
+static bool groundConfigState() {
+  return currentState == PRELAUNCH || currentState == POSTLAND;
 }
 
-// sensor sanity check function
-static void verifySensorSanity() {
-  bool result;
+static uint8_t onPing(const uplink::Command &) { return uplink::ACK_OK; }
 
-  // BMP280 temperature range -40 to +85 °C &
-  // pressure range ~300 to ~1100 hPa
-  if (bmp_ptr) {
-    float temp = bmp_ptr->readTemperature_C();
-    result = (!isnan(temp) && temp >= -40.0f && temp <= 85.0f);
-    checkSensorCondition(result, "BMP280 Temperature");
+static uint8_t onSetLogLevel(const uplink::Command &cmd) {
+  if (cmd.argLen != 1 || cmd.args[0] > DLOG_LEVEL_DEBUG)
+    return uplink::ACK_BAD_ARGS;
+  debugLogSetLevel(cmd.args[0]);
+  return uplink::ACK_OK;
+}
 
-    float pres = bmp_ptr->returnPressure_hPa();
-    result = (!isnan(pres) && pres >= 300.0f && pres <= 1100.0f);
-    checkSensorCondition(result, "BMP280 Pressure");
-  }
+static uint8_t onSetSamplePeriod(const uplink::Command &cmd) {
+  if (cmd.argLen != 2)
+    return uplink::ACK_BAD_ARGS;
+  uint32_t period = uplink::get16(cmd.args);
+  if (period < MIN_SAMPLE_PERIOD_MS || period > MAX_SAMPLE_PERIOD_MS)
+    return uplink::ACK_BAD_ARGS;
+  if (currentState != PRELAUNCH)
+    return uplink::ACK_WRONG_STATE;
+  samplePeriodMs = period;
+  return uplink::ACK_OK;
+}
 
-  // DHT11 temperature typically 0 to 50 °C &
-  // humidity typically 20% to 90%
-  if (dht_ptr) {
-    float temp = dht_ptr->readTemperature();
-    result = (!isnan(temp) && temp >= 0.0f && temp <= 50.0f);
-    checkSensorCondition(result, "DHT11 Temperature");
+static uint8_t onSetLoraProfile(const uplink::Command &cmd) {
+  if (cmd.argLen != 6)
+    return uplink::ACK_BAD_ARGS;
+  uint8_t sf = cmd.args[0];
+  long bandwidth = (long)uplink::get32(cmd.args + 1);
+  uint8_t codingRate4 = cmd.args[5];
+  if (!LoRaDriver::isValidProfile(sf, bandwidth, codingRate4))
+    return uplink::ACK_BAD_ARGS;
+  if (!groundConfigState())
+    return uplink::ACK_WRONG_STATE;
+  pendingSf = sf;
+  pendingBandwidth = bandwidth;
+  pendingCodingRate4 = codingRate4;
+  profilePending = true;
+  return uplink::ACK_OK;
+}
+
+static uint8_t onResendLog(const uplink::Command &cmd) {
+  if (cmd.argLen != 5 || cmd.args[4] == 0)
+    return uplink::ACK_BAD_ARGS;
+  if (!groundConfigState())
+    return uplink::ACK_WRONG_STATE;
+  if (resendRemaining)
+    return uplink::ACK_BUSY;
+  resendNextBlock = uplink::get32(cmd.args);
+  resendRemaining = cmd.args[4];
+  return uplink::ACK_OK;
+}
 
-    float hum = dht_ptr->readHumidity();
-    result = (!isnan(hum) && hum >= 20.0f && hum <= 90.0f);
-    checkSensorCondition(result, "DHT11 Humidity");
+static uint8_t onTimeSync(const uplink::Command &cmd) {
+  if (cmd.argLen != 8)
+    return uplink::ACK_BAD_ARGS;
+  if (!TDMA_SLOTS)
+    return uplink::ACK_WRONG_STATE;
+  // the stamp is from when the ground started sending; we saw the end
+  size_t len = uplink::HEADER_BYTES + cmd.argLen + uplink::TAG_BYTES;
+  tdma.beaconReceived(lora.lastRxUs() - lora.airtimeUs(len),
+                      uplink::get64(cmd.args));
+  return uplink::ACK_OK;
+}
+
+// keep one block read back from the card ahead of the downlink
+static void serviceResend() {
+  if (!resendRemaining || downlink.resendBusy())
+    return;
+  static uint8_t block[DownlinkScheduler::RESEND_BLOCK_BYTES];
+  uint32_t index;
+  bool ok;
+  if (flightLoggerTakeBlock(index, block, ok)) {
+    if (ok)
+      downlink.resendBlock(index, block);
+    else
+      DLOG_WARN("Resend: block %lu unreadable", (unsigned long)index);
+    resendNextBlock = index + 1;
+    resendRemaining--;
+    return;
   }
+  flightLoggerRequestBlock(resendNextBlock);
+}
 
-  // MPU6050 accel: raw accelerations in g; we check magnitude reasonable range
-  // ~0 to 16g
-  if (mpu_ptr) {
-    float ax, ay, az, gx, gy, gz;
-    mpu_ptr->readAccelGyro(ax, ay, az, gx, gy, gz);
-    float accelMag = sqrtf(ax * ax + ay * ay + az * az);
-    result = (accelMag >= 0.0f &&
-              accelMag <= 16.0f); // MPU6050 max ±16g configurable
-    checkSensorCondition(result, "MPU6050 Acceleration");
+// send whatever the downlink scheduler has due, within the airtime budget,
+// then listen for the ground
+static void serviceDownlink() {
+  if (!lora.isInitialized())
+    return;
+  uint32_t now = millis();
+  if (uplinkWindow) {
+    uplinkWindow->poll(now, dispatcher, downlink);
+    // persist before the next command can arrive, or a reboot would
+    // reopen the replay window
+    if (dispatcher.lastCounterAccepted() != savedUplinkCounter) {
+      savedUplinkCounter = dispatcher.lastCounterAccepted();
+      uplinkCounterStore.save(savedUplinkCounter);
+    }
+    if (uplinkWindow->isOpen())
+      return;
+  }
+  serviceResend();
+  // after landing only in the beacon's radio slot, unless the ground
+  // asked for log blocks
+  if (beacon.isRunning() && !beacon.radioSlot(now) && !resendRemaining &&
+      !downlink.resendBusy()) {
+    if (!radioAsleep) {
+      lora.sleep();
+      radioAsleep = true;
+    }
+    return;
   }
+  if (!downlink.canSend(now))
+    return;
+  // one frame per superframe, in our own slot
+  uint64_t slotUs = tdmaNowUs();
+  if (tdma.enabled() && !tdma.mayTransmit(slotUs, tdmaSynced()))
+    return;
 
-  // Compass heading check: should be between 0 and 360 degrees
-  if (compass_ptr) {
-    float heading = compass_ptr->readHeading();
-    result = (heading >= 0.0f && heading <= 360.0f);
-    checkSensorCondition(result, "Compass Heading");
+  DownlinkHealth health;
+  health.state = (uint8_t)currentState;
+  health.flags = (timeBaseIsDisciplined() ? HEALTH_TIME_UTC : 0) |
+                 (flightLoggerIsRaw() ? HEALTH_LOG_RAW : 0) |
+                 (sensors.hasFix() ? HEALTH_GPS_FIX : 0) |
+                 (tdma.enabled() && tdmaSynced() ? HEALTH_TDMA_SYNC : 0);
+  health.uptime_s = now / 1000;
+  health.logBlocks = flightLoggerBlocksWritten();
+  health.logDrops = flightLoggerDropped() + flightLoggerWriteLost();
+  health.debugLogDrops = debugLogDropped();
+  downlink.observeHealth(health);
+
+  static_assert(DownlinkScheduler::MAX_FRAME_BYTES <= LoRaDriver::MAX_PAYLOAD,
+                "downlink frames must fit the radio");
+  uint8_t frame[LoRaDriver::MAX_PAYLOAD];
+  size_t len = downlink.buildFrame(currentState, now, timeBaseNowUs(), frame);
+  if (len == 0)
+    return;
+  lora.sendPacket(frame, len);
+  radioAsleep = false;
+  downlink.frameSent(now, lora.airtimeUs(len));
+  tdma.transmitted(slotUs);
+
+  if (profilePending && !downlink.acksPending()) {
+    lora.setProfile(pendingSf, pendingBandwidth, pendingCodingRate4);
+    profilePending = false;
+    configureTdma();
   }
+  if (uplinkWindow)
+    uplinkWindow->afterTransmit(millis());
+}
 
-  // GPS fix presence - simple valid fix (boolean) check
-  if (gps_ptr) {
-    result = gps_ptr->hasFix();
-    checkSensorCondition(result, "GPS Fix");
+// starts each beacon slot: the position goes out at the top of the radio
+// slot, the buzzer only plays while the radio sleeps
+static void serviceBeacon() {
+  uint32_t now = millis();
+  RecoveryBeacon::Cue cue = beacon.update(now);
+  if (cue == RecoveryBeacon::CUE_NONE)
+    return;
+  if (cue == RecoveryBeacon::CUE_RADIO) {
+    buzzer.stop();
+    downlink.resetSchedule(now);
+    return;
   }
+  beaconPattern.clear();
+  if (cue == RecoveryBeacon::CUE_MORSE_FIX && haveFix)
+    tones::morseFix(beaconPattern, lastFixLat, lastFixLon);
+  else
+    tones::locateChirps(beaconPattern, RecoveryBeacon::CHIRPS_PER_SLOT);
+  buzzer.play(beaconPattern);
+  beacon.audioStarted(now, beaconPattern.durationMs());
 }
 
-void stateMachineInit(BMP280_Driver &bmp, DHT11_Driver &dht,
-                      MPU6050_Driver &mpu, Compass_Driver &compass,
-                      GPS_Driver &gps, Buzzer_Driver &buzzer,
-                      SDCard_Driver &sdcard, LoRaDriver &lora) {
-  bmp_ptr = &bmp;
-  dht_ptr = &dht;
-  mpu_ptr = &mpu;
-  compass_ptr = &compass;
-  gps_ptr = &gps;
-  buzzer_ptr = &buzzer;
-  sdcard_ptr = &sdcard;
-  lora_ptr = &lora;
+// journal the event and run the entry actions of the state it leads to
+static void onFlightEvent(FlightEvent event) {
+  const EventRecord &e = flightEvents.journalAt(flightEvents.journalSize() - 1);
+  DLOG_INFO("Event %s: %.1f m above ground, %.1f m/s", flightEventName(event),
+            e.altitude, e.velocity);
+
+  FlightState next = flightStateOf(flightEvents.phase());
+  if (next == currentState)
+    return; // burnout stays in ASCENT
+  currentState = next;
+  logMemory(MEMORY_TRANSITION);
+  switch (currentState) {
+  case ASCENT:
+    DLOG_INFO("Transition to ASCENT");
+    captureStart();
+    break;
+  case DESCENT:
+    DLOG_INFO("Transition to DESCENT");
+    captureStop();
+    break;
+  case POSTLAND:
+    DLOG_INFO("Transition to POSTLAND");
+    captureStop(); // what is left drains from here
+    flightLoggerFlush();
+    DLOG_INFO("Logger drops: %u samples, %u vibration, %u memory, %u "
+              "samples lost to write failures",
+              flightLoggerDropped(), flightLoggerVibrationDropped(),
+              flightLoggerMemoryDropped(), flightLoggerWriteLost());
+    // Power down heavy sensors (do this once)
+    powerDownSensors();
+
+    // GPS stays up for recovery: POSTLAND keeps logging the position, and
+    // the beacon sends position packets and locate chirps until found
+    beacon.start(millis());
+    break;
+  default:
+    break;
+  }
+}
 
+void stateMachineInit() {
   currentState = PRELAUNCH;
 
   initialAltitude = NAN;
-  lastAltitude = NAN;
-  landedStableTime = 0;
+  flightEvents.reset();
+
+  FlightCheckpoint cp;
+  bool resuming = checkpointLoad(cp);
+  if (resuming)
+    restoreCheckpoint(cp);
+
+  // in flight the stored calibration is the one we launched with; on the
+  // pad only a warm reboot reuses it, a power cycle starts a new one
+  CalibrationData stored;
+  bool haveStored = calibrationStore.load(stored);
+  esp_reset_reason_t reason = esp_reset_reason();
+  if (haveStored && (resuming || reason != ESP_RST_POWERON)) {
+    applyCalibration(stored);
+    calibrationAgeChecked = resuming || stored.utcSeconds == 0;
+    if (!resuming) {
+      initialAltitude = stored.groundAltitude;
+      flightEvents.setGround(initialAltitude);
+    }
+    DLOG_INFO("Using stored calibration");
+  } else if (resuming) {
+    calibrationReady = true; // flying uncalibrated, don't start averaging
+    calibrationAgeChecked = true;
+  } else {
+    startCalibration();
+  }
+
+  if (PSRAM_CAPTURE)
+    captureInit();
+  // on a resume main left the card unmounted, the logger task mounts it
+  flightLoggerInit(payload.sdcard, "/flight_log.bin", SD_RAW_LOG,
+                   resuming ? cp.logSequence : 0, resuming);
+
+  // the PSRAM capture takes its IMU frames from the FIFO
+  if (VIBRATION_ANALYSIS || PSRAM_CAPTURE)
+    sensors.startVibration();
+  logMemory(MEMORY_BOOT);
+
+  if (UPLINK_ENABLED) {
+    // the newer of NVS and the checkpoint (a save may have been cut short)
+    savedUplinkCounter = uplinkCounterStore.load();
+    if (savedUplinkCounter > dispatcher.lastCounterAccepted())
+      dispatcher.resumeCounter(savedUplinkCounter);
+    savedUplinkCounter = dispatcher.lastCounterAccepted();
+    static UplinkWindow<Board::Radio> window(lora, UPLINK_WINDOW_MS);
+    uplinkWindow = &window;
+    dispatcher.on(uplink::CMD_PING, onPing);
+    dispatcher.on(uplink::CMD_SET_LOG_LEVEL, onSetLogLevel);
+    dispatcher.on(uplink::CMD_SET_SAMPLE_PERIOD, onSetSamplePeriod);
+    dispatcher.on(uplink::CMD_SET_LORA_PROFILE, onSetLoraProfile);
+    dispatcher.on(uplink::CMD_RESEND_LOG, onResendLog);
+    dispatcher.on(uplink::CMD_TIME_SYNC, onTimeSync);
+  } else {
+    DLOG_WARN("No UPLINK_KEY in this build, command uplink disabled");
+  }
+  configureTdma();
 
-  Serial.println("State machine initialized: PRELAUNCH");
+  if (!resuming) {
+    DLOG_INFO("State machine initialized: PRELAUNCH");
+    return;
+  }
+  // the sensors were restarted (main.cpp), so redo the landing shutdown
+  if (cp.flags & CHECKPOINT_POWERED_DOWN)
+    powerDownSensors();
+  if (currentState == ASCENT)
+    captureStart(); // PSRAM didn't survive the reset, start a new run
+  if (currentState == POSTLAND)
+    beacon.start(millis());
+  else
+    playStatus(STATUS_RESUMED);
+  DLOG_WARN("State machine resumed in state %d after %u in-flight resets",
+            (int)currentState, inFlightResets);
 }
 
 void stateMachineUpdate() {
+  // drain NMEA every pass so the time base stays disciplined in all states
+  sensors.poll();
+
+  // one acquisition per pass feeds logging, downlink and detection
+  acquireSample(sample);
+  if (PSRAM_CAPTURE)
+    captureBaro(sample.pressure, sample.temp_bmp, sample.baro_us, sample.utc);
+  filterStage.push(sample);
+  downlink.observe(sample, filterStage.altitude());
+  TelemetrySample decimated;
+  if (filterStage.popDownlink(decimated))
+    downlink.observeDownlink(decimated);
+  vibration::Summary vib;
+  if (VIBRATION_DOWNLINK && vibrationTakeSummary(vib))
+    downlink.observeVibration(vib);
+
+  FlightState previousState = currentState;
   switch (currentState) {
   case PRELAUNCH:
     if (!sensorsCalibrated) {
-      verifySensorSanity();
+      sensors.checkSanity();
       sensorsCalibrated = true;
     }
-
-    // check for launch condition (altitude increase or accelration)
-    if (detectLaunch()) {
-      currentState = ASCENT;
-      Serial.println("Transition to ASCENT");
-    }
+    updateCalibration();
     break;
   case ASCENT:
-    // log and send data over telemetry
-    transmitAndLogData();
-
-    // transition on altitude decrease inidicating start of descent
-    if (detectDescent()) {
-      currentState = DESCENT;
-      Serial.println("Transition to DESCENT");
-    }
+    // log data (telemetry goes out through the downlink scheduler)
+    logData();
     break;
 
   case DESCENT:
-    // log and send data
-    transmitAndLogData();
-
-    // check if landed (no altitude change for given duration)
-    if (detectLanding()) {
-      currentState = POSTLAND;
-      Serial.println("Transition to POSTLAND");
-      // Power down heavy sensors (do this once)
-      static bool powerDownComplete = false;
-      if (!powerDownComplete) {
-        Serial.println("Powering down sensors...");
-        if (mpu_ptr)
-          mpu_ptr->powerDown();
-        if (compass_ptr)
-          compass_ptr->powerDown(); // Add this method
-        if (bmp_ptr)
-          bmp_ptr->powerDown();
-        // Keep GPS and SD card active for recovery data logging
-        powerDownComplete = true;
-      }
-
-      // Keep GPS active for location reporting
-      // if (gps_ptr) {
-      //   gps_ptr->read();
-      //   if (gps_ptr->locationUpdated()) {
-      //     // Log GPS coordinates to SD for recovery
-      //     String gpsData = String(gps_ptr->latitude(), 6) + "," +
-      //                      String(gps_ptr->longitude(), 6);
-      //     if (sd_ptr)
-      //       sd_ptr->writeLine("/recovery.txt", gpsData);
-      //   }
-      // }
-
-      if (buzzer_ptr) {
-        // TODO: beeping pattern?
-        buzzer_ptr->startTone(2000); // 2kHz tone
-      }
-    }
+    // log data
+    logData();
     break;
 
   case POSTLAND:
-    transmitAndLogData();
-    if (gps_ptr) {
-      gps_ptr->read();
-
-      if (gps_ptr->locationUpdated()) {
-        transmitAndLogData();
-      }
-    }
+    // gps is drained at the top of every pass
+    logData();
+    serviceBeacon();
     break;
   default:
-    Serial.println("Unknown state");
+    DLOG_ERROR("Unknown state");
     break;
   }
+
+  // launch, burnout, apogee and landing come from the event engine
+  FlightEvent event = flightEvents.update(millis(), sample.baro_us,
+                                          filterStage.altitude(),
+                                          filterStage.accelMag());
+  if (event != EVENT_NONE)
+    onFlightEvent(event);
+
+  // the new state's messages go out right away
+  if (currentState != previousState)
+    downlink.resetSchedule(millis());
+  serviceDownlink();
+
+  if (millis() - lastMemoryMs >= MEMORY_SNAPSHOT_MS)
+    logMemory(MEMORY_PERIODIC);
+
+  saveCheckpoint();
+}
+
+// with TDMA the loop wakes early to be at the radio when our slot opens;
+// a PSRAM capture runs the pass flat out
+uint32_t stateMachineSamplePeriodMs() {
+  uint32_t periodMs =
+      captureRecording() ? MIN_SAMPLE_PERIOD_MS : samplePeriodMs;
+  if (!tdma.enabled())
+    return periodMs;
+  uint32_t untilSlotMs = tdma.usUntilWindow(tdmaNowUs(), tdmaSynced()) / 1000;
+  return untilSlotMs < periodMs ? untilSlotMs : periodMs;
 }
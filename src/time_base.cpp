@@ -0,0 +1,107 @@
+#include "../include/time_base.h"
+#include <Arduino.h>
+#include <esp_timer.h>
+
+// written by the PPS interrupt
+static volatile int64_t lastEdgeLocalUs = 0;
+static volatile int64_t prevEdgeLocalUs = 0;
+static volatile uint32_t edgeCount = 0;
+static portMUX_TYPE ppsMux = portMUX_INITIALIZER_UNLOCKED;
+
+// anchor: local esp_timer time of a PPS edge and the UTC second it marks
+static int64_t anchorLocalUs = 0;
+static uint64_t anchorUtcUs = 0;
+static uint32_t anchorEdgeCount = 0;
+static uint32_t rateEdgeCount = 0;
+static bool disciplined = false;
+static portMUX_TYPE anchorMux = portMUX_INITIALIZER_UNLOCKED;
+
+// local microseconds per GPS second, smoothed
+static float periodUs = 1000000.0f;
+
+// thresholds
+static const int64_t PPS_PERIOD_TOLERANCE_US = 500; // reject glitches
+static const int64_t PPS_PAIRING_WINDOW_US =
+    900000; // NMEA time must follow its edge within this window
+static const float PERIOD_SMOOTHING = 0.125f;
+
+static void IRAM_ATTR onPpsEdge() {
+  int64_t now = esp_timer_get_time();
+  portENTER_CRITICAL_ISR(&ppsMux);
+  prevEdgeLocalUs = lastEdgeLocalUs;
+  lastEdgeLocalUs = now;
+  edgeCount = edgeCount + 1;
+  portEXIT_CRITICAL_ISR(&ppsMux);
+}
+
+void timeBaseInit(uint8_t ppsPin) {
+  pinMode(ppsPin, INPUT);
+  attachInterrupt(digitalPinToInterrupt(ppsPin), onPpsEdge, RISING);
+  disciplined = false;
+  periodUs = 1000000.0f;
+}
+
+static void setAnchor(int64_t localUs, uint64_t utcUs) {
+  portENTER_CRITICAL(&anchorMux);
+  anchorLocalUs = localUs;
+  anchorUtcUs = utcUs;
+  disciplined = true;
+  portEXIT_CRITICAL(&anchorMux);
+}
+
+void timeBaseUpdate(GPS_Driver &gps) {
+  portENTER_CRITICAL(&ppsMux);
+  int64_t edge = lastEdgeLocalUs;
+  int64_t prevEdge = prevEdgeLocalUs;
+  uint32_t count = edgeCount;
+  portEXIT_CRITICAL(&ppsMux);
+
+  // rate correction from back-to-back edges only
+  if (count != rateEdgeCount) {
+    int64_t interval = edge - prevEdge;
+    if (prevEdge != 0 &&
+        llabs(interval - 1000000) < PPS_PERIOD_TOLERANCE_US) {
+      periodUs += PERIOD_SMOOTHING * ((float)interval - periodUs);
+    }
+    rateEdgeCount = count;
+  }
+
+  if (gps.timeUpdated() && gps.hasTime()) {
+    // NMEA time of day refers to the edge that preceded it
+    uint64_t utcUs = (uint64_t)gps.utcEpochSeconds() * 1000000ULL;
+    if (count != 0 && esp_timer_get_time() - edge < PPS_PAIRING_WINDOW_US) {
+      setAnchor(edge, utcUs);
+      anchorEdgeCount = count;
+      return;
+    }
+  }
+
+  if (disciplined && count != anchorEdgeCount) {
+    // holdover: count whole seconds since the previous anchor
+    int64_t elapsed = edge - anchorLocalUs;
+    int64_t seconds = (int64_t)((float)elapsed / periodUs + 0.5f);
+    setAnchor(edge, anchorUtcUs + (uint64_t)seconds * 1000000ULL);
+    anchorEdgeCount = count;
+  }
+}
+
+uint64_t timeBaseNowUs() {
+  int64_t local = esp_timer_get_time();
+
+  portENTER_CRITICAL(&anchorMux);
+  bool valid = disciplined;
+  int64_t aLocal = anchorLocalUs;
+  uint64_t aUtc = anchorUtcUs;
+  portEXIT_CRITICAL(&anchorMux);
+
+  if (!valid)
+    return (uint64_t)local;
+
+  // scale elapsed local time by the measured oscillator rate
+  int64_t elapsed = local - aLocal;
+  return aUtc + (uint64_t)(elapsed * 1000000LL / (int64_t)periodUs);
+}
+
+bool timeBaseIsDisciplined() { return disciplined; }
+
+float timeBaseDriftPpm() { return (periodUs - 1000000.0f); }
@@ -0,0 +1,132 @@
+#include "../include/vibration_monitor.h"
+#include "../include/debug_log.h"
+#include "../include/flight_logger.h"
+#include "../include/memory_monitor.h"
+#include "../include/psram_capture.h"
+#include "../include/time_base.h"
+#include <Arduino.h>
+
+static const uint32_t VIBRATION_STACK_BYTES = 4096;
+static const UBaseType_t VIBRATION_PRIORITY = 2; // above the logger
+static const TickType_t VIBRATION_POLL_TICKS =
+    pdMS_TO_TICKS(20); // the FIFO holds 85 ms at 1 kHz
+static const int FIFO_MAX_FRAMES = 85;
+
+static MPU6050_Driver *mpu_ptr = nullptr;
+static volatile bool running = false;
+static vibration::VibrationAnalyzer<VIBRATION_WINDOW>
+    analyzer(VIBRATION_RATE_HZ);
+static float fifoAccel[FIFO_MAX_FRAMES][3];
+static float fifoGyro[FIFO_MAX_FRAMES][3];
+static volatile uint32_t windows = 0;
+static volatile uint32_t overflows = 0;
+
+// running sums for the sensor loop
+static float accelSum[3], gyroSum[3];
+static uint32_t sumCount = 0;
+static portMUX_TYPE sumMux = portMUX_INITIALIZER_UNLOCKED;
+
+// newest accel summary for the downlink
+static vibration::Summary latest;
+static bool latestFresh = false;
+static portMUX_TYPE latestMux = portMUX_INITIALIZER_UNLOCKED;
+
+MEMORY_TAG("vibration", analyzer);
+MEMORY_TAG("vibration", fifoAccel);
+MEMORY_TAG("vibration", fifoGyro);
+
+static void publish() {
+  windows = windows + 1;
+  for (int c = 0; c < vibration::CHANNELS; c++)
+    flightLoggerPushVibration(analyzer.summary(c));
+  portENTER_CRITICAL(&latestMux);
+  latest = analyzer.summary(vibration::CH_ACCEL);
+  latestFresh = true;
+  portEXIT_CRITICAL(&latestMux);
+}
+
+static void vibrationTask(void *) {
+  const uint64_t periodUs = 1000000ULL / VIBRATION_RATE_HZ;
+  for (;;) {
+    vTaskDelay(VIBRATION_POLL_TICKS);
+    if (!running)
+      continue;
+    int n = mpu_ptr->readFifo(fifoAccel, fifoGyro, FIFO_MAX_FRAMES);
+    if (n < 0) {
+      // lost samples; a window must be contiguous
+      overflows = overflows + 1;
+      analyzer.reset();
+      continue;
+    }
+    uint64_t now = timeBaseNowUs();
+    bool utc = timeBaseIsDisciplined();
+    float a[3] = {0, 0, 0}, g[3] = {0, 0, 0};
+    for (int i = 0; i < n; i++) {
+      for (int k = 0; k < 3; k++) {
+        a[k] += fifoAccel[i][k];
+        g[k] += fifoGyro[i][k];
+      }
+      // the newest frame was sampled just before the drain
+      uint64_t t = now - (uint64_t)(n - 1 - i) * periodUs;
+      if (PSRAM_CAPTURE)
+        captureImu(fifoAccel[i], fifoGyro[i], t, utc);
+      if (analyzer.push(fifoAccel[i], fifoGyro[i], t, utc))
+        publish();
+    }
+    portENTER_CRITICAL(&sumMux);
+    for (int k = 0; k < 3; k++) {
+      accelSum[k] += a[k];
+      gyroSum[k] += g[k];
+    }
+    sumCount += n;
+    portEXIT_CRITICAL(&sumMux);
+  }
+}
+
+void vibrationMonitorInit(MPU6050_Driver &mpu) {
+  if (mpu_ptr)
+    return;
+  mpu_ptr = &mpu;
+  mpu.startFifo(VIBRATION_RATE_HZ);
+  running = true;
+  TaskHandle_t task = nullptr;
+  xTaskCreatePinnedToCore(vibrationTask, "vibration", VIBRATION_STACK_BYTES,
+                          nullptr, VIBRATION_PRIORITY, &task, 0);
+  memoryWatchTask(task);
+  DLOG_INFO("Vibration monitor: %u Hz, %u-point windows",
+            (unsigned)VIBRATION_RATE_HZ, (unsigned)VIBRATION_WINDOW);
+}
+
+void vibrationMonitorStop() {
+  if (!mpu_ptr || !running)
+    return;
+  running = false;
+  mpu_ptr->stopFifo();
+}
+
+bool vibrationTakeImuMean(float accel[3], float gyro[3]) {
+  portENTER_CRITICAL(&sumMux);
+  uint32_t n = sumCount;
+  for (int k = 0; k < 3 && n; k++) {
+    accel[k] = accelSum[k] / n;
+    gyro[k] = gyroSum[k] / n;
+    accelSum[k] = gyroSum[k] = 0.0f;
+  }
+  sumCount = 0;
+  portEXIT_CRITICAL(&sumMux);
+  return n > 0;
+}
+
+bool vibrationTakeSummary(vibration::Summary &s) {
+  portENTER_CRITICAL(&latestMux);
+  bool fresh = latestFresh;
+  if (fresh)
+    s = latest;
+  latestFresh = false;
+  portEXIT_CRITICAL(&latestMux);
+  return fresh;
+}
+
+uint32_t vibrationWindows() { return windows; }
+
+uint32_t vibrationOverflows() { return overflows; }
@@ -0,0 +1,6 @@
+// generated from esp32dev.csv by tools/bench_baseline_header.py,
+// do not edit
+
+static const BenchBaseline BENCH_BASELINE[] = {
+    {nullptr, nullptr, nullptr, 0.0},
+};
@@ -0,0 +1,14 @@
+// generated from native.csv by tools/bench_baseline_header.py,
+// do not edit
+
+static const BenchBaseline BENCH_BASELINE[] = {
+    {"hotpath", "altitude", "ns", 11.96},
+    {"hotpath", "downlink_frame", "ns", 131.25},
+    {"hotpath", "downlink_frame_bytes", "B", 46.00},
+    {"hotpath", "filter_stage", "ns", 163.84},
+    {"hotpath", "flight_events", "ns", 78.55},
+    {"hotpath", "heading", "ns", 11.44},
+    {"hotpath", "log_encode", "ns", 273.99},
+    {"hotpath", "uplink_verify", "ns", 33.06},
+    {nullptr, nullptr, nullptr, 0.0},
+};
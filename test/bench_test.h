@@ -0,0 +1,144 @@
+#ifndef BENCH_TEST_H
+#define BENCH_TEST_H
+
+#include "bench_report.h"
+#include <cstdio>
+#include <cstring>
+#include <unity.h>
+
+// Shared by the benchmark tests: collects the BENCH results of a suite
+// (bench_report.h benchHook), keeps the best of BENCH_TEST_RUNS runs, and
+// fails when any of them is more than BENCH_TEST_TOLERANCE percent above
+// the committed baseline for this env (test/baselines/<env>.csv, compiled
+// in as test/baselines/<env>.h), or has no baseline entry at all.
+// Recording a baseline is in test/README.
+
+struct BenchBaseline {
+  const char *suite;
+  const char *name;
+  const char *unit;
+  double value;
+};
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include "baselines/esp32dev.h"
+#else
+#include "baselines/native.h"
+#endif
+
+#ifndef BENCH_TEST_RUNS
+#define BENCH_TEST_RUNS 3
+#endif
+#ifndef BENCH_TEST_TOLERANCE
+#define BENCH_TEST_TOLERANCE 10.0
+#endif
+#ifndef BENCH_TEST_GATE_TIMING
+// cycle counts repeat to a few percent; host nanoseconds depend on the
+// machine and its load, so native only prints them and gates the results
+// that don't (frame sizes and the like)
+#if defined(ARDUINO_ARCH_ESP32)
+#define BENCH_TEST_GATE_TIMING 1
+#else
+#define BENCH_TEST_GATE_TIMING 0
+#endif
+#endif
+
+static const int BENCH_TEST_MAX_RESULTS = 64;
+
+struct BenchResult {
+  char suite[16];
+  char name[24];
+  char unit[8];
+  double value;
+};
+
+static BenchResult benchResults[BENCH_TEST_MAX_RESULTS];
+static int benchResultCount = 0;
+
+// copies the names, some runners build them on the stack
+static void benchCollect(const char *suite, const char *name,
+                         const char *unit, double value) {
+  for (int i = 0; i < benchResultCount; i++) {
+    BenchResult &r = benchResults[i];
+    if (!strcmp(r.suite, suite) && !strcmp(r.name, name) &&
+        !strcmp(r.unit, unit)) {
+      r.value = value < r.value ? value : r.value;
+      return;
+    }
+  }
+  if (benchResultCount == BENCH_TEST_MAX_RESULTS)
+    return;
+  BenchResult &r = benchResults[benchResultCount++];
+  snprintf(r.suite, sizeof(r.suite), "%s", suite);
+  snprintf(r.name, sizeof(r.name), "%s", name);
+  snprintf(r.unit, sizeof(r.unit), "%s", unit);
+  r.value = value;
+}
+
+static const BenchResult *benchFind(const BenchBaseline &b) {
+  for (int i = 0; i < benchResultCount; i++) {
+    const BenchResult &r = benchResults[i];
+    if (!strcmp(r.suite, b.suite) && !strcmp(r.name, b.name) &&
+        !strcmp(r.unit, b.unit))
+      return &r;
+  }
+  return nullptr;
+}
+
+static bool benchGated(const char *unit) {
+  return BENCH_TEST_GATE_TIMING || strcmp(unit, BENCH_TICK_UNIT);
+}
+
+static bool benchHasBaseline(const BenchResult &r) {
+  for (const BenchBaseline *b = BENCH_BASELINE; b->suite; b++)
+    if (!strcmp(r.suite, b->suite) && !strcmp(r.name, b->name) &&
+        !strcmp(r.unit, b->unit))
+      return true;
+  return false;
+}
+
+// runs the suite and checks every baseline entry it owns
+static void benchCheckSuite(const char *suite, void (*run)()) {
+  benchResultCount = 0;
+  benchHook = benchCollect;
+  for (int i = 0; i < BENCH_TEST_RUNS; i++)
+    run();
+  benchHook = nullptr;
+
+  int checked = 0, failed = 0, unrecorded = 0;
+  for (const BenchBaseline *b = BENCH_BASELINE; b->suite; b++) {
+    if (strcmp(b->suite, suite))
+      continue;
+    checked++;
+    const BenchResult *r = benchFind(*b);
+    if (!r) {
+      BENCH_PRINTF("  MISSING  %s/%s %s\n", b->suite, b->name, b->unit);
+      failed++;
+      continue;
+    }
+    double change = b->value ? 100.0 * (r->value - b->value) / b->value : 0.0;
+    bool slow = change > BENCH_TEST_TOLERANCE;
+    bool gated = benchGated(b->unit);
+    failed += slow && gated;
+    BENCH_PRINTF("  %-8s %s/%s %.2f %s  baseline %.2f  %+.1f%%\n",
+                 slow ? (gated ? "FAIL" : "slow") : "ok", b->suite, b->name,
+                 r->value, b->unit, b->value, change);
+  }
+  for (int i = 0; i < benchResultCount; i++) {
+    const BenchResult &r = benchResults[i];
+    if (benchHasBaseline(r))
+      continue;
+    bool gated = benchGated(r.unit);
+    unrecorded += gated;
+    BENCH_PRINTF("  %-8s %s/%s %.2f %s  no baseline\n",
+                 gated ? "NEW" : "info", r.suite, r.name, r.value, r.unit);
+  }
+  if (!checked && !unrecorded)
+    TEST_IGNORE_MESSAGE("suite reported nothing gated on this env");
+  TEST_ASSERT_EQUAL_INT_MESSAGE(0, failed,
+                                "results missing or slower than baseline");
+  TEST_ASSERT_EQUAL_INT_MESSAGE(
+      0, unrecorded, "results with no baseline, record one (test/README)");
+}
+
+#endif // !BENCH_TEST_H
@@ -0,0 +1,33 @@
+// Hot-path microbenchmarks (hot_path_benchmark.h) against the committed
+// baseline: CPU cycles in esp32dev; in the native env the nanoseconds are
+// report only and the frame size is what gates (bench_test.h).
+//
+//   pio test -e native -f test_hot_path
+//   pio test -e esp32dev -f test_hot_path
+
+#include "../bench_test.h"
+#include "hot_path_benchmark.h"
+
+void setUp() {}
+void tearDown() {}
+
+static void test_hot_path_within_baseline() {
+  benchCheckSuite("hotpath", runHotPathBenchmark);
+}
+
+static int runTests() {
+  UNITY_BEGIN();
+  RUN_TEST(test_hot_path_within_baseline);
+  return UNITY_END();
+}
+
+#if defined(ARDUINO)
+void setup() {
+  delay(2000); // let the test runner open the port
+  runTests();
+}
+
+void loop() {}
+#else
+int main() { return runTests(); }
+#endif
@@ -0,0 +1,43 @@
+// On-target kernel benchmarks (math, filter, log codec, vibration FFT)
+// against the committed esp32dev baseline. These use the cycle counter
+// directly, so the native env skips them.
+//
+//   pio test -e esp32dev -f test_kernels
+
+#include "../bench_test.h"
+#include "filter_benchmark.h"
+#include "log_codec_benchmark.h"
+#include "math_benchmark.h"
+#include "vibration_benchmark.h"
+#include <Arduino.h>
+
+void setUp() {}
+void tearDown() {}
+
+static void test_math_within_baseline() {
+  benchCheckSuite("math", runMathBenchmark);
+}
+
+static void test_filter_within_baseline() {
+  benchCheckSuite("filter", runFilterBenchmark);
+}
+
+static void test_log_codec_within_baseline() {
+  benchCheckSuite("log_codec", runLogCodecBenchmark);
+}
+
+static void test_vibration_within_baseline() {
+  benchCheckSuite("vibration", runVibrationBenchmark);
+}
+
+void setup() {
+  delay(2000); // let the test runner open the port
+  UNITY_BEGIN();
+  RUN_TEST(test_math_within_baseline);
+  RUN_TEST(test_filter_within_baseline);
+  RUN_TEST(test_log_codec_within_baseline);
+  RUN_TEST(test_vibration_within_baseline);
+  UNITY_END();
+}
+
+void loop() {}
@@ -0,0 +1,57 @@
+// Whole state machine passes on mocked sensors (pipeline_benchmark.h) and
+// the SD write latency on the board's card (sd_latency_benchmark.h),
+// against the committed esp32dev baseline. Built with the firmware
+// sources and MockBoard; main.cpp is left out for this setup().
+//
+//   pio test -e esp32dev_pipeline_test
+
+#include "../bench_test.h"
+#include "board_config.h"
+#include "debug_log.h"
+#include "memory_monitor.h"
+#include "pipeline_benchmark.h"
+#include "sd_latency_benchmark.h"
+#include <Arduino.h>
+#include <Wire.h>
+
+Payload payload;
+MEMORY_TAG("drivers", payload);
+
+// MockBoard only mocks the card the logger sees, this one is real
+static SDCard_Driver card(Board::SD_CS);
+
+void setUp() {}
+void tearDown() {}
+
+static void runSdLatency() { runSdLatencyBenchmark(card); }
+
+static void test_sd_latency_within_baseline() {
+  if (!card.isInitialized() && !card.begin())
+    TEST_IGNORE_MESSAGE("no SD card");
+  benchCheckSuite("sd", runSdLatency);
+}
+
+static void test_pipeline_within_baseline() {
+  benchCheckSuite("pipeline", runPipelineBenchmark);
+}
+
+void setup() {
+  delay(2000); // let the test runner open the port
+  debugLogInit();
+  memoryWatchTask(xTaskGetCurrentTaskHandle());
+  Wire.begin(Board::I2C_SDA, Board::I2C_SCL);
+  pinMode(Board::SD_CS, OUTPUT);
+  pinMode(Board::LORA_CS, OUTPUT);
+  digitalWrite(Board::SD_CS, HIGH);
+  digitalWrite(Board::LORA_CS, HIGH);
+  payload.sensors.begin();
+  payload.sdcard.begin();
+  payload.lora.begin();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_sd_latency_within_baseline);
+  RUN_TEST(test_pipeline_within_baseline);
+  UNITY_END();
+}
+
+void loop() {}
@@ -0,0 +1,37 @@
+#!/usr/bin/env python3
+"""Turn a benchmark baseline CSV into the C table the Unity tests compile in.
+
+The baselines under test/baselines/ are kept by tools/bench_compare.py
+--update; the tests (test/bench_test.h) can't read a file on target, so
+each CSV is mirrored by a header of the same name. Regenerate it whenever
+the CSV changes:
+
+    python3 tools/bench_baseline_header.py test/baselines/native.csv
+"""
+
+import csv
+import os
+import sys
+
+
+def main():
+    if len(sys.argv) != 2:
+        sys.exit("usage: bench_baseline_header.py <baseline.csv>")
+    src = sys.argv[1]
+    out = os.path.splitext(src)[0] + ".h"
+    with open(src, newline="") as f:
+        rows = [(r["suite"], r["name"], r["unit"], float(r["value"]))
+                for r in csv.DictReader(f)]
+    with open(out, "w") as f:
+        f.write("// generated from %s by tools/bench_baseline_header.py,\n"
+                "// do not edit\n\n" % os.path.basename(src))
+        f.write("static const BenchBaseline BENCH_BASELINE[] = {\n")
+        for suite, name, unit, value in sorted(rows):
+            f.write('    {"%s", "%s", "%s", %.2f},\n' %
+                    (suite, name, unit, value))
+        f.write("    {nullptr, nullptr, nullptr, 0.0},\n};\n")
+    print("%d entries written to %s" % (len(rows), out))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,118 @@
+#!/usr/bin/env python3
+"""Check benchmark results against a stored baseline.
+
+Reads the BENCH lines (include/bench_report.h) from a serial capture of the
+esp32dev_bench env, or from tools/hot_path_bench on the host, and compares
+each against the baseline CSV. All units are lower-is-better, so a value
+more than --tolerance percent above its baseline is a regression.
+
+    pio device monitor -e esp32dev_bench | tee bench.txt
+    python3 tools/bench_compare.py bench.txt test/baselines/esp32dev.csv
+    ./hot_path_bench | python3 tools/bench_compare.py - test/baselines/native.csv
+
+--update writes the run into the baseline instead (new or faster results
+only, unless --reset). Record a baseline per machine: ESP32 cycle counts
+are stable across boards at the same clock, host nanoseconds are not. The
+baselines the Unity tests check are under test/baselines/ (test/README).
+
+Exits 1 on any regression, 2 when there is nothing to compare.
+"""
+
+import argparse
+import csv
+import os
+import sys
+
+
+def read_results(stream):
+    results = {}
+    for line in stream:
+        line = line.strip()
+        i = line.find("BENCH,")
+        if i < 0:
+            continue
+        parts = line[i:].split(",")
+        if len(parts) != 5:
+            continue
+        try:
+            results[tuple(parts[1:4])] = float(parts[4])
+        except ValueError:
+            continue  # garbled serial line
+    return results
+
+
+def read_baseline(path):
+    baseline = {}
+    if not os.path.exists(path):
+        return baseline
+    with open(path, newline="") as f:
+        for row in csv.DictReader(f):
+            key = (row["suite"], row["name"], row["unit"])
+            baseline[key] = float(row["value"])
+    return baseline
+
+
+def write_baseline(path, baseline):
+    with open(path, "w", newline="") as f:
+        w = csv.writer(f, lineterminator="\n")
+        w.writerow(["suite", "name", "unit", "value"])
+        for key in sorted(baseline):
+            w.writerow(list(key) + ["%.2f" % baseline[key]])
+
+
+def main():
+    p = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    p.add_argument("capture", help="serial capture or tool output, - for stdin")
+    p.add_argument("baseline", help="baseline CSV (suite,name,unit,value)")
+    p.add_argument("--tolerance", type=float, default=10.0,
+                   help="allowed slowdown in percent (default 10)")
+    p.add_argument("--update", action="store_true",
+                   help="record new and improved results in the baseline")
+    p.add_argument("--reset", action="store_true",
+                   help="with --update, replace the baseline entirely")
+    args = p.parse_args()
+
+    if args.capture == "-":
+        results = read_results(sys.stdin)
+    else:
+        with open(args.capture, errors="replace") as f:
+            results = read_results(f)
+    if not results:
+        print("no BENCH lines in the capture")
+        return 2
+
+    baseline = read_baseline(args.baseline)
+    if args.update:
+        merged = {} if args.reset else dict(baseline)
+        for key, value in results.items():
+            if key not in merged or value < merged[key]:
+                merged[key] = value
+        write_baseline(args.baseline, merged)
+        print("%d results written to %s" % (len(merged), args.baseline))
+        return 0
+    if not baseline:
+        print("no baseline at %s; record one with --update" % args.baseline)
+        return 2
+
+    regressions = 0
+    for key in sorted(set(results) | set(baseline)):
+        name = "/".join(key[:2])
+        if key not in results:
+            print("  MISSING  %-40s" % name)
+            continue
+        value = results[key]
+        if key not in baseline:
+            print("  NEW      %-40s %10.2f %s" % (name, value, key[2]))
+            continue
+        ref = baseline[key]
+        change = 100.0 * (value - ref) / ref if ref else 0.0
+        bad = change > args.tolerance
+        regressions += bad
+        print("  %-8s %-40s %10.2f %s  baseline %.2f  %+6.1f%%" %
+              ("FAIL" if bad else "ok", name, value, key[2], ref, change))
+    print("%d regressions beyond %.0f%%" % (regressions, args.tolerance))
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,51 @@
+// Host decoder for the PSRAM capture file (include/capture_arena.h,
+// include/psram_capture.h).
+//
+//   g++ -std=c++17 -O2 -Iinclude -o capture_decode tools/capture_decode.cpp
+//   ./capture_decode CAPTURE.BIN > capture.csv
+//
+// One CSV row per record. IMU rows carry the decimation step they were
+// recorded at (1 = every FIFO frame); damaged records are counted on
+// stderr and skipped.
+
+#include "capture_arena.h"
+#include <cinttypes>
+#include <cstdio>
+
+int main(int argc, char **argv) {
+  if (argc != 2) {
+    fprintf(stderr, "usage: %s <capture.bin>\n", argv[0]);
+    return 2;
+  }
+  FILE *in = fopen(argv[1], "rb");
+  if (!in) {
+    perror(argv[1]);
+    return 1;
+  }
+
+  printf("t_us,utc,kind,step,ax,ay,az,gx,gy,gz,pressure,temp\n");
+  uint8_t buf[capture::RECORD_BYTES];
+  capture::Record r;
+  long imu = 0, baro = 0, bad = 0, decimated = 0;
+  while (fread(buf, 1, sizeof(buf), in) == sizeof(buf)) {
+    if (!capture::decodeRecord(buf, r)) {
+      bad++;
+      continue;
+    }
+    if (r.kind == capture::KIND_IMU) {
+      imu++;
+      decimated += r.step > 1;
+      printf("%" PRIu64 ",%d,imu,%u,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,,\n",
+             r.t_us, r.utc, r.step, r.v[0], r.v[1], r.v[2], r.v[3], r.v[4],
+             r.v[5]);
+    } else {
+      baro++;
+      printf("%" PRIu64 ",%d,baro,,,,,,,,%.3f,%.2f\n", r.t_us, r.utc,
+             r.v[0], r.v[1]);
+    }
+  }
+  fclose(in);
+  fprintf(stderr, "%ld imu (%ld decimated), %ld baro, %ld damaged\n", imu,
+          decimated, baro, bad);
+  return 0;
+}
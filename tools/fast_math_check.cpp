@@ -0,0 +1,175 @@
+// Host check of the fast_math kernels (include/fast_math.h): each one swept
+// over its documented input range against the double libm version, and
+// its worst error held to the bound its comment promises.
+//
+//   g++ -std=c++17 -O2 -Iinclude -o fast_math_check tools/fast_math_check.cpp
+//   ./fast_math_check
+//
+// Exits non-zero if any kernel exceeds its bound.
+
+#include "fast_math.h"
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+
+static const int SWEEP = 1 << 20;
+
+static int failures = 0;
+
+static void check(const char *kernel, double worst, double bound,
+                  double at, const char *unit) {
+  bool ok = worst < bound;
+  printf("%-18s %s  max err %.3g %s (bound %.3g) at %.9g\n", kernel,
+         ok ? "ok  " : "FAIL", worst, unit, bound, at);
+  failures += ok ? 0 : 1;
+}
+
+// i-th of n points, log-spaced over [lo, hi]
+static float logPoint(int i, int n, double lo, double hi) {
+  return (float)(lo * pow(hi / lo, (double)i / (n - 1)));
+}
+
+// i-th of n points, evenly spaced over [lo, hi]
+static float linPoint(int i, int n, double lo, double hi) {
+  return (float)(lo + (hi - lo) * i / (n - 1));
+}
+
+static void checkInvSqrt() {
+  double worst = 0.0, at = 0.0;
+  for (int i = 0; i < SWEEP; i++) {
+    float x = logPoint(i, SWEEP, FLT_MIN, FLT_MAX);
+    double err = fabs(fastmath::invSqrt(x) * sqrt((double)x) - 1.0);
+    if (err > worst)
+      worst = err, at = x;
+  }
+  check("invSqrt", worst, 5e-6, at, "rel");
+}
+
+static void checkNorm3() {
+  double worst = 0.0, at = 0.0;
+  for (int i = 0; i < SWEEP; i++) {
+    // a spiral of directions over magnitudes from 1e-6 to 1e6
+    float r = logPoint(i, SWEEP, 1e-6, 1e6);
+    float x = r * sinf(0.37f * i), y = r * cosf(0.37f * i) * sinf(0.11f * i),
+          z = r * cosf(0.11f * i);
+    double n = sqrt((double)x * x + (double)y * y + (double)z * z);
+    double err = fabs(fastmath::norm3(x, y, z) / n - 1.0);
+    if (err > worst)
+      worst = err, at = r;
+  }
+  if (fastmath::norm3(0.0f, 0.0f, 0.0f) != 0.0f)
+    worst = INFINITY;
+  check("norm3", worst, 5e-6, at, "rel");
+}
+
+static void checkAtanUnit() {
+  double worst = 0.0, at = 0.0;
+  for (int i = 0; i < SWEEP; i++) {
+    float z = linPoint(i, SWEEP, -1.0, 1.0);
+    double err = fabs(fastmath::atanUnit(z) - atan((double)z));
+    if (err > worst)
+      worst = err, at = z;
+  }
+  check("atanUnit", worst, 1e-5, at, "rad");
+}
+
+// atan2 over the full circle, heading with it
+static void checkAtan2() {
+  double worst = 0.0, at = 0.0, worstDeg = 0.0, atDeg = 0.0;
+  bool inRange = true;
+  for (int i = 0; i < SWEEP; i++) {
+    double a = -M_PI + 2.0 * M_PI * i / SWEEP;
+    float r = logPoint(i % 1024, 1024, 1e-3, 1e3);
+    float y = (float)(r * sin(a)), x = (float)(r * cos(a));
+    double ref = atan2((double)y, (double)x);
+    double err = fabs(fastmath::atan2Approx(y, x) - ref);
+    err = fmin(err, 2.0 * M_PI - err); // -pi and pi are the same angle
+    if (err > worst)
+      worst = err, at = ref;
+
+    float h = fastmath::headingDeg(y, x);
+    inRange = inRange && h >= 0.0f && h < 360.0f;
+    double hRef = ref * 180.0 / M_PI;
+    hRef = hRef < 0.0 ? hRef + 360.0 : hRef;
+    double errDeg = fabs(h - hRef);
+    errDeg = fmin(errDeg, 360.0 - errDeg);
+    if (errDeg > worstDeg)
+      worstDeg = errDeg, atDeg = hRef;
+  }
+  check("atan2Approx", worst, 1e-5, at, "rad");
+  check("headingDeg", inRange ? worstDeg : INFINITY, 6e-4, atDeg, "deg");
+}
+
+// absolute over [1/2048, 2048), relative to the result beyond it
+static void checkLn() {
+  double worst = 0.0, at = 0.0, worstRel = 0.0, atRel = 0.0;
+  for (int i = 0; i < SWEEP; i++) {
+    float x = logPoint(i, SWEEP, 1.0 / 2048, 2047.99);
+    double err = fabs(fastmath::ln(x) - log((double)x));
+    if (err > worst)
+      worst = err, at = x;
+
+    x = logPoint(i, SWEEP, FLT_MIN, FLT_MAX);
+    if (x >= 1.0f / 2048 && x < 2048.0f)
+      continue;
+    double ref = log((double)x);
+    err = fabs(fastmath::ln(x) - ref) / fmax(1.0, fabs(ref));
+    if (err > worstRel)
+      worstRel = err, atRel = x;
+  }
+  check("ln", worst, 5e-7, at, "abs");
+  check("ln (outer)", worstRel, 2e-7, atRel, "x |ln x|");
+}
+
+static void checkExpm1Small() {
+  double worst = 0.0, at = 0.0;
+  for (int i = 0; i < SWEEP; i++) {
+    float u = linPoint(i, SWEEP, -0.25, 0.25);
+    double err = fabs(fastmath::expm1Small(u) - expm1((double)u));
+    if (err > worst)
+      worst = err, at = u;
+  }
+  check("expm1Small", worst, 5e-8, at, "abs");
+}
+
+static void checkBaroAltitude() {
+  double worst = 0.0, at = 0.0;
+  for (int i = 0; i < SWEEP; i++) {
+    float ratio = linPoint(i, SWEEP, 0.27, 1.1);
+    double ref = 44330.0 * (1.0 - pow((double)ratio, 0.190295));
+    double err = fabs(fastmath::baroAltitudeRatio(ratio) - ref);
+    if (err > worst)
+      worst = err, at = ratio;
+  }
+  check("baroAltitudeRatio", worst, 0.01, at, "m");
+}
+
+// exact: whole billionths rounded half up to 1e-7 degrees, done in 64 bits
+static void checkDegreesE7() {
+  double worst = 0.0, at = 0.0;
+  for (int i = 0; i < SWEEP; i++) {
+    uint16_t deg = (uint16_t)(i % 181);
+    uint32_t billionths = (uint32_t)((i * 2654435761u) % 1000000000u);
+    bool negative = i & 1;
+    int64_t ref = ((int64_t)deg * 1000000000 + billionths + 50) / 100;
+    ref = negative ? -ref : ref;
+    double err =
+        fabs((double)(fastmath::degreesE7(deg, billionths, negative) - ref));
+    if (err > worst)
+      worst = err, at = deg + billionths / 1e9;
+  }
+  check("degreesE7", worst, 0.5, at, "lsb");
+}
+
+int main() {
+  checkInvSqrt();
+  checkNorm3();
+  checkAtanUnit();
+  checkAtan2();
+  checkLn();
+  checkExpm1Small();
+  checkBaroAltitude();
+  checkDegreesE7();
+  printf("%d checks out of bounds\n", failures);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,162 @@
+// Host trajectory simulation for the flight event engine
+// (include/flight_events.h). Simulated flights go through the same filter
+// stage as on the payload, then through the engine. Each scenario checks
+// that the events fire in order and within a tolerance of the true times.
+//
+//   g++ -std=c++17 -O2 -Iinclude -o flight_event_sim tools/flight_event_sim.cpp
+//   ./flight_event_sim
+//
+// Exits non-zero if any scenario fails.
+
+#include "filter_stage.h"
+#include "flight_events.h"
+#include <cstdio>
+#include <random>
+#include <vector>
+
+static const float G = 9.80665f;
+
+struct Scenario {
+  const char *name;
+  uint32_t periodMs;     // sample period
+  float thrust;          // net upward acceleration while burning, m/s^2
+  float burnS;           // burn time
+  float chuteSpeed;      // descent rate under chute, m/s
+  float baroNoise;       // m, 1 sigma
+  bool calibrated;       // ground reference known
+  float padBumpAtS;      // 0.2 s 3 g knock on the pad, <0 for none
+  float baroSpikeAtS;    // -60 m glitch for two samples in coast, <0 none
+};
+
+struct Truth {
+  float launch, burnout, apogee, landing;
+};
+
+// event times from the engine, -1 if it never fired
+struct Seen {
+  float t[5] = {-1, -1, -1, -1, -1};
+  std::vector<FlightEvent> order;
+};
+
+static Truth fly(const Scenario &sc, Seen &seen) {
+  std::mt19937 rng(1234);
+  std::normal_distribution<float> baro(0.0f, sc.baroNoise);
+  std::normal_distribution<float> imu(0.0f, 0.02f);
+
+  TelemetryFilterStage stage;
+  FlightEventEngine engine;
+  const float groundMsl = 300.0f;
+  if (sc.calibrated)
+    engine.setGround(groundMsl);
+
+  const float padS = 5.0f;
+  Truth truth = {padS, padS + sc.burnS, 0, 0};
+  float h = 0, v = 0;
+  bool chute = false, landed = false;
+  const float dt = sc.periodMs * 0.001f;
+
+  for (uint32_t ms = 0; ms < 400000; ms += sc.periodMs) {
+    float t = ms * 0.001f;
+    // truth: vertical only; specific force is what the IMU reads
+    float a, force;
+    if (t < padS || landed) {
+      a = 0;
+      force = G;
+    } else if (t < truth.burnout) {
+      a = sc.thrust;
+      force = sc.thrust + G;
+    } else if (!chute) {
+      a = -G; // ballistic, no drag
+      force = 0;
+      if (v + a * dt < 0) {
+        chute = true;
+        truth.apogee = t;
+      }
+    } else {
+      // chute snaps to its descent rate
+      a = v > -sc.chuteSpeed ? -G : 0;
+      force = a == 0 ? G : 0;
+    }
+    if (!landed) {
+      v += a * dt;
+      if (chute && v < -sc.chuteSpeed)
+        v = -sc.chuteSpeed;
+      h += v * dt;
+      if (t > padS && h <= 0) {
+        h = 0;
+        v = 0;
+        landed = true;
+        truth.landing = t;
+      }
+    }
+
+    TelemetrySample s = TelemetrySample();
+    s.baro_us = s.imu_us = s.env_us = (uint64_t)ms * 1000;
+    s.altitude = groundMsl + h + baro(rng);
+    if (sc.baroSpikeAtS > 0 && t >= sc.baroSpikeAtS &&
+        t < sc.baroSpikeAtS + 2 * dt)
+      s.altitude -= 60.0f;
+    float reading = force / G;
+    if (sc.padBumpAtS > 0 && t >= sc.padBumpAtS && t < sc.padBumpAtS + 0.2f)
+      reading = 3.0f;
+    // MPU6050 at +-16 g once the FIFO runs (mpu6050_driver.h)
+    s.az = reading > 16.0f ? 16.0f : reading;
+    s.ax = imu(rng);
+    s.ay = imu(rng);
+    s.az += imu(rng);
+    s.pressure = 1000.0f;
+    stage.push(s);
+
+    FlightEvent e = engine.update(ms, s.baro_us, stage.altitude(),
+                                  stage.accelMag());
+    if (e != EVENT_NONE) {
+      seen.t[e] = t;
+      seen.order.push_back(e);
+    }
+    if (landed && t > truth.landing + 30.0f)
+      break;
+  }
+  return truth;
+}
+
+static bool within(float seen, float truth, float early, float late) {
+  return seen >= 0 && seen >= truth - early && seen <= truth + late;
+}
+
+int main() {
+  const Scenario scenarios[] = {
+      {"nominal 10 Hz", 100, 40.0f, 2.5f, 6.0f, 0.3f, true, -1, -1},
+      {"nominal 5 Hz", 200, 40.0f, 2.5f, 6.0f, 0.3f, true, -1, -1},
+      {"uncalibrated", 100, 40.0f, 2.5f, 6.0f, 0.3f, false, -1, -1},
+      {"noisy baro", 100, 40.0f, 2.5f, 6.0f, 1.5f, true, -1, -1},
+      {"pad bump", 100, 40.0f, 2.5f, 6.0f, 0.3f, true, 2.0f, -1},
+      {"coast baro spike", 100, 40.0f, 2.5f, 6.0f, 0.3f, true, -1, 6.0f},
+      {"long burn", 100, 20.0f, 6.0f, 8.0f, 0.3f, true, -1, -1},
+      // under 2 m/s all the way down: landing waits for the ground
+      {"slow descent", 100, 30.0f, 2.5f, 1.5f, 0.3f, true, -1, -1},
+      {"slow, uncalibrated", 100, 30.0f, 2.5f, 1.5f, 0.3f, false, -1, -1},
+      {"slow, noisy baro", 100, 30.0f, 2.5f, 1.5f, 1.5f, true, -1, -1},
+  };
+
+  int failures = 0;
+  for (const Scenario &sc : scenarios) {
+    Seen seen;
+    Truth truth = fly(sc, seen);
+    const std::vector<FlightEvent> expected = {EVENT_LAUNCH, EVENT_BURNOUT,
+                                               EVENT_APOGEE, EVENT_LANDING};
+    // filters and debounce cost a few samples on every event
+    const float lag = 6 * sc.periodMs * 0.001f;
+    bool ok = seen.order == expected &&
+              within(seen.t[EVENT_LAUNCH], truth.launch, 0.0f, lag) &&
+              within(seen.t[EVENT_BURNOUT], truth.burnout, 0.0f, lag) &&
+              within(seen.t[EVENT_APOGEE], truth.apogee, 1.0f, 1.0f + lag) &&
+              within(seen.t[EVENT_LANDING], truth.landing, 0.0f, 4.0f + lag);
+    printf("%-18s %s  launch %.1f/%.1f  burnout %.1f/%.1f  apogee %.1f/%.1f"
+           "  landing %.1f/%.1f s\n",
+           sc.name, ok ? "ok  " : "FAIL", seen.t[EVENT_LAUNCH], truth.launch,
+           seen.t[EVENT_BURNOUT], truth.burnout, seen.t[EVENT_APOGEE],
+           truth.apogee, seen.t[EVENT_LANDING], truth.landing);
+    failures += ok ? 0 : 1;
+  }
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,14 @@
+// Host run of the hot-path microbenchmarks (include/hot_path_benchmark.h),
+// the same loops the esp32dev_bench env runs on target, timed in host
+// nanoseconds. Pipe the output to tools/bench_compare.py to check it
+// against a stored baseline.
+//
+//   g++ -std=c++17 -O2 -Iinclude -o hot_path_bench tools/hot_path_bench.cpp
+//   ./hot_path_bench | python3 tools/bench_compare.py - test/baselines/native.csv
+
+#include "hot_path_benchmark.h"
+
+int main() {
+  runHotPathBenchmark();
+  return 0;
+}
@@ -0,0 +1,117 @@
+#!/usr/bin/env python3
+"""Decode tokenized debug log frames (include/debug_log.h, binary mode).
+
+Each frame carries the address of its format string instead of the text;
+the strings are looked up in the firmware ELF that produced the capture.
+
+    python3 tools/log_decode.py .pio/build/esp32dev/firmware.elf capture.bin
+    cat /dev/ttyUSB0 | python3 tools/log_decode.py firmware.elf -
+"""
+
+import re
+import struct
+import sys
+
+SYNC = b"\xa5\x5a"
+LEVELS = "-EWID"
+ARG_INT, ARG_UINT, ARG_FLOAT, ARG_STRING = range(4)
+SPEC = re.compile(r"%([-+ #0-9.]*)[hlLqjzt]*([diouxXcsfFeEgGaA%])")
+
+
+class Elf32:
+    """Just enough ELF32 to read C strings from allocated sections."""
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            self.data = f.read()
+        if self.data[:4] != b"\x7fELF" or self.data[4] != 1:
+            raise ValueError(f"{path}: not an ELF32 file")
+        shoff, = struct.unpack_from("<I", self.data, 0x20)
+        shentsize, shnum = struct.unpack_from("<HH", self.data, 0x2E)
+        self.sections = []
+        for i in range(shnum):
+            (_, sh_type, flags, addr, offset, size) = struct.unpack_from(
+                "<IIIIII", self.data, shoff + i * shentsize)
+            if sh_type == 1 and flags & 0x2 and size:  # PROGBITS, ALLOC
+                self.sections.append((addr, offset, size))
+
+    def string_at(self, addr):
+        for base, offset, size in self.sections:
+            if base <= addr < base + size:
+                start = offset + addr - base
+                end = self.data.index(b"\0", start)
+                return self.data[start:end].decode("utf-8", "replace")
+        return None
+
+
+def format_entry(fmt, args, string):
+    it = iter(args)
+
+    def repl(m):
+        flags, conv = m.groups()
+        if conv == "%":
+            return "%"
+        try:
+            kind, raw = next(it)
+        except StopIteration:
+            return "?"
+        if kind == ARG_FLOAT:
+            value = struct.unpack("<f", struct.pack("<I", raw))[0]
+        elif kind == ARG_INT:
+            value = raw - (1 << 32) if raw & 0x80000000 else raw
+        elif kind == ARG_STRING:
+            value = string
+        else:
+            value = raw
+        if conv == "s":
+            value = str(value)
+        elif conv in "diouxXc":
+            value = int(value)
+            conv = "d" if conv in "iu" else conv
+        return ("%" + flags + conv) % value
+
+    return SPEC.sub(repl, fmt)
+
+
+def decode(elf, stream):
+    buf = stream.read()
+    i = 0
+    while True:
+        i = buf.find(SYNC, i)
+        if i < 0 or i + 3 > len(buf):
+            return
+        length = buf[i + 2]
+        frame = buf[i + 3:i + 3 + length]
+        if len(frame) < length or i + 3 + length >= len(buf):
+            return
+        if sum(frame) & 0xFF != buf[i + 3 + length] or length < 11:
+            i += 1  # not a frame boundary, resync
+            continue
+        addr, ts, level, nargs, types = struct.unpack_from("<IIBBB", frame)
+        raw = struct.unpack_from("<%dI" % nargs, frame, 11)
+        kinds = [(types >> (2 * k)) & 3 for k in range(nargs)]
+        rest = frame[11 + 4 * nargs:]
+        string = rest.split(b"\0")[0].decode("utf-8", "replace")
+        fmt = elf.string_at(addr)
+        if fmt is None:
+            text = "<unknown format 0x%08x> %r" % (addr, raw)
+        else:
+            text = format_entry(fmt, list(zip(kinds, raw)), string)
+        lvl = LEVELS[level] if level < len(LEVELS) else "?"
+        print("[%10.6f] %s %s" % (ts * 1e-6, lvl, text))
+        i += 4 + length
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.exit("usage: log_decode.py <firmware.elf> <capture.bin | ->")
+    elf = Elf32(sys.argv[1])
+    if sys.argv[2] == "-":
+        decode(elf, sys.stdin.buffer)
+    else:
+        with open(sys.argv[2], "rb") as f:
+            decode(elf, f)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,80 @@
+// Host exporter for the raw-sector flight log (include/raw_log_format.h).
+// Reads the card (or an image of it), finds the raw log partition and
+// writes its blocks to a file in the same format as /flight_log.bin, ready
+// for flight_log_decode.
+//
+//   g++ -std=c++17 -O2 -Iinclude -o raw_log_export tools/raw_log_export.cpp
+//   sudo ./raw_log_export /dev/sdX flight_log.bin
+
+#include "raw_log_format.h"
+#include <cinttypes>
+#include <cstdio>
+
+static bool readSector(FILE *dev, uint64_t lba, uint8_t *buf) {
+  if (fseeko(dev, (off_t)(lba * rawlog::SECTOR_BYTES), SEEK_SET) != 0)
+    return false;
+  return fread(buf, 1, rawlog::SECTOR_BYTES, dev) == rawlog::SECTOR_BYTES;
+}
+
+int main(int argc, char **argv) {
+  if (argc != 3) {
+    fprintf(stderr, "usage: %s <device or image> <out.bin>\n", argv[0]);
+    return 2;
+  }
+  FILE *dev = fopen(argv[1], "rb");
+  if (!dev) {
+    perror(argv[1]);
+    return 1;
+  }
+
+  uint8_t sector[rawlog::SECTOR_BYTES];
+  uint32_t start, sectors;
+  if (!readSector(dev, 0, sector) ||
+      !rawlog::findPartition(sector, start, sectors)) {
+    fprintf(stderr, "no raw log partition (type 0x%02X) found\n",
+            rawlog::PARTITION_TYPE);
+    return 1;
+  }
+
+  rawlog::Superblock sb;
+  if (!readSector(dev, start, sector) ||
+      !rawlog::decodeSuperblock(sector, sb)) {
+    fprintf(stderr, "partition at LBA %" PRIu32 " has no valid superblock\n",
+            start);
+    return 1;
+  }
+  fprintf(stderr, "region LBA %" PRIu32 ", %" PRIu32 " sectors, cursor %" PRIu32
+                  ", %" PRIu32 " sessions\n",
+          sb.regionStart, sb.regionSectors, sb.cursor, sb.sessions);
+
+  FILE *out = fopen(argv[2], "wb");
+  if (!out) {
+    perror(argv[2]);
+    return 1;
+  }
+
+  // everything below the cursor, then anything written after the last
+  // superblock update that still continues the block sequence
+  uint32_t written = 0, skipped = 0, seq = 0, expected = 0;
+  bool haveSeq = false;
+  for (uint32_t i = 0; i < sb.regionSectors - 1; i++) {
+    if (!readSector(dev, (uint64_t)sb.regionStart + 1 + i, sector))
+      break;
+    bool valid = logcodec::isValidBlock(sector, &seq);
+    if (i >= sb.cursor && (!valid || !haveSeq || seq != expected))
+      break;
+    if (!valid) {
+      skipped++;
+      continue;
+    }
+    fwrite(sector, 1, sizeof(sector), out);
+    written++;
+    expected = seq + 1;
+    haveSeq = true;
+  }
+  fclose(out);
+  fclose(dev);
+  fprintf(stderr, "%" PRIu32 " blocks exported, %" PRIu32 " invalid skipped\n",
+          written, skipped);
+  return 0;
+}
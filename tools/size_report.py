@@ -0,0 +1,152 @@
+#!/usr/bin/env python3
+"""Flash and RAM per module, from the linker map.
+
+Run by PlatformIO after every link (extra_scripts in platformio.ini), which
+also asks the linker for the map; the table is printed and written next to
+the firmware as size_report.csv, so two builds can be diffed. By hand:
+
+    python3 tools/size_report.py .pio/build/esp32dev/firmware.map
+    python3 tools/size_report.py firmware.map --objects   # split archives
+
+A module is a source file of ours or a library archive. Flash counts what
+is stored in the image (code, constants, initialised data, IRAM code);
+IRAM and DRAM count what is resident in internal RAM. Heap and task stacks
+are only known at run time, see include/memory_monitor.h.
+"""
+
+import os
+import re
+import sys
+from collections import defaultdict
+
+# output section prefix: (region, stored in flash image); first match wins
+REGIONS = [
+    (".iram0", "iram", True),
+    (".dram0.bss", "dram", False),
+    (".dram0.data", "dram", True),
+    (".noinit", "dram", False),
+    (".flash", "flash", True),
+    (".rtc_noinit", "rtc", False),
+    (".rtc.bss", "rtc", False),
+    (".rtc", "rtc", True),
+    (".ext_ram", "psram", False),
+]
+COLUMNS = ["flash", "iram", "dram", "rtc", "psram"]
+
+OUTPUT = re.compile(r"^(\.\S+)")
+INPUT = re.compile(r"^ (\S+)(?:\s+0x([0-9a-f]+)\s+0x([0-9a-f]+)\s+(.+))?$")
+WRAPPED = re.compile(r"^\s+0x([0-9a-f]+)\s+0x([0-9a-f]+)\s+(.+)$")
+ARCHIVE = re.compile(r"(?:.*/)?lib([^/]+)\.a\((.+)\)$")
+
+
+def module_of(path, objects):
+    m = ARCHIVE.match(path)
+    if m:
+        return m.group(1) + (":" + m.group(2) if objects else "")
+    path = path.replace("\\", "/")
+    if "/src/" in path:
+        return "src/" + re.sub(r"\.o(bj)?$", "", path.split("/src/")[-1])
+    return os.path.basename(path)
+
+
+def region_of(section):
+    if "noload" in section:
+        return None
+    for prefix, region, stored in REGIONS:
+        if section.startswith(prefix):
+            return region, stored
+    return None
+
+
+def parse(path, objects=False):
+    sizes = defaultdict(lambda: defaultdict(int))
+    region = None
+    pending = None
+    in_map = False
+    with open(path, errors="replace") as f:
+        for line in f:
+            line = line.rstrip("\n")
+            if not in_map:
+                in_map = line.startswith("Linker script and memory map")
+                continue
+            m = OUTPUT.match(line)
+            if m:
+                region = region_of(m.group(1))
+                pending = None
+                continue
+            if region is None:
+                continue
+            if pending:
+                w = WRAPPED.match(line)
+                pending = None
+                if w:
+                    add(sizes, region, int(w.group(2), 16), w.group(3), objects)
+                    continue
+            m = INPUT.match(line)
+            if not m or m.group(1).startswith("*"):
+                continue
+            if m.group(2) is None:
+                pending = m.group(1)  # long name, numbers on the next line
+                continue
+            add(sizes, region, int(m.group(3), 16), m.group(4), objects)
+    return sizes
+
+
+def add(sizes, region, size, path, objects):
+    if not size:
+        return
+    name, stored = region
+    module = module_of(path.strip(), objects)
+    if name != "flash":
+        sizes[module][name] += size
+    if stored:
+        sizes[module]["flash"] += size
+
+
+def report(sizes, out=sys.stdout, csv_path=None):
+    rows = sorted(sizes.items(), key=lambda kv: -kv[1]["flash"])
+    width = max([len(k) for k, _ in rows] + [6])
+    out.write("%-*s" % (width, "module") +
+              "".join("%10s" % c for c in COLUMNS) + "\n")
+    totals = defaultdict(int)
+    for module, cols in rows:
+        out.write("%-*s" % (width, module) +
+                  "".join("%10d" % cols[c] for c in COLUMNS) + "\n")
+        for c in COLUMNS:
+            totals[c] += cols[c]
+    out.write("%-*s" % (width, "total") +
+              "".join("%10d" % totals[c] for c in COLUMNS) + "\n")
+    if csv_path:
+        with open(csv_path, "w") as f:
+            f.write("module," + ",".join(COLUMNS) + "\n")
+            for module, cols in rows:
+                f.write(module + "," +
+                        ",".join(str(cols[c]) for c in COLUMNS) + "\n")
+
+
+def main():
+    args = [a for a in sys.argv[1:] if not a.startswith("--")]
+    if len(args) != 1:
+        sys.exit("usage: size_report.py <firmware.map> [--objects]")
+    report(parse(args[0], "--objects" in sys.argv))
+
+
+try:
+    Import("env")  # noqa: F821 (PlatformIO SCons)
+except NameError:
+    env = None
+
+if env is not None:
+    MAP = os.path.join("$BUILD_DIR", "${PROGNAME}.map")
+    env.Append(LINKFLAGS=["-Wl,-Map," + MAP])
+
+    def after_link(source, target, env):
+        map_path = env.subst(MAP)
+        print("Size by module (bytes):")
+        report(parse(map_path),
+               csv_path=os.path.join(env.subst("$BUILD_DIR"),
+                                     "size_report.csv"))
+
+    env.AddPostAction("$BUILD_DIR/${PROGNAME}.elf", after_link)
+elif __name__ == "__main__":
+    main()
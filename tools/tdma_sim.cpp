@@ -0,0 +1,197 @@
+// Host simulation of several payloads sharing one LoRa frequency. Each
+// node runs the firmware's send decision (duty-cycle pacing, and in TDMA
+// modes TdmaSchedule from include/tdma_schedule.h) on its own drifting
+// clock with loop jitter; every frame goes onto one shared channel, and
+// frames that overlap on air are lost at the ground station.
+//
+//   g++ -std=c++17 -O2 -Iinclude -o tdma_sim tools/tdma_sim.cpp
+//   ./tdma_sim
+//
+// Modes:
+//   aloha   no slots, send whenever the duty cycle allows (the old way)
+//   none    TDMA but no time source: random access once per superframe
+//   beacon  TDMA slots, clocks corrected by ground time syncs sent back
+//           after a received frame
+//   gps     TDMA slots on GPS time
+//
+// Exits non-zero if GPS-timed TDMA loses any frame, or if ground-synced
+// TDMA doesn't beat unslotted sending on collisions and throughput.
+
+#include "loopback_radio.h"
+#include "tdma_schedule.h"
+#include <algorithm>
+#include <cstdio>
+#include <queue>
+#include <random>
+#include <vector>
+
+enum Mode { MODE_ALOHA, MODE_NONE, MODE_BEACON, MODE_GPS };
+static const char *const MODE_NAMES[] = {"aloha", "none", "beacon", "gps"};
+
+static const size_t FRAME_BYTES = 64;           // DOWNLINK_MAX_FRAME
+static const size_t COMMAND_BYTES = 31;         // uplink::MAX_COMMAND_BYTES
+static const float DUTY_CYCLE = 0.25f;          // DOWNLINK_DUTY_CYCLE
+static const int64_t LOOP_PERIOD_US = 100000;   // default sample period
+static const int64_t SIM_US = 600LL * 1000000;  // ten minutes
+static const int64_t SYNC_INTERVAL_US = 10000000; // ground resyncs a node
+
+struct Transmission {
+  int node;
+  int64_t start, end; // true time
+  bool lost;
+};
+
+struct Node {
+  double ppm;       // crystal error
+  int64_t offsetUs; // local clock at true time zero (boot phase)
+  int64_t nextFrameLocalUs;
+  int64_t lastSyncUs;
+  TdmaSchedule tdma;
+  Node(uint8_t id, uint8_t slots) : tdma(id, slots) {}
+
+  int64_t local(int64_t trueUs) const {
+    return offsetUs + (int64_t)(trueUs * (1.0 + ppm * 1e-6));
+  }
+  int64_t trueSpan(int64_t localSpan) const {
+    return (int64_t)(localSpan / (1.0 + ppm * 1e-6));
+  }
+};
+
+struct Event {
+  int64_t t;
+  int node;
+  int tx; // -1: loop pass, else ground sync after that transmission
+  bool operator>(const Event &o) const { return t > o.t; }
+};
+
+struct Result {
+  long sent = 0, lost = 0;
+  double throughputBps = 0;
+  long minDelivered = 0;
+};
+
+static Result run(Mode mode, int nodes, unsigned seed) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<double> uni(0.0, 1.0);
+  LoopbackRadio phy; // only for its airtime figures
+  const uint32_t frameAir = phy.airtimeUs(FRAME_BYTES);
+
+  std::vector<Node> node;
+  for (int i = 0; i < nodes; i++) {
+    node.emplace_back((uint8_t)i, mode == MODE_ALOHA ? 0 : (uint8_t)nodes);
+    Node &n = node.back();
+    n.ppm = -20.0 + 40.0 * uni(rng);
+    n.offsetUs = (int64_t)(uni(rng) * 3600e6); // boot time differs
+    n.nextFrameLocalUs = 0;
+    n.lastSyncUs = -SYNC_INTERVAL_US;
+    n.tdma.configure(frameAir, phy.airtimeUs(COMMAND_BYTES));
+  }
+
+  std::vector<Transmission> txs;
+  std::priority_queue<Event, std::vector<Event>, std::greater<Event>> events;
+  for (int i = 0; i < nodes; i++)
+    events.push({(int64_t)(uni(rng) * LOOP_PERIOD_US), i, -1});
+
+  while (!events.empty()) {
+    Event e = events.top();
+    events.pop();
+    if (e.t > SIM_US)
+      break;
+    Node &n = node[e.node];
+
+    if (e.tx >= 0) {
+      // frames that could overlap this one all started before it ended,
+      // so they are in txs by now
+      const Transmission &t = txs[e.tx];
+      bool heard = true;
+      for (const Transmission &o : txs)
+        if (&o != &t && o.start < t.end && o.end > t.start)
+          heard = false;
+      if (heard && e.t - n.lastSyncUs >= SYNC_INTERVAL_US) {
+        // the node timestamps the sync with ~BEACON_ERROR_US of error
+        double err = (uni(rng) - 0.5) * TdmaSchedule::BEACON_ERROR_US;
+        n.tdma.beaconReceived(n.local(e.t), (uint64_t)(e.t + err));
+        n.lastSyncUs = e.t;
+      }
+      continue;
+    }
+
+    // one loop pass: sensor reads take a while before the radio is served
+    int64_t txTrue = e.t + (int64_t)(5000 + 20000 * uni(rng));
+    int64_t localNow = n.local(txTrue);
+    bool gps = mode == MODE_GPS;
+    uint64_t gpsUs = (uint64_t)(txTrue + (uni(rng) - 0.5) * 100);
+    uint64_t net = n.tdma.networkUs(localNow, gps, gpsUs);
+    bool synced = n.tdma.isSynced(localNow, gps);
+    if (localNow >= n.nextFrameLocalUs && n.tdma.mayTransmit(net, synced)) {
+      txs.push_back({e.node, txTrue, txTrue + frameAir, false});
+      n.tdma.transmitted(net);
+      n.nextFrameLocalUs =
+          localNow + (int64_t)(frameAir / DUTY_CYCLE); // frameSent()
+      if (mode == MODE_BEACON)
+        events.push({txTrue + frameAir + (int64_t)TdmaSchedule::TURNAROUND_US,
+                     e.node, (int)txs.size() - 1});
+    }
+
+    // stateMachineSamplePeriodMs(): wake early for the next window
+    int64_t delayLocal = LOOP_PERIOD_US;
+    if (n.tdma.enabled())
+      delayLocal =
+          std::min<int64_t>(delayLocal, n.tdma.usUntilWindow(net, synced));
+    events.push({txTrue + n.trueSpan(delayLocal), e.node, -1});
+  }
+
+  std::sort(txs.begin(), txs.end(),
+            [](const Transmission &a, const Transmission &b) {
+              return a.start < b.start;
+            });
+  for (size_t i = 0; i < txs.size(); i++)
+    for (size_t j = i + 1; j < txs.size() && txs[j].start < txs[i].end; j++)
+      txs[i].lost = txs[j].lost = true;
+
+  Result r;
+  std::vector<long> delivered(nodes, 0);
+  for (const Transmission &t : txs) {
+    r.sent++;
+    if (t.lost)
+      r.lost++;
+    else
+      delivered[t.node]++;
+  }
+  long total = r.sent - r.lost;
+  r.throughputBps = total * FRAME_BYTES * 8.0 / (SIM_US / 1e6);
+  r.minDelivered = *std::min_element(delivered.begin(), delivered.end());
+  return r;
+}
+
+int main() {
+  int failures = 0;
+  printf("%-6s %5s %8s %8s %10s %12s %14s\n", "mode", "nodes", "sent",
+         "lost", "collision", "goodput", "worst node");
+  for (int nodes : {2, 4, 8}) {
+    Result res[4];
+    for (int m = MODE_ALOHA; m <= MODE_GPS; m++) {
+      res[m] = run((Mode)m, nodes, 1000 + nodes);
+      const Result &r = res[m];
+      printf("%-6s %5d %8ld %8ld %9.1f%% %8.0f bps %8ld frames\n",
+             MODE_NAMES[m], nodes, r.sent, r.lost,
+             r.sent ? 100.0 * r.lost / r.sent : 0.0, r.throughputBps,
+             r.minDelivered);
+    }
+    if (res[MODE_GPS].lost != 0) {
+      printf("  FAIL: gps-timed slots collided\n");
+      failures++;
+    }
+    double alohaRate = (double)res[MODE_ALOHA].lost / res[MODE_ALOHA].sent;
+    double beaconRate =
+        (double)res[MODE_BEACON].lost / res[MODE_BEACON].sent;
+    if (nodes >= 4 && (beaconRate >= alohaRate ||
+                       res[MODE_BEACON].throughputBps <=
+                           res[MODE_ALOHA].throughputBps)) {
+      printf("  FAIL: ground-synced slots no better than unslotted\n");
+      failures++;
+    }
+    printf("\n");
+  }
+  return failures ? 1 : 0;
+}
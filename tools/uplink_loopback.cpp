@@ -0,0 +1,208 @@
+// Host run of the full command uplink cycle over LoopbackRadio: the
+// ground signs commands and sends them inside the payload's receive
+// window, the payload authenticates and dispatches them, and the acks
+// (and a resent log block) come back in downlink frames that the ground
+// decodes.
+//
+//   g++ -std=c++17 -O2 -Iinclude -o uplink_loopback tools/uplink_loopback.cpp
+//   ./uplink_loopback
+//
+// Exits non-zero if any expected ack is missing or wrong, or if a forged
+// or replayed command gets through.
+
+#include "command_dispatcher.h"
+#include "downlink_scheduler.h"
+#include "loopback_radio.h"
+#include "uplink_protocol.h"
+#include "uplink_window.h"
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <vector>
+
+// test key only; flight builds take theirs from -DUPLINK_KEY
+static const uint8_t KEY[uplink::KEY_BYTES] = {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+    0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f};
+
+// payload side state touched by the handlers
+static DownlinkScheduler *payloadDownlink = nullptr;
+static uint8_t logLevel = 3;
+static uint8_t testBlock[DownlinkScheduler::RESEND_BLOCK_BYTES];
+
+static uint8_t onPing(const uplink::Command &) { return uplink::ACK_OK; }
+
+static uint8_t onSetLogLevel(const uplink::Command &cmd) {
+  if (cmd.argLen != 1 || cmd.args[0] > 4)
+    return uplink::ACK_BAD_ARGS;
+  logLevel = cmd.args[0];
+  return uplink::ACK_OK;
+}
+
+static uint8_t onResendLog(const uplink::Command &cmd) {
+  if (cmd.argLen != 5)
+    return uplink::ACK_BAD_ARGS;
+  // stands in for the flight logger reading the block back from SD
+  return payloadDownlink->resendBlock(uplink::get32(cmd.args), testBlock)
+             ? uplink::ACK_OK
+             : uplink::ACK_BUSY;
+}
+
+struct Ack {
+  uint32_t counter;
+  uint8_t opcode, status;
+};
+
+struct GroundView {
+  std::vector<Ack> acks;
+  std::vector<uint8_t> block;
+  uint32_t blockIndex = 0;
+  long frames = 0;
+};
+
+// walk a downlink frame, keeping acks and log chunks
+static bool decodeFrame(const uint8_t *f, size_t len, GroundView &g) {
+  static const uint8_t periodic[MSG_TYPE_COUNT] = {9, 8, 14, 6, 14, 16};
+  if (len < DownlinkScheduler::FRAME_HEADER_BYTES ||
+      f[0] != DownlinkScheduler::FRAME_MAGIC)
+    return false;
+  g.frames++;
+  size_t p = DownlinkScheduler::FRAME_HEADER_BYTES;
+  while (p + DownlinkScheduler::MSG_HEADER_BYTES <= len) {
+    uint8_t type = f[p];
+    const uint8_t *m = f + p + DownlinkScheduler::MSG_HEADER_BYTES;
+    size_t n;
+    if (type < MSG_TYPE_COUNT) {
+      n = periodic[type];
+    } else if (type == MSG_ACK) {
+      n = DownlinkScheduler::ACK_PAYLOAD_BYTES;
+      g.acks.push_back({uplink::get32(m), m[4], m[5]});
+    } else if (type == MSG_LOG_CHUNK) {
+      n = DownlinkScheduler::CHUNK_HEADER_BYTES + m[6];
+      g.blockIndex = uplink::get32(m);
+      if (uplink::get16(m + 4) == g.block.size())
+        g.block.insert(g.block.end(), m + 7, m + 7 + m[6]);
+    } else {
+      return false;
+    }
+    p += DownlinkScheduler::MSG_HEADER_BYTES + n;
+  }
+  return p == len;
+}
+
+int main() {
+  for (size_t i = 0; i < sizeof(testBlock); i++)
+    testBlock[i] = (uint8_t)(i * 7 + 3);
+
+  LoopbackRadio payloadRadio, groundRadio;
+  payloadRadio.link(groundRadio);
+
+  DownlinkScheduler downlink(64, 0.25f);
+  payloadDownlink = &downlink;
+  CommandDispatcher dispatcher(KEY);
+  dispatcher.on(uplink::CMD_PING, onPing);
+  dispatcher.on(uplink::CMD_SET_LOG_LEVEL, onSetLogLevel);
+  dispatcher.on(uplink::CMD_RESEND_LOG, onResendLog);
+  UplinkWindow<LoopbackRadio> window(payloadRadio, 250);
+
+  // ground script: one packet per receive window
+  struct Step {
+    const char *what;
+    uint32_t counter;
+    uint8_t opcode;
+    std::vector<uint8_t> args;
+    bool forge;
+    int expectStatus; // -1: must not be acked
+  };
+  std::vector<Step> script = {
+      {"ping", 1, uplink::CMD_PING, {}, false, uplink::ACK_OK},
+      {"set log level 4", 2, uplink::CMD_SET_LOG_LEVEL, {4}, false,
+       uplink::ACK_OK},
+      {"bad log level", 3, uplink::CMD_SET_LOG_LEVEL, {9}, false,
+       uplink::ACK_BAD_ARGS},
+      {"forged tag", 4, uplink::CMD_PING, {}, true, -1},
+      {"replayed counter", 2, uplink::CMD_PING, {}, false, -1},
+      {"unknown opcode", 5, uplink::CMD_SET_SAMPLE_PERIOD, {100, 0}, false,
+       uplink::ACK_UNKNOWN_OPCODE},
+      {"resend block 42", 6, uplink::CMD_RESEND_LOG, {42, 0, 0, 0, 1}, false,
+       uplink::ACK_OK},
+  };
+
+  TelemetrySample s = TelemetrySample();
+  DownlinkHealth health = DownlinkHealth();
+  GroundView ground;
+  size_t next = 0;
+  uint8_t frame[LoopbackRadio::MAX_PAYLOAD];
+  uint8_t rx[LoopbackRadio::MAX_PAYLOAD];
+
+  for (uint32_t now = 0; now < 60000; now += 10) {
+    // payload loop
+    s.baro_us = s.imu_us = s.env_us = s.gps_us = (uint64_t)now * 1000;
+    downlink.observe(s, 100.0f);
+    downlink.observeDownlink(s);
+    downlink.observeHealth(health);
+    window.poll(now, dispatcher, downlink);
+    if (!window.isOpen() && downlink.canSend(now)) {
+      size_t len = downlink.buildFrame(POSTLAND, now, (uint64_t)now * 1000,
+                                       frame);
+      if (len) {
+        groundRadio.startReceive();
+        payloadRadio.sendPacket(frame, len);
+        downlink.frameSent(now, payloadRadio.airtimeUs(len));
+        window.afterTransmit(now);
+      }
+    }
+
+    // ground: answer each frame with the next scripted command
+    int len = groundRadio.receivePacket(rx, sizeof(rx));
+    if (len > 0) {
+      if (!decodeFrame(rx, (size_t)len, ground)) {
+        fprintf(stderr, "t=%" PRIu32 " ms: undecodable frame\n", now);
+        return 1;
+      }
+      if (next < script.size()) {
+        const Step &st = script[next++];
+        uint8_t cmd[uplink::MAX_COMMAND_BYTES];
+        size_t n = uplink::encodeCommand(KEY, st.counter, st.opcode,
+                                         st.args.data(), st.args.size(), cmd);
+        if (st.forge)
+          cmd[n - 1] ^= 0x01;
+        groundRadio.sendPacket(cmd, n);
+      }
+    }
+  }
+
+  int failures = 0;
+  for (const Step &st : script) {
+    const Ack *found = nullptr;
+    for (const Ack &a : ground.acks)
+      if (a.counter == st.counter && a.opcode == st.opcode)
+        found = &a;
+    bool ok = st.expectStatus < 0 ? found == nullptr
+                                  : found && found->status == st.expectStatus;
+    printf("%-18s %s", st.what, ok ? "ok" : "FAIL");
+    if (found)
+      printf("  (ack status %u)", found->status);
+    printf("\n");
+    failures += ok ? 0 : 1;
+  }
+
+  bool blockOk = ground.blockIndex == 42 &&
+                 ground.block.size() == sizeof(testBlock) &&
+                 std::equal(ground.block.begin(), ground.block.end(),
+                            testBlock);
+  printf("%-18s %s  (%zu bytes)\n", "resent block", blockOk ? "ok" : "FAIL",
+         ground.block.size());
+  failures += blockOk ? 0 : 1;
+  if (logLevel != 4) {
+    printf("log level not applied\n");
+    failures++;
+  }
+
+  printf("%ld frames, %" PRIu32 " accepted, %" PRIu32 " bad tag, %" PRIu32
+         " replayed, %" PRIu32 " packets lost\n",
+         ground.frames, dispatcher.acceptedCount(),
+         dispatcher.rejectedAuthCount(), dispatcher.rejectedReplayCount(),
+         payloadRadio.packetsLost() + groundRadio.packetsLost());
+  return failures ? 1 : 0;
+}